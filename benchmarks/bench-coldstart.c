@@ -0,0 +1,185 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | bench-coldstart.c                                             |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *
+ * Cold start benchmark: the release build of plainstarter, which imports
+ * kernel32.dll only, and the build with PLAINSTARTER_STATIC_IMPORTS, which
+ * also imports user32.dll, shell32.dll, comctl32.dll and shlwapi.dll, are
+ * started alternately. The time from CreateProcess to the exit of
+ * plainstarter is measured, the child process exits immediately.
+ *
+ *   bench-coldstart.exe <runs> <executable> <executable> ...
+ *
+ * The splitting of the command line, which replaces CommandLineToArgvW, is
+ * checked against CommandLineToArgvW before the measurements. The program
+ * fails if the results differ.
+ *
+ * This program includes plainstarter-win32.c to reach the static functions,
+ * it is linked with the C runtime (see makefile-benchmark).
+ */
+
+#define PLAINSTARTER_NO_ENTRY_POINT
+#include "../src/plainstarter-win32.c"
+
+#include <shellapi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_MAX_EXECUTABLES 8
+
+static const wchar_t *BenchCommandLines[] = {
+  L"p a \"b c\" d",
+  L"\"C:\\Program Files\\app.exe\" --flag",
+  L"p \"ab\\\"c\" \"\\\\\" d",
+  L"p a\\\\\\b d\"e f\"g h",
+  L"p a\\\\\\\"b c d",
+  L"p a\\\\\\\\\"b c\" d e",
+  L"p \"\" x",
+  L"p a\"\"\"b \"a\"\"b\" \"\"\"\"",
+  L"\"p\"x y",
+  L"p\t tab   spaces   ",
+};
+
+static int BenchSelfCheck (void)
+{
+  LPWSTR *Expected;
+  TCHAR **Result;
+  int     ExpectedCount;
+  int     ResultCount;
+  int     Index;
+  int     Arg;
+  int     Valid = 1;
+
+  for (Index = 0 ; Index < (int)(sizeof(BenchCommandLines) / sizeof(BenchCommandLines[0])) ; Index++)
+  {
+    Expected = CommandLineToArgvW(BenchCommandLines[Index], &ExpectedCount);
+    Result   = PS_SplitCommandLine(BenchCommandLines[Index], &ResultCount);
+
+    if ((Expected == NULL) || (Result == NULL) || (ExpectedCount != ResultCount))
+    {
+      fprintf(stderr, "bench-coldstart: case %d is not split correctly\n", Index);
+      Valid = 0;
+    }
+    else
+    {
+      for (Arg = 0 ; Arg < ResultCount ; Arg++)
+      {
+        if (lstrcmp(Expected[Arg], Result[Arg]) != 0)
+        {
+          fprintf(stderr, "bench-coldstart: case %d argument %d is not split correctly\n", Index, Arg);
+          Valid = 0;
+        }
+      }
+    }
+
+    LocalFree(Expected);
+    HeapFree(GetProcessHeap(), 0, Result);
+  }
+
+  return Valid;
+}
+
+/* Microseconds from CreateProcess to the exit of Executable */
+static double BenchLaunch (const wchar_t *Executable)
+{
+  wchar_t             CommandLine[MAX_PATH + 2];
+  STARTUPINFOW        si;
+  PROCESS_INFORMATION pi;
+  LARGE_INTEGER       Frequency;
+  LARGE_INTEGER       Start;
+  LARGE_INTEGER       End;
+
+  SecureZeroMemory(&si, sizeof(si));
+  si.cb = sizeof(si);
+  lstrcpynW(CommandLine, Executable, MAX_PATH);
+
+  QueryPerformanceFrequency(&Frequency);
+  QueryPerformanceCounter(&Start);
+
+  if (CreateProcessW(NULL, CommandLine, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi) == FALSE)
+  {
+    fprintf(stderr, "bench-coldstart: %ls cannot be started\n", Executable);
+    exit(EXIT_FAILURE);
+  }
+  WaitForSingleObject(pi.hProcess, INFINITE);
+
+  QueryPerformanceCounter(&End);
+
+  CloseHandle(pi.hProcess);
+  CloseHandle(pi.hThread);
+
+  return ((double)(End.QuadPart - Start.QuadPart) * 1e6) / (double)Frequency.QuadPart;
+}
+
+int main (void)
+{
+  LPWSTR *Argv;
+  int     Argc;
+  int     Runs;
+  int     Run;
+  int     Index;
+  int     Count;
+  double  Time;
+  double  Sum[BENCH_MAX_EXECUTABLES];
+  double  Min[BENCH_MAX_EXECUTABLES];
+  double  Max[BENCH_MAX_EXECUTABLES];
+
+  if (!BenchSelfCheck())
+  {
+    return EXIT_FAILURE;
+  }
+
+  Argv = CommandLineToArgvW(GetCommandLineW(), &Argc);
+  if ((Argv == NULL) || (Argc < 3))
+  {
+    fprintf(stderr, "usage: bench-coldstart.exe <runs> <executable> <executable> ...\n");
+    return EXIT_FAILURE;
+  }
+
+  Runs  = _wtoi(Argv[1]);
+  Count = Argc - 2;
+  if (Count > BENCH_MAX_EXECUTABLES)
+  {
+    Count = BENCH_MAX_EXECUTABLES;
+  }
+
+  /* The first launches load the files in the cache, they are not counted */
+  for (Index = 0 ; Index < Count ; Index++)
+  {
+    BenchLaunch(Argv[Index + 2]);
+    Sum[Index] = 0;
+    Min[Index] = 1e30;
+    Max[Index] = 0;
+  }
+
+  /* Alternate the executables, so that they share the same system noise */
+  for (Run = 0 ; Run < Runs ; Run++)
+  {
+    for (Index = 0 ; Index < Count ; Index++)
+    {
+      Time        = BenchLaunch(Argv[Index + 2]);
+      Sum[Index] += Time;
+      Min[Index]  = (Time < Min[Index]) ? Time : Min[Index];
+      Max[Index]  = (Time > Max[Index]) ? Time : Max[Index];
+    }
+  }
+
+  printf("%-40s %10s %10s %10s\n", "executable", "mean(us)", "min(us)", "max(us)");
+  for (Index = 0 ; Index < Count ; Index++)
+  {
+    printf("%-40ls %10.1f %10.1f %10.1f\n",
+           Argv[Index + 2],
+           (Sum[Index] / ((Runs > 0) ? Runs : 1)),
+           Min[Index],
+           Max[Index]);
+  }
+
+  LocalFree(Argv);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | bench-expand.c                                                |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *
+ * Microbenchmark of the variables table and of PS_EnvExpand, built natively on
+ * the Linux host (see makefile-benchmark). Tables of 10 to 10000 variables are
+ * filled, then a value referencing 8 of the variables and an undefined one is
+ * expanded repeatedly.
+ *
+ * The expected results are checked before the measurements, the program fails
+ * if the expansion is not correct.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../src/plainstarter-env.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_REFERENCE_COUNT 8
+
+static double BenchNow (void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+
+  return ((double)Now.tv_sec * 1e9) + (double)Now.tv_nsec;
+}
+
+static int BenchCheck (PS_ENV *Env, const char *In, const char *Expected, size_t Undefined)
+{
+  PS_STRING        Out    = { NULL, 0, 0 };
+  PS_EXPAND_REPORT Report = { 0, NULL, 0 };
+  int              Valid;
+
+  Valid = PS_EnvExpand(Env, In, (PS_EXPAND_PERCENT | PS_EXPAND_BRACES), &Out, &Report)
+    && (strcmp(Out.Data, Expected) == 0)
+    && (Report.UndefinedCount == Undefined);
+
+  if (!Valid)
+  {
+    fprintf(stderr, "bench-expand: '%s' expanded to '%s', expected '%s'\n",
+            In, (Out.Data ? Out.Data : "(null)"), Expected);
+  }
+
+  PS_StringFree(&Out);
+
+  return Valid;
+}
+
+static int BenchSelfCheck (void)
+{
+  PS_ENV Env;
+  int    Valid;
+
+  Valid = PS_EnvInitialize(&Env)
+    && PS_EnvImportString(&Env, "HOME=/home/bench")
+    && PS_EnvSet(&Env, "APP", "%HOME%/app")
+    && PS_EnvSet(&Env, "EMPTY", "")
+    && PS_EnvSet(&Env, "DELETED", "x")
+    && PS_EnvSet(&Env, "DELETED", NULL);
+
+  Valid = Valid
+    && BenchCheck(&Env, "%HOME%/bin", "/home/bench/bin", 0)
+    && BenchCheck(&Env, "%APP%", "%HOME%/app", 0)
+    && BenchCheck(&Env, "[%EMPTY%]", "[]", 0)
+    && BenchCheck(&Env, "100%", "100%", 0)
+    && BenchCheck(&Env, "%%HOME%", "%/home/bench", 0)
+    && BenchCheck(&Env, "%UNDEFINED%HOME%", "%UNDEFINED/home/bench", 1)
+    && BenchCheck(&Env, "%DELETED%", "%DELETED%", 1)
+    && BenchCheck(&Env, "${HOME}/bin:${APP}", "/home/bench/bin:%HOME%/app", 0)
+    && BenchCheck(&Env, "[${UNDEFINED}]", "[]", 1)
+    && BenchCheck(&Env, "$HOME ${} ${HOME", "$HOME ${} ${HOME", 0)
+    && (PS_EnvGet(&Env, "DELETED", 7) == NULL);
+
+  PS_EnvFree(&Env);
+
+  return Valid;
+}
+
+int main (void)
+{
+  static const int VariableCounts[] = { 10, 100, 1000, 10000 };
+
+  char             Name[64];
+  char             Value[128];
+  char             In[1024];
+  char            *p;
+  PS_ENV           Env;
+  PS_STRING        Out = { NULL, 0, 0 };
+  PS_EXPAND_REPORT Report;
+  double           Start;
+  double           SetNs;
+  double           ExpandNs;
+  int              Repeat;
+  int              Index;
+  int              Count;
+  int              Run;
+
+  if (!BenchSelfCheck())
+  {
+    return EXIT_FAILURE;
+  }
+
+  printf("%10s %12s %12s %14s\n", "variables", "ns/set", "runs", "ns/expand");
+
+  for (Index = 0 ; Index < (int)(sizeof(VariableCounts) / sizeof(VariableCounts[0])) ; Index++)
+  {
+    Count = VariableCounts[Index];
+    PS_EnvInitialize(&Env);
+
+    Start = BenchNow();
+    for (Run = 0 ; Run < Count ; Run++)
+    {
+      snprintf(Name, sizeof(Name), "BENCH_VARIABLE_%d", Run);
+      snprintf(Value, sizeof(Value), "/opt/bench/third-party/lib-%d", Run);
+      PS_EnvSet(&Env, Name, Value);
+    }
+    SetNs = (BenchNow() - Start) / Count;
+
+    /* Value referencing variables spread over the table */
+    p = In;
+    for (Run = 0 ; Run < BENCH_REFERENCE_COUNT ; Run++)
+    {
+      p += sprintf(p, "%%BENCH_VARIABLE_%d%%;", ((Run * 7919) % Count));
+    }
+    sprintf(p, "%%UNDEFINED%%;C:\\Windows\\system32");
+
+    Repeat = 200000;
+    Start  = BenchNow();
+    for (Run = 0 ; Run < Repeat ; Run++)
+    {
+      Report.UndefinedCount = 0;
+      PS_EnvExpand(&Env, In, PS_EXPAND_PERCENT, &Out, &Report);
+    }
+    ExpandNs = (BenchNow() - Start) / Repeat;
+
+    printf("%10d %12.1f %12d %14.1f\n", Count, SetNs, Repeat, ExpandNs);
+
+    PS_EnvFree(&Env);
+  }
+
+  PS_StringFree(&Out);
+
+  return EXIT_SUCCESS;
+}
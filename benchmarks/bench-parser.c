@@ -0,0 +1,135 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | bench-parser.c                                                |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *
+ * Microbenchmark of PS_ParseConfiguration. Configurations of 10 to 10000 lines
+ * are generated in memory and parsed repeatedly. The generated files contain
+ * comments and variables referencing other variables. The callback only counts
+ * the variables: the expansion and the environment are measured by
+ * bench-expand, this program measures the parser alone.
+ *
+ * This program includes plainstarter-win32.c to reach the static functions,
+ * it is linked with the C runtime (see makefile-benchmark).
+ */
+
+#define PLAINSTARTER_NO_ENTRY_POINT
+#include "../src/plainstarter-win32.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Number of distinct variable names, the lines are reusing the names */
+#define BENCH_VARIABLE_COUNT 64
+
+static TCHAR *BenchAppendAscii (TCHAR *Out, const char *In)
+{
+  while (*In)
+  {
+    *Out++ = (TCHAR)*In++;
+  }
+
+  return Out;
+}
+
+/* Generate a UTF-16 configuration of LineCount lines, including the BOM */
+static TCHAR *BenchGenerateConfig (int LineCount)
+{
+  char   Line[256];
+  TCHAR *Buffer;
+  TCHAR *p;
+  int    Index;
+
+  Buffer = malloc((LineCount + 1) * sizeof(Line) * sizeof(TCHAR));
+  p      = Buffer;
+  *p++   = (TCHAR)0xFEFF;
+
+  for (Index = 0 ; Index < LineCount ; Index++)
+  {
+    if ((Index % 10) == 0)
+    {
+      snprintf(Line, sizeof(Line), "# comment line %d\r\n", Index);
+    }
+    else
+    {
+      snprintf(Line, sizeof(Line),
+               "BENCH_VARIABLE_%d=%%PLAINSTARTER_DIRECTORY%%\\third-party\\lib-%d;%%BENCH_VARIABLE_0%%\r\n",
+               (Index % BENCH_VARIABLE_COUNT),
+               Index);
+    }
+    p = BenchAppendAscii(p, Line);
+  }
+  *p = _T('\0');
+
+  return Buffer;
+}
+
+static void BenchCount (void *Context, const TCHAR *Name, const TCHAR *Value)
+{
+  (void)Name;
+  (void)Value;
+  (*(int *)Context)++;
+}
+
+static void BenchParse (const TCHAR *Config, int *Count)
+{
+  static PS_PARSER Parser;
+
+  PS_ParserInitialize(&Parser, BenchCount, Count);
+  PS_ParseConfiguration(&Parser, Config, (Config + lstrlen(Config)));
+  PS_ParserFinish(&Parser);
+}
+
+int main (int argc, char **argv)
+{
+  static const int LineCounts[] = { 10, 100, 1000, 10000 };
+
+  LARGE_INTEGER Frequency;
+  LARGE_INTEGER Start;
+  LARGE_INTEGER End;
+  TCHAR        *Config;
+  double        Microseconds;
+  int           Count = 0;
+  int           Repeat;
+  int           Index;
+  int           Run;
+
+  QueryPerformanceFrequency(&Frequency);
+
+  printf("%8s %10s %8s %12s %12s\n", "lines", "bytes", "runs", "us/parse", "ns/line");
+
+  for (Index = 0 ; Index < (int)PS_ARRAY_SIZE(LineCounts) ; Index++)
+  {
+    Config = BenchGenerateConfig(LineCounts[Index]);
+    Repeat = (100000 / LineCounts[Index]) + 1;
+
+    /* Warm-up */
+    BenchParse(Config, &Count);
+
+    QueryPerformanceCounter(&Start);
+    for (Run = 0 ; Run < Repeat ; Run++)
+    {
+      BenchParse(Config, &Count);
+    }
+    QueryPerformanceCounter(&End);
+
+    Microseconds = ((double)(End.QuadPart - Start.QuadPart) * 1000000.0)
+                   / (double)Frequency.QuadPart / Repeat;
+
+    printf("%8d %10d %8d %12.1f %12.1f\n",
+           LineCounts[Index],
+           (int)(lstrlen(Config) * sizeof(TCHAR)),
+           Repeat,
+           Microseconds,
+           (Microseconds * 1000.0) / LineCounts[Index]);
+
+    free(Config);
+  }
+
+  /* Keep the callback */
+  return (Count > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
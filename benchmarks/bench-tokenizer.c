@@ -0,0 +1,312 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | bench-tokenizer.c                                             |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *
+ * Microbenchmark of PS_ParseConfiguration, built natively on the Linux host
+ * (see makefile-benchmark) with and without the SSE2 search. Configurations
+ * of 10 to 10000 lines are parsed repeatedly by the line tokenizer and by the
+ * character state machine alone.
+ *
+ * Before the measurements, the tokenizer is checked against the state
+ * machine: known edge cases and random configurations are parsed in chunks
+ * split at every position or at random positions, and must give the same
+ * variables and the same overlong lines. The program fails otherwise.
+ *
+ * This program includes plainstarter-core.c to reach the state machine.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../src/plainstarter-core.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_RANDOM_CONFIGS 2000
+
+/* Variables received by the callback, "NAME=VALUE\n" */
+typedef struct {
+  char   *Data;
+  size_t  Length;
+  size_t  Capacity;
+} BENCH_OUTPUT;
+
+static const char *BenchCases[] = {
+  "A=1\r\nB=2\r\n",
+  "A=1\nB=2",
+  "A=1\rB=2\nC=3\n",
+  "# comment\r\nA=%PATH%;x\r\n",
+  "A=x#y\nB=z\n",
+  "=value\n",
+  "no-equal\r\nA==b\n",
+  "\r\n\n\r\r\nA=1\r",
+  "A=1\r#\nB\r=2\nC=3",
+  "NAME=",
+  "#",
+  "A=\n=\n==\n",
+};
+
+static void BenchAppend (BENCH_OUTPUT *Output, const char *Text)
+{
+  size_t Length = strlen(Text);
+
+  if ((Output->Length + Length + 1) > Output->Capacity)
+  {
+    Output->Capacity = (Output->Length + Length + 1) * 2;
+    Output->Data     = realloc(Output->Data, Output->Capacity);
+  }
+  memcpy((Output->Data + Output->Length), Text, (Length + 1));
+  Output->Length += Length;
+}
+
+static void BenchCallback (void *Context, const char *Name, const char *Value)
+{
+  BenchAppend(Context, Name);
+  BenchAppend(Context, "=");
+  BenchAppend(Context, Value);
+  BenchAppend(Context, "\n");
+}
+
+static double BenchNow (void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+
+  return ((double)Now.tv_sec * 1e9) + (double)Now.tv_nsec;
+}
+
+/* Reference: the state machine in a single chunk */
+static void BenchReference (const char *Config, size_t Length, BENCH_OUTPUT *Output, PS_PARSER *Parser)
+{
+  Output->Length = 0;
+  BenchAppend(Output, "");
+
+  PS_ParserInitialize(Parser, BenchCallback, Output);
+  PS_ParseScalar(Parser, Config, (Config + Length), 0);
+  PS_ParserFinish(Parser);
+}
+
+/* Tokenizer, with chunks of ChunkLength characters, or of random lengths
+ * when ChunkLength is 0 */
+static void BenchTokenize (const char   *Config,
+                           size_t        Length,
+                           size_t        ChunkLength,
+                           BENCH_OUTPUT *Output,
+                           PS_PARSER    *Parser)
+{
+  size_t Position = 0;
+  size_t Size;
+
+  Output->Length = 0;
+  BenchAppend(Output, "");
+
+  PS_ParserInitialize(Parser, BenchCallback, Output);
+  while (Position < Length)
+  {
+    Size = (ChunkLength > 0) ? ChunkLength : (size_t)(1 + (rand() % 3000));
+    if (Size > (Length - Position))
+    {
+      Size = Length - Position;
+    }
+    PS_ParseConfiguration(Parser, (Config + Position), (Config + Position + Size));
+    Position += Size;
+  }
+  PS_ParserFinish(Parser);
+}
+
+static int BenchCompare (const char *Config, size_t Length, size_t ChunkLength, const char *Label)
+{
+  static BENCH_OUTPUT Expected;
+  static BENCH_OUTPUT Result;
+  PS_PARSER           ExpectedParser;
+  PS_PARSER           ResultParser;
+
+  BenchReference(Config, Length, &Expected, &ExpectedParser);
+  BenchTokenize(Config, Length, ChunkLength, &Result, &ResultParser);
+
+  if ((strcmp(Expected.Data, Result.Data) != 0)
+      || (ExpectedParser.Line != ResultParser.Line)
+      || (ExpectedParser.OverlongCount != ResultParser.OverlongCount)
+      || (ExpectedParser.OverlongLine != ResultParser.OverlongLine))
+  {
+    fprintf(stderr, "bench-tokenizer: %s is not parsed like the state machine (chunks of %d)\n",
+            Label, (int)ChunkLength);
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Random configuration made of the characters of the syntax, with names and
+ * values around the length limit */
+static size_t BenchGenerateRandom (char *Config)
+{
+  static const char Alphabet[] = "ab=#\r\n\n  x=";
+  size_t            Length     = 0;
+  int               Lines      = 1 + (rand() % 20);
+  int               Line;
+  int               Run;
+  int               Index;
+
+  for (Line = 0 ; Line < Lines ; Line++)
+  {
+    if ((rand() % 4) == 0)
+    {
+      /* Long name or value: 1020 to 1028 characters */
+      Run = (int)PS_MAX_LINE_LENGTH - 4 + (rand() % 9);
+      if ((rand() % 2) == 0)
+      {
+        Config[Length++] = 'V';
+        Config[Length++] = '=';
+      }
+      for (Index = 0 ; Index < Run ; Index++)
+      {
+        Config[Length++] = 'L';
+      }
+    }
+
+    Run = rand() % 12;
+    for (Index = 0 ; Index < Run ; Index++)
+    {
+      Config[Length++] = Alphabet[rand() % (sizeof(Alphabet) - 1)];
+    }
+  }
+  Config[Length] = '\0';
+
+  return Length;
+}
+
+static int BenchSelfCheck (void)
+{
+  static char Config[64 * 1200];
+  char        Label[64];
+  size_t      Length;
+  size_t      Chunk;
+  int         Index;
+  int         Valid = 1;
+
+  for (Index = 0 ; Index < (int)(sizeof(BenchCases) / sizeof(BenchCases[0])) ; Index++)
+  {
+    Length = strlen(BenchCases[Index]);
+    snprintf(Label, sizeof(Label), "case %d", Index);
+    for (Chunk = 1 ; Chunk <= Length ; Chunk++)
+    {
+      Valid = BenchCompare(BenchCases[Index], Length, Chunk, Label) && Valid;
+    }
+  }
+
+  srand(1);
+  for (Index = 0 ; Index < BENCH_RANDOM_CONFIGS ; Index++)
+  {
+    Length = BenchGenerateRandom(Config);
+    snprintf(Label, sizeof(Label), "random configuration %d", Index);
+    Valid = BenchCompare(Config, Length, Length, Label) && Valid;
+    Valid = BenchCompare(Config, Length, 0, Label) && Valid;
+    Valid = BenchCompare(Config, Length, (size_t)(1 + (Index % 17)), Label) && Valid;
+  }
+
+  return Valid;
+}
+
+/* Same lines as bench-parser */
+static char *BenchGenerateConfig (int LineCount, size_t *Length)
+{
+  char *Buffer = malloc((size_t)(LineCount + 1) * 256);
+  char *p      = Buffer;
+  int   Index;
+
+  for (Index = 0 ; Index < LineCount ; Index++)
+  {
+    if ((Index % 10) == 0)
+    {
+      p += sprintf(p, "# comment line %d\r\n", Index);
+    }
+    else
+    {
+      p += sprintf(p, "BENCH_VARIABLE_%d=%%PLAINSTARTER_DIRECTORY%%\\third-party\\lib-%d;%%BENCH_VARIABLE_0%%\r\n",
+                   (Index % 64), Index);
+    }
+  }
+  *Length = (size_t)(p - Buffer);
+
+  return Buffer;
+}
+
+static void BenchCount (void *Context, const char *Name, const char *Value)
+{
+  (void)Name;
+  (void)Value;
+  (*(int *)Context)++;
+}
+
+int main (void)
+{
+  static const int LineCounts[] = { 10, 100, 1000, 10000 };
+
+  PS_PARSER Parser;
+  char     *Config;
+  size_t    Length;
+  double    Start;
+  double    Scalar;
+  double    Tokenizer;
+  int       Count = 0;
+  int       Repeat;
+  int       Index;
+  int       Run;
+
+  if (!BenchSelfCheck())
+  {
+    return EXIT_FAILURE;
+  }
+
+#if defined(PS_CORE_SSE2)
+  printf("search: SSE2\n");
+#else
+  printf("search: scalar\n");
+#endif
+  printf("%8s %10s %14s %14s %10s\n", "lines", "bytes", "scalar(us)", "tokenizer(us)", "ns/line");
+
+  for (Index = 0 ; Index < (int)(sizeof(LineCounts) / sizeof(LineCounts[0])) ; Index++)
+  {
+    Config = BenchGenerateConfig(LineCounts[Index], &Length);
+    Repeat = (1000000 / LineCounts[Index]) + 1;
+
+    Start = BenchNow();
+    for (Run = 0 ; Run < Repeat ; Run++)
+    {
+      PS_ParserInitialize(&Parser, BenchCount, &Count);
+      PS_ParseScalar(&Parser, Config, (Config + Length), 0);
+      PS_ParserFinish(&Parser);
+    }
+    Scalar = (BenchNow() - Start) / Repeat;
+
+    Start = BenchNow();
+    for (Run = 0 ; Run < Repeat ; Run++)
+    {
+      PS_ParserInitialize(&Parser, BenchCount, &Count);
+      PS_ParseConfiguration(&Parser, Config, (Config + Length));
+      PS_ParserFinish(&Parser);
+    }
+    Tokenizer = (BenchNow() - Start) / Repeat;
+
+    printf("%8d %10d %14.2f %14.2f %10.1f\n",
+           LineCounts[Index],
+           (int)Length,
+           (Scalar / 1000.0),
+           (Tokenizer / 1000.0),
+           (Tokenizer / LineCounts[Index]));
+
+    free(Config);
+  }
+
+  /* Keep the callbacks */
+  return (Count > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,171 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | bench-utf8.c                                                  |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *
+ * Microbenchmark of PS_Utf8Decode, built natively on the Linux host (see
+ * makefile-benchmark) with and without the SSE2 fast path. Configurations of
+ * 1 MiB are converted repeatedly: ASCII only, and with one non-ASCII
+ * character every 64 bytes.
+ *
+ * The conversion of known sequences is checked before the measurements, with
+ * the input split at every position to exercise the sequences spanning two
+ * chunks. The program fails if a conversion is not correct.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../src/plainstarter-utf8.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_CONFIG_SIZE (1024 * 1024)
+
+typedef struct {
+  const char     *In;
+  const PS_UTF16  Expected[40];
+  size_t          ExpectedLength;
+  size_t          InvalidCount;
+} BENCH_CASE;
+
+static const BENCH_CASE BenchCases[] = {
+  { "PATH=%PATH%;C:\\Program Files\\Bench",
+    { 'P','A','T','H','=','%','P','A','T','H','%',';','C',':','\\','P','r','o','g','r','a','m',' ','F','i','l','e','s','\\','B','e','n','c','h' },
+    34, 0 },
+  { "\xEF\xBB\xBFK=caf\xC3\xA9", { 0xFEFF, 'K', '=', 'c', 'a', 'f', 0xE9 }, 7, 0 },
+  { "\xE2\x82\xAC\xF0\x9F\x98\x80", { 0x20AC, 0xD83D, 0xDE00 }, 3, 0 },
+  { "\xC0\xAFx", { 0xFFFD, 0xFFFD, 'x' }, 3, 2 },
+  { "\xED\xA0\x80", { 0xFFFD }, 1, 1 },
+  { "\xF4\x90\x80\x80", { 0xFFFD }, 1, 1 },
+  { "\xE2\x82x", { 0xFFFD, 'x' }, 2, 1 },
+  { "\xE2\x82", { 0xFFFD }, 1, 1 },
+};
+
+static double BenchNow (void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+
+  return ((double)Now.tv_sec * 1e9) + (double)Now.tv_nsec;
+}
+
+/* Convert In in two chunks split at Split */
+static size_t BenchConvert (const unsigned char *In,
+                            size_t               Length,
+                            size_t               Split,
+                            PS_UTF16            *Out,
+                            size_t              *InvalidCount)
+{
+  PS_UTF8_DECODER Decoder;
+  size_t          OutLength;
+
+  PS_Utf8Initialize(&Decoder);
+  OutLength  = PS_Utf8Decode(&Decoder, In, Split, Out);
+  OutLength += PS_Utf8Decode(&Decoder, (In + Split), (Length - Split), (Out + OutLength));
+  OutLength += PS_Utf8Finish(&Decoder, (Out + OutLength));
+
+  *InvalidCount = Decoder.InvalidCount;
+
+  return OutLength;
+}
+
+static int BenchSelfCheck (void)
+{
+  const BENCH_CASE *Case;
+  PS_UTF16          Out[64];
+  size_t            Length;
+  size_t            OutLength;
+  size_t            InvalidCount;
+  size_t            Split;
+  size_t            Index;
+  int               Valid = 1;
+
+  for (Index = 0 ; Index < (sizeof(BenchCases) / sizeof(BenchCases[0])) ; Index++)
+  {
+    Case   = &BenchCases[Index];
+    Length = strlen(Case->In);
+
+    for (Split = 0 ; Split <= Length ; Split++)
+    {
+      OutLength = BenchConvert((const unsigned char *)Case->In, Length, Split, Out, &InvalidCount);
+
+      if ((OutLength != Case->ExpectedLength)
+          || (InvalidCount != Case->InvalidCount)
+          || (memcmp(Out, Case->Expected, (OutLength * sizeof(PS_UTF16))) != 0))
+      {
+        fprintf(stderr, "bench-utf8: case %d split at %d is not converted correctly\n",
+                (int)Index, (int)Split);
+        Valid = 0;
+      }
+    }
+  }
+
+  return Valid;
+}
+
+static void BenchMeasure (const char *Label, const unsigned char *Config, PS_UTF16 *Out)
+{
+  PS_UTF8_DECODER Decoder;
+  double          Start;
+  double          Nanoseconds;
+  int             Repeat = 200;
+  int             Run;
+
+  Start = BenchNow();
+  for (Run = 0 ; Run < Repeat ; Run++)
+  {
+    PS_Utf8Initialize(&Decoder);
+    PS_Utf8Decode(&Decoder, Config, BENCH_CONFIG_SIZE, Out);
+  }
+  Nanoseconds = (BenchNow() - Start) / Repeat;
+
+  printf("%-12s %10d %12.1f %12.1f\n",
+         Label,
+         BENCH_CONFIG_SIZE,
+         (Nanoseconds / 1000.0),
+         (((double)BENCH_CONFIG_SIZE * 1000.0) / Nanoseconds));
+}
+
+int main (void)
+{
+  unsigned char *Config;
+  PS_UTF16      *Out;
+  int            Index;
+
+  if (!BenchSelfCheck())
+  {
+    return EXIT_FAILURE;
+  }
+
+  Config = malloc(BENCH_CONFIG_SIZE);
+  Out    = malloc((BENCH_CONFIG_SIZE + 1) * sizeof(PS_UTF16));
+
+  for (Index = 0 ; Index < BENCH_CONFIG_SIZE ; Index++)
+  {
+    Config[Index] = (unsigned char)(((Index % 64) == 63) ? '\n' : ('A' + (Index % 26)));
+  }
+
+  printf("%-12s %10s %12s %12s\n", "input", "bytes", "us/convert", "MB/s");
+  BenchMeasure("ascii", Config, Out);
+
+  /* e-acute every 64 bytes */
+  for (Index = 0 ; Index < BENCH_CONFIG_SIZE ; Index += 64)
+  {
+    Config[Index]     = 0xC3;
+    Config[Index + 1] = 0xA9;
+  }
+  BenchMeasure("mixed", Config, Out);
+
+  free(Config);
+  free(Out);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,20 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | noop-child.c                                                  |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *
+ * Child process used by the launch benchmark: it exits immediately so that the
+ * measurements only reflect the cost of Plainstarter itself.
+ */
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+int WINAPI WinMainCRTStartup (void)
+{
+  ExitProcess(0);
+}
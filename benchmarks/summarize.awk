@@ -0,0 +1,35 @@
+#
+# Aggregate the lines printed by a PLAINSTARTER_BENCHMARK build:
+#   total=412/1 config-probe=95/1 parse=180/1 expand=40/3 ...
+# Each field is phase=microseconds/count.
+#
+
+{
+  for (i = 1; i <= NF; i++)
+  {
+    split($i, Field, "[=/]")
+    Phase = Field[1]
+    Value = Field[2] + 0
+
+    if (!(Phase in Count))
+    {
+      Order[++PhaseCount] = Phase
+      Min[Phase]          = Value
+      Max[Phase]          = Value
+    }
+    Count[Phase]++
+    Sum[Phase] += Value
+    Calls[Phase] += Field[3]
+    if (Value < Min[Phase]) Min[Phase] = Value
+    if (Value > Max[Phase]) Max[Phase] = Value
+  }
+}
+
+END {
+  printf "%-16s %10s %10s %10s %8s\n", "phase", "mean(us)", "min(us)", "max(us)", "calls"
+  for (i = 1; i <= PhaseCount; i++)
+  {
+    Phase = Order[i]
+    printf "%-16s %10.1f %10d %10d %8.1f\n", Phase, Sum[Phase] / Count[Phase], Min[Phase], Max[Phase], Calls[Phase] / Count[Phase]
+  }
+}
@@ -0,0 +1,504 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-core.c                                           |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * The configuration file is a list of lines NAME=VALUE, the lines starting
+ * with '#' are comments. The lines end with CRLF or LF. On Windows, the first
+ * character can be the Byte Order Mark U+FEFF, which is skipped; the POSIX
+ * backend skips the UTF-8 Byte Order Mark itself.
+ *
+ * The lines contained in a chunk are split by PS_ParseLine: the name and the
+ * value are delimited by searching '=', '#', CR and LF, 8 UTF-16 characters
+ * (16 bytes on POSIX) at a time when SSE2 is available. The lines spanning
+ * two chunks are completed by the character state machine PS_ParseScalar,
+ * which defines the syntax: both give the same variables. Define
+ * PS_CORE_NO_SIMD to search one character at a time.
+ */
+
+#include "plainstarter-core.h"
+
+/*---------------------*/
+/* INCLUDES AND MACROS */
+/*---------------------*/
+
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(PS_CORE_NO_SIMD)
+#define PS_CORE_SSE2
+#include <emmintrin.h>
+#endif
+
+/*-----------*/
+/* CONSTANTS */
+/*-----------*/
+
+#if defined(_WIN32)
+#define PS_BOM ((PS_CHAR)0xFEFF)
+#endif
+
+/*-------------------*/
+/* UTILITY FUNCTIONS */
+/*-------------------*/
+
+static PS_CHAR *PS_CoreAppend (PS_CHAR       *Out,
+                               const PS_CHAR *InStart,
+                               const PS_CHAR *InEnd)
+{
+  const PS_CHAR *pi = InStart;
+
+  while (pi < InEnd)
+  {
+    *Out++ = *pi++;
+  }
+
+  return Out;
+}
+
+static int PS_IsPathSeparator (PS_CHAR Char)
+{
+#if defined(_WIN32)
+  return ((Char == PS_TEXT('\\')) || (Char == PS_TEXT('/')));
+#else
+  return (Char == PS_TEXT('/'));
+#endif
+}
+
+/* Return the first of the characters c1 to c4 between p and End, or End */
+static const PS_CHAR *PS_CoreFind (const PS_CHAR *p,
+                                   const PS_CHAR *End,
+                                   PS_CHAR        c1,
+                                   PS_CHAR        c2,
+                                   PS_CHAR        c3,
+                                   PS_CHAR        c4)
+{
+#if defined(PS_CORE_SSE2) && defined(_WIN32)
+  const __m128i v1 = _mm_set1_epi16((short)c1);
+  const __m128i v2 = _mm_set1_epi16((short)c2);
+  const __m128i v3 = _mm_set1_epi16((short)c3);
+  const __m128i v4 = _mm_set1_epi16((short)c4);
+  __m128i       Block;
+  __m128i       Match;
+
+  /* Skip the blocks without any of the characters */
+  while ((End - p) >= 8)
+  {
+    Block = _mm_loadu_si128((const __m128i *)p);
+    Match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(Block, v1), _mm_cmpeq_epi16(Block, v2)),
+                         _mm_or_si128(_mm_cmpeq_epi16(Block, v3), _mm_cmpeq_epi16(Block, v4)));
+    if (_mm_movemask_epi8(Match) != 0)
+    {
+      break;
+    }
+    p += 8;
+  }
+#elif defined(PS_CORE_SSE2)
+  const __m128i v1 = _mm_set1_epi8((char)c1);
+  const __m128i v2 = _mm_set1_epi8((char)c2);
+  const __m128i v3 = _mm_set1_epi8((char)c3);
+  const __m128i v4 = _mm_set1_epi8((char)c4);
+  __m128i       Block;
+  __m128i       Match;
+
+  while ((End - p) >= 16)
+  {
+    Block = _mm_loadu_si128((const __m128i *)p);
+    Match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Block, v1), _mm_cmpeq_epi8(Block, v2)),
+                         _mm_or_si128(_mm_cmpeq_epi8(Block, v3), _mm_cmpeq_epi8(Block, v4)));
+    if (_mm_movemask_epi8(Match) != 0)
+    {
+      break;
+    }
+    p += 16;
+  }
+#endif
+
+  while ((p < End) && (*p != c1) && (*p != c2) && (*p != c3) && (*p != c4))
+  {
+    p++;
+  }
+
+  return p;
+}
+
+static int PS_IsAbsolute (const PS_CHAR *Path, size_t PathLength)
+{
+#if defined(_WIN32)
+  return (PathLength >= 2)
+    && ((Path[1] == PS_TEXT(':')) || PS_IsPathSeparator(Path[0]));
+#else
+  return (PathLength >= 1) && (Path[0] == PS_TEXT('/'));
+#endif
+}
+
+/*----------------------------*/
+/* CONFIGURATION FILE LOOKUP  */
+/*----------------------------*/
+
+int PS_GetConfigFilename (const PS_CHAR *Prefix,
+                          size_t         PrefixLength,
+                          const PS_CHAR *Filename,
+                          PS_CHAR       *Buffer,
+                          size_t         BufferLength)
+{
+  size_t         FilenameLength = PS_StringLength(Filename);
+  const PS_CHAR *ProgName;
+  const PS_CHAR *ProgNameEnd;
+  const PS_CHAR *p;
+  PS_CHAR       *BufferEnd;
+  int            Success = 0;
+
+  /* prefix, separator, filename, ".cfg" and null character */
+  if ((PrefixLength + FilenameLength + 6) <= BufferLength)
+  {
+    /* find the basename */
+    ProgName    = Filename;
+    ProgNameEnd = Filename + FilenameLength;
+    for (p = Filename ; p < (Filename + FilenameLength) ; p++)
+    {
+      if (PS_IsPathSeparator(*p))
+      {
+        ProgName    = p + 1;
+        ProgNameEnd = Filename + FilenameLength;
+      }
+#if defined(_WIN32)
+      else if (*p == PS_TEXT('.'))
+      {
+        ProgNameEnd = p;
+      }
+#endif
+    }
+
+    /* a trailing dot is kept */
+    if (ProgNameEnd == (Filename + FilenameLength - 1))
+    {
+      ProgNameEnd = Filename + FilenameLength;
+    }
+
+    BufferEnd = Buffer;
+
+    /* Filename contains a directory */
+    if ((ProgName != Filename) && (PS_IsAbsolute(Prefix, PrefixLength) == 0))
+    {
+      BufferEnd = PS_CoreAppend(BufferEnd, Filename, ProgName);
+    }
+
+    /* Non-empty prefix */
+    if (PrefixLength > 0)
+    {
+      BufferEnd = PS_CoreAppend(BufferEnd, Prefix, (Prefix + PrefixLength));
+      if (PS_IsPathSeparator(Prefix[PrefixLength - 1]) == 0)
+      {
+        *BufferEnd++ = PS_PATH_SEPARATOR;
+      }
+    }
+
+    BufferEnd    = PS_CoreAppend(BufferEnd, ProgName, ProgNameEnd);
+    *BufferEnd++ = PS_TEXT('.');
+    *BufferEnd++ = PS_TEXT('c');
+    *BufferEnd++ = PS_TEXT('f');
+    *BufferEnd++ = PS_TEXT('g');
+    *BufferEnd++ = PS_TEXT('\0');
+
+    Success = 1;
+  }
+
+  return Success;
+}
+
+int PS_SearchConfigFilename (const PS_CHAR     *SearchList,
+                             const PS_CHAR     *Executable,
+                             PS_CHAR           *Buffer,
+                             size_t             BufferLength,
+                             PS_PROBE_CALLBACK  Probe,
+                             void              *Context)
+{
+  const PS_CHAR *Entry = SearchList;
+  const PS_CHAR *EntryEnd;
+  int            Found = 0;
+  int            Done  = 0;
+
+  while ((Found == 0) && (Done == 0))
+  {
+    EntryEnd = Entry;
+    while ((*EntryEnd) && (*EntryEnd != PS_LIST_SEPARATOR))
+    {
+      EntryEnd++;
+    }
+
+    if (PS_GetConfigFilename(Entry, (size_t)(EntryEnd - Entry), Executable, Buffer, BufferLength)
+        && Probe(Context, Buffer))
+    {
+      Found = 1;
+    }
+    else if (*EntryEnd == PS_TEXT('\0'))
+    {
+      Done = 1;
+    }
+    else
+    {
+      Entry = EntryEnd + 1;
+    }
+  }
+
+  return Found;
+}
+
+/*--------*/
+/* PARSER */
+/*--------*/
+
+void PS_ParserInitialize (PS_PARSER            *Parser,
+                          PS_VARIABLE_CALLBACK  Callback,
+                          void                 *Context)
+{
+  Parser->State         = PS_PARSER_READ_NAME;
+  Parser->Index         = 0;
+  Parser->ExpectingBOM  = 1;
+  Parser->Line          = 0;
+  Parser->OverlongCount = 0;
+  Parser->OverlongLine  = 0;
+  Parser->Callback      = Callback;
+  Parser->Context       = Context;
+}
+
+static void PS_ParserOverlong (PS_PARSER *Parser)
+{
+  if (Parser->OverlongCount == 0)
+  {
+    Parser->OverlongLine = Parser->Line + 1;
+  }
+  Parser->OverlongCount++;
+}
+
+/* Character state machine, from Start to End or, when StopAtLineEnd is
+ * non-zero, to the beginning of the next line. Return the next character to
+ * parse. */
+static const PS_CHAR *PS_ParseScalar (PS_PARSER     *Parser,
+                                      const PS_CHAR *Start,
+                                      const PS_CHAR *End,
+                                      int            StopAtLineEnd)
+{
+  PS_CHAR       *VariableName  = Parser->VariableName;
+  PS_CHAR       *VariableValue = Parser->VariableValue;
+  const PS_CHAR *p             = Start;
+
+  while (p < End)
+  {
+    if (*p == PS_TEXT('#'))
+    {
+      Parser->State = PS_PARSER_READ_COMMENT;
+    }
+
+    /* Unexpected new line, skip silently */
+    if ((Parser->State != PS_PARSER_READ_VALUE)
+        && (*p == PS_TEXT('\r')))
+    {
+      Parser->State = PS_PARSER_READ_N;
+    }
+
+    if (Parser->Index >= PS_MAX_LINE_LENGTH)
+    {
+      if ((Parser->State == PS_PARSER_READ_NAME) || (Parser->State == PS_PARSER_READ_VALUE))
+      {
+        PS_ParserOverlong(Parser);
+      }
+      Parser->State = PS_PARSER_READ_N;
+    }
+
+    /* Line ending without carriage return (LF only) */
+    if ((Parser->State != PS_PARSER_READ_N)
+        && (*p == PS_TEXT('\n')))
+    {
+      if (Parser->State == PS_PARSER_READ_VALUE)
+      {
+        VariableValue[Parser->Index] = PS_TEXT('\0');
+        Parser->Callback(Parser->Context, VariableName, VariableValue);
+      }
+      Parser->State = PS_PARSER_READ_N;
+    }
+
+    switch (Parser->State)
+    {
+    case PS_PARSER_READ_COMMENT:
+      if (*p == PS_TEXT('\r'))
+      {
+        Parser->State = PS_PARSER_READ_N;
+      }
+      break;
+
+    case PS_PARSER_READ_NAME:
+      if (*p == PS_TEXT('='))
+      {
+        VariableName[Parser->Index] = PS_TEXT('\0');
+        Parser->State = PS_PARSER_READ_VALUE;
+        Parser->Index = 0;
+      }
+      else
+      {
+        VariableName[Parser->Index] = *p;
+        Parser->Index++;
+      }
+      break;
+
+    case PS_PARSER_READ_VALUE:
+      if (*p == PS_TEXT('\r'))
+      {
+        VariableValue[Parser->Index] = PS_TEXT('\0');
+        Parser->State = PS_PARSER_READ_N;
+        Parser->Callback(Parser->Context, VariableName, VariableValue);
+      }
+      else
+      {
+        VariableValue[Parser->Index] = *p;
+        Parser->Index++;
+      }
+      break;
+
+    case PS_PARSER_READ_N:
+      if (*p == PS_TEXT('\n'))
+      {
+        Parser->State = PS_PARSER_READ_NAME;
+        Parser->Index = 0;
+        Parser->Line++;
+
+        if (StopAtLineEnd)
+        {
+          return (p + 1);
+        }
+      }
+      break;
+    }
+
+    /* process next character */
+    p++;
+  }
+
+  return End;
+}
+
+/* Parse the line starting at Start, with the same result as PS_ParseScalar.
+ * Return the beginning of the next line, End when the end of the line is
+ * skipped in the next chunks, or NULL if the name or the value is not
+ * complete in this chunk (nothing is parsed then). */
+static const PS_CHAR *PS_ParseLine (PS_PARSER     *Parser,
+                                    const PS_CHAR *Start,
+                                    const PS_CHAR *End)
+{
+  const PS_CHAR *NameEnd;
+  const PS_CHAR *Value;
+  const PS_CHAR *ValueEnd;
+  const PS_CHAR *p;
+  size_t         Length;
+
+  NameEnd = PS_CoreFind(Start, End, PS_TEXT('='), PS_TEXT('#'), PS_TEXT('\r'), PS_TEXT('\n'));
+  if (NameEnd == End)
+  {
+    return NULL;
+  }
+
+  Length = (size_t)(NameEnd - Start);
+  p      = NameEnd;
+
+  if (*NameEnd != PS_TEXT('='))
+  {
+    /* Comment or line without '=': the state machine only reaches the limit
+     * of the name if the line ends after it */
+    if ((Length > PS_MAX_LINE_LENGTH)
+        || ((Length == PS_MAX_LINE_LENGTH) && (*NameEnd == PS_TEXT('\n'))))
+    {
+      PS_ParserOverlong(Parser);
+    }
+  }
+  else if (Length >= PS_MAX_LINE_LENGTH)
+  {
+    PS_ParserOverlong(Parser);
+  }
+  else
+  {
+    Value    = NameEnd + 1;
+    ValueEnd = PS_CoreFind(Value, End, PS_TEXT('#'), PS_TEXT('\r'), PS_TEXT('\n'), PS_TEXT('\n'));
+    if (ValueEnd == End)
+    {
+      return NULL;
+    }
+
+    p = ValueEnd;
+
+    /* A '#' ends the value before its limit is checked */
+    if (((size_t)(ValueEnd - Value) > PS_MAX_LINE_LENGTH)
+        || (((size_t)(ValueEnd - Value) == PS_MAX_LINE_LENGTH) && (*ValueEnd != PS_TEXT('#'))))
+    {
+      PS_ParserOverlong(Parser);
+    }
+    else if (*ValueEnd != PS_TEXT('#'))
+    {
+      *PS_CoreAppend(Parser->VariableName, Start, NameEnd)    = PS_TEXT('\0');
+      *PS_CoreAppend(Parser->VariableValue, Value, ValueEnd)  = PS_TEXT('\0');
+      Parser->Callback(Parser->Context, Parser->VariableName, Parser->VariableValue);
+    }
+  }
+
+  /* Skip the end of the line */
+  if (*p != PS_TEXT('\n'))
+  {
+    p = PS_CoreFind(p, End, PS_TEXT('\n'), PS_TEXT('\n'), PS_TEXT('\n'), PS_TEXT('\n'));
+    if (p == End)
+    {
+      Parser->State = PS_PARSER_READ_N;
+      return End;
+    }
+  }
+
+  Parser->Line++;
+
+  return (p + 1);
+}
+
+void PS_ParseConfiguration (PS_PARSER     *Parser,
+                            const PS_CHAR *Start,
+                            const PS_CHAR *End)
+{
+  const PS_CHAR *p = Start;
+  const PS_CHAR *Next;
+
+  /* Skip the Byte Order Mark, the UTF-8 one is converted to the same
+   * character */
+  if ((Parser->ExpectingBOM) && (p < End))
+  {
+#if defined(PS_BOM)
+    if (*p == PS_BOM)
+    {
+      p++;
+    }
+#endif
+    Parser->ExpectingBOM = 0;
+  }
+
+  while (p < End)
+  {
+    Next = NULL;
+
+    /* Beginning of a line */
+    if ((Parser->State == PS_PARSER_READ_NAME) && (Parser->Index == 0))
+    {
+      Next = PS_ParseLine(Parser, p, End);
+    }
+
+    p = (Next != NULL) ? Next : PS_ParseScalar(Parser, p, End, 1);
+  }
+}
+
+void PS_ParserFinish (PS_PARSER *Parser)
+{
+  if ((Parser->State == PS_PARSER_READ_VALUE) && (Parser->Index < PS_MAX_LINE_LENGTH))
+  {
+    Parser->VariableValue[Parser->Index] = PS_TEXT('\0');
+    Parser->State = PS_PARSER_READ_N;
+    Parser->Callback(Parser->Context, Parser->VariableName, Parser->VariableValue);
+  }
+}
@@ -0,0 +1,122 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-core.h                                           |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * Platform-neutral part of Plainstarter: location of the configuration file
+ * and parser of the configuration. The platform backends (plainstarter-win32.c
+ * and plainstarter-posix.c) provide the file system queries and process the
+ * variables through callbacks.
+ *
+ * Like plainstarter-env.h, the characters are UTF-16 on Windows and bytes
+ * elsewhere.
+ */
+
+#ifndef PLAINSTARTER_CORE_H
+#define PLAINSTARTER_CORE_H
+
+#include "plainstarter-env.h"
+
+/*-----------*/
+/* CONSTANTS */
+/*-----------*/
+
+/* Variable names or values longer than this are ignored */
+#define PS_MAX_LINE_LENGTH ((unsigned int)1024)
+
+#if defined(_WIN32)
+#define PS_LIST_SEPARATOR PS_TEXT(';')
+#define PS_PATH_SEPARATOR PS_TEXT('\\')
+#else
+#define PS_LIST_SEPARATOR PS_TEXT(':')
+#define PS_PATH_SEPARATOR PS_TEXT('/')
+#endif
+
+/*------------------*/
+/* TYPE DEFINITIONS */
+/*------------------*/
+
+/* Called for each candidate of the configuration file, return non-zero if
+ * the file exists */
+typedef int (*PS_PROBE_CALLBACK) (void *Context, const PS_CHAR *Filename);
+
+/* Called for each variable NAME=VALUE of the configuration */
+typedef void (*PS_VARIABLE_CALLBACK) (void          *Context,
+                                      const PS_CHAR *Name,
+                                      const PS_CHAR *Value);
+
+/* State of the configuration parser, kept between the chunks */
+typedef struct {
+  enum {
+    PS_PARSER_READ_NAME,
+    PS_PARSER_READ_VALUE,
+    PS_PARSER_READ_COMMENT,
+    PS_PARSER_READ_N
+  } State;
+  unsigned int          Index;
+  int                   ExpectingBOM;
+  unsigned int          Line;          /* Number of complete lines        */
+  unsigned int          OverlongCount; /* Lines ignored because too long  */
+  unsigned int          OverlongLine;  /* First of them, 0 if none        */
+  PS_VARIABLE_CALLBACK  Callback;
+  void                 *Context;
+  PS_CHAR               VariableName[PS_MAX_LINE_LENGTH];
+  PS_CHAR               VariableValue[PS_MAX_LINE_LENGTH + 1];
+} PS_PARSER;
+
+/*-----------*/
+/* FUNCTIONS */
+/*-----------*/
+
+/* Write the configuration filename in Buffer, return 0 if Buffer is too
+ * small.
+ * <path>/<Prefix>/<basename>.cfg
+ *
+ * Input : bin\starter-x86_64.exe
+ * Output: bin\[configs]\starter-x86_64.cfg
+ *
+ * Prefix is not null-terminated. When Prefix is an absolute directory (ie
+ * C:\configs, \\server\configs or /etc/configs), <path> is omitted. The
+ * extension of the executable is removed on Windows only.
+ */
+int PS_GetConfigFilename (const PS_CHAR *Prefix,
+                          size_t         PrefixLength,
+                          const PS_CHAR *Filename,
+                          PS_CHAR       *Buffer,
+                          size_t         BufferLength);
+
+/* Probe the candidates of SearchList, a list of directories separated by
+ * PS_LIST_SEPARATOR where an empty entry is the directory of Executable.
+ * Return non-zero if a configuration file is found, its name is in Buffer. */
+int PS_SearchConfigFilename (const PS_CHAR     *SearchList,
+                             const PS_CHAR     *Executable,
+                             PS_CHAR           *Buffer,
+                             size_t             BufferLength,
+                             PS_PROBE_CALLBACK  Probe,
+                             void              *Context);
+
+/* Initialize the parser before the first call to PS_ParseConfiguration */
+void PS_ParserInitialize (PS_PARSER            *Parser,
+                          PS_VARIABLE_CALLBACK  Callback,
+                          void                 *Context);
+
+/* Parse the characters from Start to End (excluded). The configuration can be
+ * given in several chunks: the state of the parser is kept between the calls,
+ * so that a line can span several chunks. The lines whose name or value has
+ * PS_MAX_LINE_LENGTH characters or more are ignored and counted in
+ * OverlongCount, the first one is OverlongLine (starting at 1). */
+void PS_ParseConfiguration (PS_PARSER     *Parser,
+                            const PS_CHAR *Start,
+                            const PS_CHAR *End);
+
+/* End of the configuration: process the last line if it is not terminated by
+ * a new line */
+void PS_ParserFinish (PS_PARSER *Parser);
+
+#endif
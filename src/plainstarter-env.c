@@ -0,0 +1,869 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-env.c                                            |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * The variables are stored in a hash table with open addressing and linear
+ * probing. The entries are strings "NAME=VALUE": the entries inherited from
+ * the parent process point to the block of the parent environment, only the
+ * entries set by the configuration are allocated. The deleted entries are
+ * marked and reused; the table is rebuilt when it is 3/4 full.
+ *
+ * On Windows, the names are compared without case for the ASCII letters only,
+ * the other characters are compared exactly. The environment blocks of Windows
+ * are sorted the same way.
+ */
+
+#include "plainstarter-env.h"
+
+/*---------------------*/
+/* INCLUDES AND MACROS */
+/*---------------------*/
+
+#if defined(_WIN32)
+#define PS_ENV_ALLOC(Size)       HeapAlloc(GetProcessHeap(), 0, (Size))
+#define PS_ENV_REALLOC(Ptr,Size) HeapReAlloc(GetProcessHeap(), 0, (Ptr), (Size))
+#define PS_ENV_FREE(Ptr)         HeapFree(GetProcessHeap(), 0, (Ptr))
+#else
+#include <stdlib.h>
+#define PS_ENV_ALLOC(Size)       malloc(Size)
+#define PS_ENV_REALLOC(Ptr,Size) realloc((Ptr), (Size))
+#define PS_ENV_FREE(Ptr)         free(Ptr)
+#endif
+
+/*-----------*/
+/* CONSTANTS */
+/*-----------*/
+
+#define PS_ENV_SLOT_USED      ((unsigned int)0x01)
+#define PS_ENV_SLOT_DELETED   ((unsigned int)0x02)
+#define PS_ENV_SLOT_ALLOCATED ((unsigned int)0x04)
+
+#define PS_ENV_INITIAL_CAPACITY ((size_t)256)
+
+#define PS_ENV_FNV_OFFSET_BASIS ((unsigned int)2166136261u)
+#define PS_ENV_FNV_PRIME        ((unsigned int)16777619u)
+
+/*------------------*/
+/* STRING FUNCTIONS */
+/*------------------*/
+
+size_t PS_StringLength (const PS_CHAR *String)
+{
+  const PS_CHAR *p = String;
+
+  while (*p)
+  {
+    p++;
+  }
+
+  return (size_t)(p - String);
+}
+
+/* Ensure that String can contain Capacity characters, the null character
+ * included */
+int PS_StringReserve (PS_STRING *String, size_t Capacity)
+{
+  PS_CHAR *NewData;
+  size_t   NewCapacity;
+  int      Success = 1;
+
+  if (Capacity > String->Capacity)
+  {
+    NewCapacity = (String->Capacity * 2) + 256;
+    if (NewCapacity < Capacity)
+    {
+      NewCapacity = Capacity;
+    }
+
+    if (String->Data == NULL)
+    {
+      NewData = PS_ENV_ALLOC(NewCapacity * sizeof(PS_CHAR));
+    }
+    else
+    {
+      NewData = PS_ENV_REALLOC(String->Data, (NewCapacity * sizeof(PS_CHAR)));
+    }
+
+    if (NewData == NULL)
+    {
+      Success = 0;
+    }
+    else
+    {
+      String->Data     = NewData;
+      String->Capacity = NewCapacity;
+    }
+  }
+
+  return Success;
+}
+
+int PS_StringAppendN (PS_STRING     *String,
+                      const PS_CHAR *Data,
+                      size_t         Length)
+{
+  PS_CHAR *po;
+  size_t   Index;
+  int      Success;
+
+  Success = PS_StringReserve(String, (String->Length + Length + 1));
+  if (Success)
+  {
+    po = String->Data + String->Length;
+    for (Index = 0 ; Index < Length ; Index++)
+    {
+      po[Index] = Data[Index];
+    }
+    po[Length]      = 0;
+    String->Length += Length;
+  }
+
+  return Success;
+}
+
+void PS_StringFree (PS_STRING *String)
+{
+  if (String->Data != NULL)
+  {
+    PS_ENV_FREE(String->Data);
+  }
+
+  String->Data     = NULL;
+  String->Length   = 0;
+  String->Capacity = 0;
+}
+
+/*-----------------*/
+/* TABLE FUNCTIONS */
+/*-----------------*/
+
+static PS_CHAR PS_EnvFold (PS_CHAR Char)
+{
+#if PS_ENV_IGNORE_CASE
+  if ((Char >= 'a') && (Char <= 'z'))
+  {
+    Char = (PS_CHAR)(Char - ('a' - 'A'));
+  }
+#endif
+
+  return Char;
+}
+
+/* FNV-1a of the folded name */
+static unsigned int PS_EnvHash (const PS_CHAR *Name, size_t NameLength)
+{
+  unsigned int Hash = PS_ENV_FNV_OFFSET_BASIS;
+  size_t       Index;
+
+  for (Index = 0 ; Index < NameLength ; Index++)
+  {
+    Hash = (Hash ^ (unsigned int)PS_EnvFold(Name[Index])) * PS_ENV_FNV_PRIME;
+  }
+
+  return Hash;
+}
+
+/* Compare the names like the sorting of the Windows environment blocks:
+ * negative, zero or positive */
+static int PS_EnvCompareNames (const PS_CHAR *Name1, size_t Length1,
+                               const PS_CHAR *Name2, size_t Length2)
+{
+  size_t  Index  = 0;
+  int     Result = 0;
+  PS_CHAR Char1;
+  PS_CHAR Char2;
+
+  while ((Result == 0) && (Index < Length1) && (Index < Length2))
+  {
+    Char1 = PS_EnvFold(Name1[Index]);
+    Char2 = PS_EnvFold(Name2[Index]);
+
+    if (Char1 != Char2)
+    {
+      Result = (Char1 < Char2) ? -1 : 1;
+    }
+    Index++;
+  }
+
+  if (Result == 0)
+  {
+    if (Length1 < Length2)
+    {
+      Result = -1;
+    }
+    else if (Length1 > Length2)
+    {
+      Result = 1;
+    }
+  }
+
+  return Result;
+}
+
+/* Return the slot of Name, or NULL if it is not defined */
+static PS_ENV_SLOT *PS_EnvFind (const PS_ENV  *Env,
+                                const PS_CHAR *Name,
+                                size_t         NameLength,
+                                unsigned int   Hash)
+{
+  PS_ENV_SLOT *Slot;
+  PS_ENV_SLOT *Found = NULL;
+  size_t       Mask  = Env->Capacity - 1;
+  size_t       Index = Hash & Mask;
+
+  Slot = &Env->Slots[Index];
+  while ((Found == NULL) && (Slot->Flags != 0))
+  {
+    if ((Slot->Flags & PS_ENV_SLOT_USED)
+        && (Slot->Hash == Hash)
+        && (PS_EnvCompareNames(Slot->String, Slot->NameLength, Name, NameLength) == 0))
+    {
+      Found = Slot;
+    }
+    else
+    {
+      Index = (Index + 1) & Mask;
+      Slot  = &Env->Slots[Index];
+    }
+  }
+
+  return Found;
+}
+
+/* Allocate the slots, all of them empty */
+static PS_ENV_SLOT *PS_EnvAllocateSlots (size_t Capacity)
+{
+  PS_ENV_SLOT *Slots;
+  size_t       Index;
+
+  Slots = PS_ENV_ALLOC(Capacity * sizeof(PS_ENV_SLOT));
+  if (Slots != NULL)
+  {
+    for (Index = 0 ; Index < Capacity ; Index++)
+    {
+      Slots[Index].String     = NULL;
+      Slots[Index].NameLength = 0;
+      Slots[Index].Hash       = 0;
+      Slots[Index].Flags      = 0;
+    }
+  }
+
+  return Slots;
+}
+
+/* Rebuild the table with the double capacity, dropping the deleted slots */
+static int PS_EnvGrow (PS_ENV *Env)
+{
+  PS_ENV_SLOT *OldSlots    = Env->Slots;
+  size_t       OldCapacity = Env->Capacity;
+  size_t       NewCapacity = OldCapacity * 2;
+  size_t       Mask        = NewCapacity - 1;
+  size_t       Index;
+  size_t       NewIndex;
+  PS_ENV_SLOT *NewSlots;
+  int          Success     = 0;
+
+  NewSlots = PS_EnvAllocateSlots(NewCapacity);
+  if (NewSlots != NULL)
+  {
+    for (Index = 0 ; Index < OldCapacity ; Index++)
+    {
+      if (OldSlots[Index].Flags & PS_ENV_SLOT_USED)
+      {
+        NewIndex = OldSlots[Index].Hash & Mask;
+        while (NewSlots[NewIndex].Flags != 0)
+        {
+          NewIndex = (NewIndex + 1) & Mask;
+        }
+        NewSlots[NewIndex] = OldSlots[Index];
+      }
+    }
+
+    PS_ENV_FREE(OldSlots);
+
+    Env->Slots    = NewSlots;
+    Env->Capacity = NewCapacity;
+    Env->Used     = Env->Count;
+    Success       = 1;
+  }
+
+  return Success;
+}
+
+/* Insert or replace the entry String. Allocated tells if the string belongs to
+ * the table. */
+static int PS_EnvStore (PS_ENV        *Env,
+                        const PS_CHAR *String,
+                        size_t         NameLength,
+                        unsigned int   Allocated)
+{
+  unsigned int  Hash = PS_EnvHash(String, NameLength);
+  PS_ENV_SLOT  *Slot;
+  PS_ENV_SLOT  *Free = NULL;
+  size_t        Mask;
+  size_t        Index;
+  int           Success = 1;
+
+  Slot = PS_EnvFind(Env, String, NameLength, Hash);
+  if (Slot != NULL)
+  {
+    if (Slot->Flags & PS_ENV_SLOT_ALLOCATED)
+    {
+      PS_ENV_FREE((PS_CHAR *)Slot->String);
+    }
+  }
+  else
+  {
+    if (((Env->Used + 1) * 4) > (Env->Capacity * 3))
+    {
+      Success = PS_EnvGrow(Env);
+    }
+
+    if (Success)
+    {
+      /* First deleted or empty slot */
+      Mask  = Env->Capacity - 1;
+      Index = Hash & Mask;
+      while (Free == NULL)
+      {
+        if ((Env->Slots[Index].Flags & PS_ENV_SLOT_USED) == 0)
+        {
+          Free = &Env->Slots[Index];
+        }
+        Index = (Index + 1) & Mask;
+      }
+
+      if (Free->Flags == 0)
+      {
+        Env->Used++;
+      }
+      Env->Count++;
+      Slot = Free;
+    }
+  }
+
+  if (Success)
+  {
+    Slot->String     = String;
+    Slot->NameLength = NameLength;
+    Slot->Hash       = Hash;
+    Slot->Flags      = PS_ENV_SLOT_USED | Allocated;
+  }
+
+  return Success;
+}
+
+int PS_EnvInitialize (PS_ENV *Env)
+{
+  Env->Slots    = PS_EnvAllocateSlots(PS_ENV_INITIAL_CAPACITY);
+  Env->Capacity = PS_ENV_INITIAL_CAPACITY;
+  Env->Count    = 0;
+  Env->Used     = 0;
+
+  return (Env->Slots != NULL);
+}
+
+void PS_EnvFree (PS_ENV *Env)
+{
+  size_t Index;
+
+  for (Index = 0 ; Index < Env->Capacity ; Index++)
+  {
+    if (Env->Slots[Index].Flags & PS_ENV_SLOT_ALLOCATED)
+    {
+      PS_ENV_FREE((PS_CHAR *)Env->Slots[Index].String);
+    }
+  }
+
+  PS_ENV_FREE(Env->Slots);
+
+  Env->Slots    = NULL;
+  Env->Capacity = 0;
+  Env->Count    = 0;
+  Env->Used     = 0;
+}
+
+int PS_EnvImportString (PS_ENV *Env, const PS_CHAR *String)
+{
+  size_t NameLength;
+  int    Success = 1;
+
+  /* The name of the hidden variables of Windows starts with '=' */
+  NameLength = 1;
+  while ((String[NameLength]) && (String[NameLength] != '='))
+  {
+    NameLength++;
+  }
+
+  if ((String[0]) && (String[NameLength] == '='))
+  {
+    Success = PS_EnvStore(Env, String, NameLength, 0);
+  }
+
+  return Success;
+}
+
+int PS_EnvImportBlock (PS_ENV *Env, const PS_CHAR *Block)
+{
+  const PS_CHAR *p       = Block;
+  int            Success = 1;
+
+  while ((*p) && (Success))
+  {
+    Success = PS_EnvImportString(Env, p);
+    p      += PS_StringLength(p) + 1;
+  }
+
+  return Success;
+}
+
+const PS_CHAR *PS_EnvGet (const PS_ENV  *Env,
+                          const PS_CHAR *Name,
+                          size_t         NameLength)
+{
+  const PS_ENV_SLOT *Slot;
+  const PS_CHAR     *Value = NULL;
+
+  Slot = PS_EnvFind(Env, Name, NameLength, PS_EnvHash(Name, NameLength));
+  if (Slot != NULL)
+  {
+    Value = Slot->String + Slot->NameLength + 1;
+  }
+
+  return Value;
+}
+
+int PS_EnvSet (PS_ENV        *Env,
+               const PS_CHAR *Name,
+               const PS_CHAR *Value)
+{
+  size_t       NameLength = PS_StringLength(Name);
+  size_t       ValueLength;
+  PS_ENV_SLOT *Slot;
+  PS_CHAR     *String;
+  size_t       Index;
+  int          Success = 1;
+
+  if (Value == NULL)
+  {
+    Slot = PS_EnvFind(Env, Name, NameLength, PS_EnvHash(Name, NameLength));
+    if (Slot != NULL)
+    {
+      if (Slot->Flags & PS_ENV_SLOT_ALLOCATED)
+      {
+        PS_ENV_FREE((PS_CHAR *)Slot->String);
+      }
+      Slot->String = NULL;
+      Slot->Flags  = PS_ENV_SLOT_DELETED;
+      Env->Count--;
+    }
+  }
+  else
+  {
+    ValueLength = PS_StringLength(Value);
+
+    String = PS_ENV_ALLOC((NameLength + ValueLength + 2) * sizeof(PS_CHAR));
+    if (String == NULL)
+    {
+      Success = 0;
+    }
+    else
+    {
+      for (Index = 0 ; Index < NameLength ; Index++)
+      {
+        String[Index] = Name[Index];
+      }
+      String[NameLength] = '=';
+      for (Index = 0 ; Index <= ValueLength ; Index++)
+      {
+        String[NameLength + 1 + Index] = Value[Index];
+      }
+
+      Success = PS_EnvStore(Env, String, NameLength, PS_ENV_SLOT_ALLOCATED);
+      if (!Success)
+      {
+        PS_ENV_FREE(String);
+      }
+    }
+  }
+
+  return Success;
+}
+
+/*--------------------*/
+/* EXPANSION FUNCTION */
+/*--------------------*/
+
+/* Record the first undefined reference */
+static void PS_EnvReportUndefined (PS_EXPAND_REPORT *Report,
+                                   const PS_CHAR    *Name,
+                                   size_t            NameLength)
+{
+  if (Report != NULL)
+  {
+    if (Report->UndefinedCount == 0)
+    {
+      Report->FirstUndefined       = Name;
+      Report->FirstUndefinedLength = NameLength;
+    }
+    Report->UndefinedCount++;
+  }
+}
+
+int PS_EnvExpand (const PS_ENV     *Env,
+                  const PS_CHAR    *In,
+                  unsigned int      Flags,
+                  PS_STRING        *Out,
+                  PS_EXPAND_REPORT *Report)
+{
+  const PS_CHAR *p = In;
+  const PS_CHAR *RunStart;
+  const PS_CHAR *NameEnd;
+  const PS_CHAR *Value;
+  size_t         NameLength;
+  int            Percent = ((Flags & PS_EXPAND_PERCENT) != 0);
+  int            Braces  = ((Flags & PS_EXPAND_BRACES) != 0);
+  int            Success;
+
+  Out->Length = 0;
+  Success     = PS_StringReserve(Out, (PS_StringLength(In) + 1));
+  if (Success)
+  {
+    Out->Data[0] = 0;
+  }
+
+  while ((*p) && (Success))
+  {
+    /* Copy the characters up to the next reference at once */
+    RunStart = p;
+    while ((*p)
+           && ((*p != '%') || (Percent == 0))
+           && ((*p != '$') || (Braces == 0)))
+    {
+      p++;
+    }
+    if (p > RunStart)
+    {
+      Success = PS_StringAppendN(Out, RunStart, (size_t)(p - RunStart));
+    }
+
+    if ((*p == '%') && (Success))
+    {
+      Value   = NULL;
+      NameEnd = p + 1;
+      while ((*NameEnd) && (*NameEnd != '%'))
+      {
+        NameEnd++;
+      }
+
+      NameLength = (size_t)(NameEnd - (p + 1));
+      if ((*NameEnd == '%') && (NameLength > 0))
+      {
+        Value = PS_EnvGet(Env, (p + 1), NameLength);
+        if (Value == NULL)
+        {
+          PS_EnvReportUndefined(Report, (p + 1), NameLength);
+        }
+      }
+
+      if (Value != NULL)
+      {
+        Success = PS_StringAppendN(Out, Value, PS_StringLength(Value));
+        p       = NameEnd + 1;
+      }
+      else
+      {
+        /* Keep the '%', the closing one can start another reference */
+        Success = PS_StringAppendN(Out, p, 1);
+        p++;
+      }
+    }
+    else if ((*p == '$') && (Success))
+    {
+      NameEnd = p + 1;
+      if (*NameEnd == '{')
+      {
+        NameEnd++;
+        while ((*NameEnd) && (*NameEnd != '}'))
+        {
+          NameEnd++;
+        }
+      }
+
+      NameLength = (size_t)(NameEnd - (p + 2));
+      if ((p[1] == '{') && (*NameEnd == '}') && (NameLength > 0))
+      {
+        Value = PS_EnvGet(Env, (p + 2), NameLength);
+        if (Value == NULL)
+        {
+          PS_EnvReportUndefined(Report, (p + 2), NameLength);
+        }
+        else
+        {
+          Success = PS_StringAppendN(Out, Value, PS_StringLength(Value));
+        }
+        p = NameEnd + 1;
+      }
+      else
+      {
+        /* Not a reference, keep the '$' */
+        Success = PS_StringAppendN(Out, p, 1);
+        p++;
+      }
+    }
+  }
+
+  return Success;
+}
+
+/*----------------*/
+/* LIST FUNCTIONS */
+/*----------------*/
+
+/* Length of Entry without its trailing path separator, kept for a root
+ * directory (ie "C:\" or "/") */
+static size_t PS_ListTrim (const PS_CHAR *Entry, size_t Length)
+{
+#if defined(_WIN32)
+  if ((Length > 1)
+      && ((Entry[Length - 1] == PS_TEXT('\\')) || (Entry[Length - 1] == PS_TEXT('/')))
+      && (Entry[Length - 2] != PS_TEXT(':')))
+#else
+  if ((Length > 1) && (Entry[Length - 1] == PS_TEXT('/')))
+#endif
+  {
+    Length--;
+  }
+
+  return Length;
+}
+
+/* Return non-zero if the list of Length characters contains Entry */
+static int PS_ListContains (const PS_CHAR *List,
+                            size_t         Length,
+                            PS_CHAR        Separator,
+                            const PS_CHAR *Entry,
+                            size_t         EntryLength)
+{
+  const PS_CHAR *p     = List;
+  const PS_CHAR *End   = List + Length;
+  const PS_CHAR *Start;
+  int            Found = 0;
+
+  while ((Found == 0) && (p < End))
+  {
+    Start = p;
+    while ((p < End) && (*p != Separator))
+    {
+      p++;
+    }
+
+    Found = (PS_EnvCompareNames(Start, PS_ListTrim(Start, (size_t)(p - Start)),
+                                Entry, EntryLength) == 0);
+    p++;
+  }
+
+  return Found;
+}
+
+/* Append the entries of Source to Out, except the ones of Exclude (can be
+ * NULL) */
+static int PS_ListAppend (PS_STRING      *Out,
+                          const PS_CHAR  *Source,
+                          const PS_CHAR  *Exclude,
+                          PS_CHAR         Separator,
+                          PS_LIST_FILTER  Filter,
+                          void           *Context)
+{
+  const PS_CHAR *p       = Source;
+  const PS_CHAR *Start;
+  size_t         Length;
+  int            Success = 1;
+
+  while ((Success) && (*p))
+  {
+    Start = p;
+    while ((*p) && (*p != Separator))
+    {
+      p++;
+    }
+
+    Length = PS_ListTrim(Start, (size_t)(p - Start));
+
+    if ((Length > 0)
+        && ((Exclude == NULL)
+            || (PS_ListContains(Exclude, PS_StringLength(Exclude), Separator, Start, Length) == 0))
+        && (PS_ListContains(Out->Data, Out->Length, Separator, Start, Length) == 0)
+        && ((Filter == NULL) || Filter(Context, Start, Length)))
+    {
+      if (Out->Length > 0)
+      {
+        Success = PS_StringAppendN(Out, &Separator, 1);
+      }
+      Success = Success && PS_StringAppendN(Out, Start, (size_t)(p - Start));
+    }
+
+    if (*p)
+    {
+      p++;
+    }
+  }
+
+  return Success;
+}
+
+int PS_EnvUpdateList (const PS_CHAR  *List,
+                      const PS_CHAR  *Entries,
+                      unsigned int    Operation,
+                      PS_CHAR         Separator,
+                      PS_LIST_FILTER  Filter,
+                      void           *Context,
+                      PS_STRING      *Out)
+{
+  int Success;
+
+  if (List == NULL)
+  {
+    List = PS_TEXT("");
+  }
+
+  Out->Length = 0;
+  Success     = PS_StringAppendN(Out, PS_TEXT(""), 0);
+
+  switch (Operation)
+  {
+  case PS_LIST_PREPEND:
+    Success = Success
+      && PS_ListAppend(Out, Entries, NULL, Separator, Filter, Context)
+      && PS_ListAppend(Out, List, NULL, Separator, Filter, Context);
+    break;
+
+  case PS_LIST_REMOVE:
+    Success = Success
+      && PS_ListAppend(Out, List, Entries, Separator, Filter, Context);
+    break;
+
+  default:
+    Success = Success
+      && PS_ListAppend(Out, List, NULL, Separator, Filter, Context)
+      && PS_ListAppend(Out, Entries, NULL, Separator, Filter, Context);
+    break;
+  }
+
+  return Success;
+}
+
+/*-----------------*/
+/* BLOCK FUNCTIONS */
+/*-----------------*/
+
+PS_CHAR *PS_EnvBuildBlock (const PS_ENV *Env)
+{
+  const PS_ENV_SLOT **Sorted;
+  const PS_ENV_SLOT  *Slot;
+  size_t              BlockLength = 1;
+  size_t              Count       = 0;
+  size_t              Gap;
+  size_t              Index;
+  size_t              Position;
+  size_t              Length;
+  PS_CHAR            *Block       = NULL;
+  PS_CHAR            *p;
+
+  Sorted = PS_ENV_ALLOC((Env->Count + 1) * sizeof(PS_ENV_SLOT *));
+  if (Sorted != NULL)
+  {
+    for (Index = 0 ; Index < Env->Capacity ; Index++)
+    {
+      if (Env->Slots[Index].Flags & PS_ENV_SLOT_USED)
+      {
+        Sorted[Count++] = &Env->Slots[Index];
+        BlockLength    += PS_StringLength(Env->Slots[Index].String) + 1;
+      }
+    }
+
+    /* Shell sort with the gaps 3h+1 */
+    Gap = 1;
+    while (Gap < (Count / 3))
+    {
+      Gap = (3 * Gap) + 1;
+    }
+
+    while (Gap > 0)
+    {
+      for (Index = Gap ; Index < Count ; Index++)
+      {
+        Slot     = Sorted[Index];
+        Position = Index;
+        while ((Position >= Gap)
+               && (PS_EnvCompareNames(Sorted[Position - Gap]->String, Sorted[Position - Gap]->NameLength,
+                                      Slot->String, Slot->NameLength) > 0))
+        {
+          Sorted[Position] = Sorted[Position - Gap];
+          Position        -= Gap;
+        }
+        Sorted[Position] = Slot;
+      }
+      Gap = Gap / 3;
+    }
+
+    Block = PS_ENV_ALLOC(BlockLength * sizeof(PS_CHAR));
+    if (Block != NULL)
+    {
+      p = Block;
+      for (Index = 0 ; Index < Count ; Index++)
+      {
+        Length = PS_StringLength(Sorted[Index]->String) + 1;
+        for (Position = 0 ; Position < Length ; Position++)
+        {
+          p[Position] = Sorted[Index]->String[Position];
+        }
+        p += Length;
+      }
+      *p = 0;
+    }
+
+    PS_ENV_FREE(Sorted);
+  }
+
+  return Block;
+}
+
+void PS_EnvFreeBlock (PS_CHAR *Block)
+{
+  PS_ENV_FREE(Block);
+}
+
+PS_CHAR **PS_EnvBuildArray (const PS_ENV *Env)
+{
+  PS_CHAR **Array;
+  size_t    Count = 0;
+  size_t    Index;
+
+  Array = PS_ENV_ALLOC((Env->Count + 1) * sizeof(PS_CHAR *));
+  if (Array != NULL)
+  {
+    for (Index = 0 ; Index < Env->Capacity ; Index++)
+    {
+      if (Env->Slots[Index].Flags & PS_ENV_SLOT_USED)
+      {
+        Array[Count++] = (PS_CHAR *)Env->Slots[Index].String;
+      }
+    }
+    Array[Count] = NULL;
+  }
+
+  return Array;
+}
+
+void PS_EnvFreeArray (PS_CHAR **Array)
+{
+  PS_ENV_FREE(Array);
+}
@@ -0,0 +1,183 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-env.h                                            |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * Environment variables table and expansion of the references to variables.
+ *
+ * This unit does not depend on the C runtime on Windows and is plain C on the
+ * other systems, so that it can be built and measured on Linux. On Windows the
+ * characters are UTF-16 and the names are case-insensitive, elsewhere the
+ * characters are bytes and the names are case-sensitive.
+ */
+
+#ifndef PLAINSTARTER_ENV_H
+#define PLAINSTARTER_ENV_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+
+#ifndef UNICODE
+#define UNICODE
+#define _UNICODE
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+typedef WCHAR PS_CHAR;
+#define PS_TEXT(String)    L##String
+#define PS_ENV_IGNORE_CASE 1
+
+#else
+
+typedef char PS_CHAR;
+#define PS_TEXT(String)    String
+#define PS_ENV_IGNORE_CASE 0
+
+#endif
+
+/*------------------*/
+/* TYPE DEFINITIONS */
+/*------------------*/
+
+/* Growable string, the lengths are counted in characters. Data is always
+ * null-terminated once something has been written. */
+typedef struct {
+  PS_CHAR *Data;
+  size_t   Length;
+  size_t   Capacity;
+} PS_STRING;
+
+/* Slot of the hash table, String is "NAME=VALUE" */
+typedef struct {
+  const PS_CHAR *String;
+  size_t         NameLength;
+  unsigned int   Hash;
+  unsigned int   Flags;
+} PS_ENV_SLOT;
+
+/* Hash table with open addressing, Capacity is a power of two */
+typedef struct {
+  PS_ENV_SLOT *Slots;
+  size_t       Capacity;
+  size_t       Count;
+  size_t       Used;
+} PS_ENV;
+
+/* Syntaxes of the references given to PS_EnvExpand */
+#define PS_EXPAND_PERCENT ((unsigned int)0x01) /* %NAME% */
+#define PS_EXPAND_BRACES  ((unsigned int)0x02) /* ${NAME} */
+
+/* Operations of PS_EnvUpdateList */
+#define PS_LIST_APPEND  ((unsigned int)1) /* NAME+=VALUE */
+#define PS_LIST_PREPEND ((unsigned int)2) /* NAME^=VALUE */
+#define PS_LIST_REMOVE  ((unsigned int)3) /* NAME-=VALUE */
+
+/* Called for each entry kept by PS_EnvUpdateList, return 0 to drop it. Entry
+ * is not null-terminated. */
+typedef int (*PS_LIST_FILTER) (void          *Context,
+                               const PS_CHAR *Entry,
+                               size_t         Length);
+
+/* Result of PS_EnvExpand regarding the undefined variables */
+typedef struct {
+  size_t         UndefinedCount;
+  const PS_CHAR *FirstUndefined;
+  size_t         FirstUndefinedLength;
+} PS_EXPAND_REPORT;
+
+/*-----------*/
+/* FUNCTIONS */
+/*-----------*/
+
+/* All the functions returning int return 0 when the memory allocation
+ * fails, 1 otherwise. */
+
+int PS_StringReserve (PS_STRING *String, size_t Capacity);
+
+int PS_StringAppendN (PS_STRING     *String,
+                      const PS_CHAR *Data,
+                      size_t         Length);
+
+void PS_StringFree (PS_STRING *String);
+
+size_t PS_StringLength (const PS_CHAR *String);
+
+int PS_EnvInitialize (PS_ENV *Env);
+
+/* Release the table and the strings set with PS_EnvSet */
+void PS_EnvFree (PS_ENV *Env);
+
+/* Import a block "NAME=VALUE\0NAME=VALUE\0\0" such as the one returned by
+ * GetEnvironmentStrings. The strings are referenced, not copied: the block
+ * must remain valid. */
+int PS_EnvImportBlock (PS_ENV *Env, const PS_CHAR *Block);
+
+/* Import a single "NAME=VALUE" string, referenced and not copied */
+int PS_EnvImportString (PS_ENV *Env, const PS_CHAR *String);
+
+/* Return the value of the variable or NULL if it is not defined */
+const PS_CHAR *PS_EnvGet (const PS_ENV  *Env,
+                          const PS_CHAR *Name,
+                          size_t         NameLength);
+
+/* Set the variable, the strings are copied. A NULL Value deletes the
+ * variable. */
+int PS_EnvSet (PS_ENV        *Env,
+               const PS_CHAR *Name,
+               const PS_CHAR *Value);
+
+/* Expand the references of In into Out, in a single pass. Flags selects the
+ * syntaxes of the references:
+ * - PS_EXPAND_PERCENT: %NAME%, the undefined references are kept as-is and
+ *   their closing '%' can start another reference, like
+ *   ExpandEnvironmentStrings.
+ * - PS_EXPAND_BRACES: ${NAME}, the undefined references are replaced by an
+ *   empty string, like the POSIX shells.
+ * Report can be NULL. */
+int PS_EnvExpand (const PS_ENV     *Env,
+                  const PS_CHAR    *In,
+                  unsigned int      Flags,
+                  PS_STRING        *Out,
+                  PS_EXPAND_REPORT *Report);
+
+/* Combine the list List (can be NULL) with the entries of Entries into Out,
+ * the entries are separated by Separator:
+ * - PS_LIST_APPEND: List followed by Entries
+ * - PS_LIST_PREPEND: Entries followed by List
+ * - PS_LIST_REMOVE: List without Entries
+ * The empty entries and the duplicates are dropped, the first occurrence is
+ * kept. The entries are compared like the names of the variables, without a
+ * trailing path separator. Filter can be NULL. */
+int PS_EnvUpdateList (const PS_CHAR  *List,
+                      const PS_CHAR  *Entries,
+                      unsigned int    Operation,
+                      PS_CHAR         Separator,
+                      PS_LIST_FILTER  Filter,
+                      void           *Context,
+                      PS_STRING      *Out);
+
+/* Return a new allocated block "NAME=VALUE\0...\0\0" sorted by name, to be
+ * released with PS_EnvFreeBlock, or NULL */
+PS_CHAR *PS_EnvBuildBlock (const PS_ENV *Env);
+
+void PS_EnvFreeBlock (PS_CHAR *Block);
+
+/* Return a new allocated array of the strings "NAME=VALUE" terminated by
+ * NULL, such as the environment given to execve, to be released with
+ * PS_EnvFreeArray, or NULL. The strings still belong to the table. */
+PS_CHAR **PS_EnvBuildArray (const PS_ENV *Env);
+
+void PS_EnvFreeArray (PS_CHAR **Array);
+
+#endif
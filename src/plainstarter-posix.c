@@ -0,0 +1,716 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-posix.c                                          |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * POSIX backend of Plainstarter, for Linux hosts. It reads the same
+ * configuration files as the Windows version, encoded in UTF-8:
+ *
+ * PLAINSTARTER_OPTIONS=option-1 option-2
+ * PATH=${PLAINSTARTER_DIRECTORY}/bin:${PATH}
+ * PLAINSTARTER_CMD_LINE="${PLAINSTARTER_DIRECTORY}/bin/my-app" --verbose
+ *
+ * The executable locates itself with /proc/self/exe: my-app will try to load
+ * the configuration file "configs/my-app.cfg", then "config/my-app.cfg" and
+ * finally "my-app.cfg", relative to its directory. The extension of the
+ * executable is not removed. The list of directories can be changed with the
+ * environment variable PLAINSTARTER_CONFIG_DIRS, ie "configs:/etc/configs:".
+ *
+ * The variables are referenced with %NAME% or ${NAME}. An undefined %NAME% is
+ * kept as-is like on Windows, an undefined ${NAME} is replaced by an empty
+ * string like in the POSIX shells.
+ *
+ * The lists separated by ':' such as PATH are updated without duplicates with
+ * NAME^=VALUE (prepend), NAME+=VALUE (append) and NAME-=VALUE (remove).
+ *
+ * PLAINSTARTER_CMD_LINE is split into arguments like a shell would do with
+ * the quotes '...' and "..." and the backslash, without any other expansion.
+ * The parameters given to Plainstarter are appended unchanged, they are never
+ * expanded. The program is searched in the PATH given to the child process.
+ *
+ * By default, Plainstarter replaces itself with the program (execve): there
+ * is no intermediate process and the lines following PLAINSTARTER_CMD_LINE
+ * are not processed. With the option monitor-process, the program is started
+ * with posix_spawn, Plainstarter waits for it and returns its exit code.
+ *
+ * PLAINSTARTER_OPTIONS
+ * monitor-process
+ * debug
+ * report-undefined
+ * prune-missing-dirs
+ */
+
+/*---------------------*/
+/* INCLUDES AND MACROS */
+/*---------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "plainstarter-core.h"
+
+extern char **environ;
+
+/*-----------*/
+/* CONSTANTS */
+/*-----------*/
+
+/* Ordered list of the directories containing the configuration file, relative
+ * to the executable directory. Can be overridden with the environment variable
+ * PLAINSTARTER_CONFIG_DIRS. An empty entry is the executable directory. */
+static const char *PS_CONFIG_SEARCH_LIST = "configs/:config/:";
+static const char *PS_CMD_LINE           = "PLAINSTARTER_CMD_LINE";
+
+static const char *PS_UNEXPECTED_ERROR = "Unexpected error";
+
+/* Exit codes of the shells when the program cannot be executed */
+#define PS_EXIT_NOT_EXECUTABLE 126
+#define PS_EXIT_NOT_FOUND      127
+
+/*------------------*/
+/* TYPE DEFINITIONS */
+/*------------------*/
+
+/* Parameters given to Plainstarter, forwarded by the parser callback, and
+ * the parser itself */
+typedef struct {
+  int              argc;
+  char           **argv;
+  const PS_PARSER *Parser;
+} PS_SM_CONTEXT;
+
+/*------------------*/
+/* GLOBAL VARIABLES */
+/*------------------*/
+
+static int PS_OPTION_MONITOR_PROCESS    = 0;
+static int PS_OPTION_DEBUG              = 0;
+static int PS_OPTION_REPORT_UNDEFINED   = 0;
+static int PS_OPTION_PRUNE_MISSING_DIRS = 0;
+static int PS_LAST_EXEC_CODE            = EXIT_SUCCESS;
+
+static PS_ENV     PS_Environment;
+static PS_STRING  PS_Expanded;
+static char      *PS_ConfigFilename = NULL;
+
+/*-------------------*/
+/* UTILITY FUNCTIONS */
+/*-------------------*/
+
+/* The error identifiers are shared with the Windows version */
+static void PS_MessageAndExit (int         ErrorId,
+                               const char *Message,
+                               int         ErrorCode)
+{
+  fprintf(stderr, "plainstarter: Error#%02d: %s\n", ErrorId, Message);
+  exit(ErrorCode);
+}
+
+static void *PS_Allocate (size_t Size)
+{
+  void *Memory = malloc(Size);
+
+  if (Memory == NULL)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  return Memory;
+}
+
+/*----------------*/
+/* MAIN FUNCTIONS */
+/*----------------*/
+
+/* Return a new allocated string with the absolute filename of the
+ * executable */
+static char *PS_LocateBinary (void)
+{
+  size_t   Size = 256;
+  ssize_t  Length;
+  char    *Buffer;
+
+  for (;;)
+  {
+    Buffer = PS_Allocate(Size);
+    Length = readlink("/proc/self/exe", Buffer, Size);
+    if (Length < 0)
+    {
+      free(Buffer);
+      Buffer = NULL;
+      break;
+    }
+    else if ((size_t)Length < Size)
+    {
+      Buffer[Length] = '\0';
+      break;
+    }
+
+    /* Truncated, retry with a larger buffer */
+    free(Buffer);
+    Size = Size * 2;
+  }
+
+  return Buffer;
+}
+
+static int PS_ProbeConfigFilename (void *Context, const char *Filename)
+{
+  struct stat Info;
+
+  (void)Context;
+
+  return (stat(Filename, &Info) == 0) && S_ISREG(Info.st_mode);
+}
+
+/* Return a new allocated string with the filename of the first configuration
+ * file found, or NULL */
+static char *PS_FindConfigFilename (const char *Executable)
+{
+  const char *SearchList;
+  size_t      BufferLength;
+  char       *Buffer;
+
+  SearchList = getenv("PLAINSTARTER_CONFIG_DIRS");
+  if ((SearchList == NULL) || (SearchList[0] == '\0'))
+  {
+    SearchList = PS_CONFIG_SEARCH_LIST;
+  }
+
+  /* The longest candidate is an entry of the list followed by the executable
+   * filename */
+  BufferLength = strlen(SearchList) + strlen(Executable) + 8;
+  Buffer       = PS_Allocate(BufferLength);
+
+  if (PS_SearchConfigFilename(SearchList, Executable, Buffer, BufferLength, PS_ProbeConfigFilename, NULL) == 0)
+  {
+    free(Buffer);
+    Buffer = NULL;
+  }
+
+  return Buffer;
+}
+
+/* Return a new allocated array of arguments: the command line split like a
+ * shell would do, followed by the parameters Argv[1..Argc-1]. The arguments
+ * are stored in the same allocation as the array. */
+static char **PS_SplitCommandLine (const char *CommandLine, int Argc, char **Argv)
+{
+  size_t       Length = strlen(CommandLine);
+  size_t       MaxArguments;
+  char       **Arguments;
+  char        *po;
+  const char  *pi = CommandLine;
+  int          Count = 0;
+  int          Index;
+  char         Quote;
+
+  /* There are at most (Length / 2 + 1) arguments in the command line */
+  MaxArguments = (Length / 2) + 1 + (size_t)Argc + 1;
+  Arguments    = PS_Allocate((MaxArguments * sizeof(char *)) + Length + 1);
+  po           = (char *)(Arguments + MaxArguments);
+
+  while (*pi)
+  {
+    while ((*pi == ' ') || (*pi == '\t'))
+    {
+      pi++;
+    }
+
+    if (*pi)
+    {
+      Arguments[Count++] = po;
+      Quote              = '\0';
+
+      while ((*pi) && ((Quote != '\0') || ((*pi != ' ') && (*pi != '\t'))))
+      {
+        if ((Quote == '\0') && ((*pi == '\'') || (*pi == '\"')))
+        {
+          Quote = *pi++;
+        }
+        else if ((Quote != '\0') && (*pi == Quote))
+        {
+          Quote = '\0';
+          pi++;
+        }
+        else if ((*pi == '\\') && (Quote != '\'') && (pi[1] != '\0')
+                 && ((Quote == '\0') || (pi[1] == '\"') || (pi[1] == '\\')))
+        {
+          *po++ = pi[1];
+          pi   += 2;
+        }
+        else
+        {
+          *po++ = *pi++;
+        }
+      }
+
+      if (Quote != '\0')
+      {
+        PS_MessageAndExit(17, "Unterminated quote in PLAINSTARTER_CMD_LINE.", EXIT_FAILURE);
+      }
+
+      *po++ = '\0';
+    }
+  }
+
+  if (Count == 0)
+  {
+    PS_MessageAndExit(17, "PLAINSTARTER_CMD_LINE is empty.", EXIT_FAILURE);
+  }
+
+  for (Index = 1 ; Index < Argc ; Index++)
+  {
+    Arguments[Count++] = Argv[Index];
+  }
+  Arguments[Count] = NULL;
+
+  return Arguments;
+}
+
+/* Return a new allocated string with the filename of Program, searched in the
+ * PATH of the child process when it does not contain '/', or NULL */
+static char *PS_FindExecutable (const char *Program)
+{
+  const char  *Path;
+  const char  *Entry;
+  const char  *EntryEnd;
+  char        *Filename = NULL;
+  size_t       ProgramLength = strlen(Program);
+  size_t       EntryLength;
+  struct stat  Info;
+
+  if (strchr(Program, '/') != NULL)
+  {
+    Filename = PS_Allocate(ProgramLength + 1);
+    memcpy(Filename, Program, (ProgramLength + 1));
+  }
+  else
+  {
+    Path = PS_EnvGet(&PS_Environment, "PATH", 4);
+    if (Path == NULL)
+    {
+      Path = "/usr/bin:/bin";
+    }
+
+    Entry = Path;
+    while ((Entry != NULL) && (Filename == NULL))
+    {
+      EntryEnd = strchr(Entry, ':');
+      if (EntryEnd == NULL)
+      {
+        EntryEnd = Entry + strlen(Entry);
+      }
+
+      /* An empty entry is the current directory */
+      EntryLength = (size_t)(EntryEnd - Entry);
+      if (EntryLength == 0)
+      {
+        Entry       = ".";
+        EntryLength = 1;
+      }
+
+      Filename = PS_Allocate(EntryLength + ProgramLength + 2);
+      memcpy(Filename, Entry, EntryLength);
+      Filename[EntryLength] = '/';
+      memcpy((Filename + EntryLength + 1), Program, (ProgramLength + 1));
+
+      if ((stat(Filename, &Info) != 0)
+          || (S_ISREG(Info.st_mode) == 0)
+          || (access(Filename, X_OK) != 0))
+      {
+        free(Filename);
+        Filename = NULL;
+      }
+
+      Entry = (*EntryEnd == ':') ? (EntryEnd + 1) : NULL;
+    }
+  }
+
+  return Filename;
+}
+
+static int PS_RunProcess (char **Arguments)
+{
+  char  *Executable;
+  char **Environment;
+  pid_t  ProcessId;
+  int    Status;
+  int    ExitCode = EXIT_FAILURE;
+  int    Result;
+
+  if (PS_OPTION_DEBUG)
+  {
+    fprintf(stderr, "Configuration: %s\n\n", PS_ConfigFilename);
+    for (Result = 0 ; Arguments[Result] != NULL ; Result++)
+    {
+      fprintf(stderr, "[%s]\n", Arguments[Result]);
+    }
+  }
+
+  Executable = PS_FindExecutable(Arguments[0]);
+  if (Executable == NULL)
+  {
+    fprintf(stderr, "plainstarter: %s: command not found\n", Arguments[0]);
+    PS_MessageAndExit(18, "the command line could not be executed", PS_EXIT_NOT_FOUND);
+  }
+
+  Environment = PS_EnvBuildArray(&PS_Environment);
+  if (Environment == NULL)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  if (PS_OPTION_MONITOR_PROCESS)
+  {
+    Result = posix_spawn(&ProcessId, Executable, NULL, NULL, Arguments, Environment);
+    if (Result != 0)
+    {
+      fprintf(stderr, "plainstarter: %s: %s\n", Executable, strerror(Result));
+      PS_MessageAndExit(18, "the command line could not be executed", PS_EXIT_NOT_EXECUTABLE);
+    }
+
+    while ((waitpid(ProcessId, &Status, 0) < 0) && (errno == EINTR))
+    {
+    }
+
+    if (WIFEXITED(Status))
+    {
+      ExitCode = WEXITSTATUS(Status);
+    }
+    else if (WIFSIGNALED(Status))
+    {
+      ExitCode = 128 + WTERMSIG(Status);
+    }
+    else
+    {
+      ExitCode = EXIT_FAILURE;
+    }
+
+    if (PS_OPTION_DEBUG)
+    {
+      fprintf(stderr, "plainstarter: the child process returned %d\n", ExitCode);
+    }
+  }
+  else
+  {
+    /* Only returns on failure */
+    execve(Executable, Arguments, Environment);
+
+    fprintf(stderr, "plainstarter: %s: %s\n", Executable, strerror(errno));
+    PS_MessageAndExit(18, "the command line could not be executed",
+                      ((errno == ENOENT) ? PS_EXIT_NOT_FOUND : PS_EXIT_NOT_EXECUTABLE));
+  }
+
+  PS_EnvFreeArray(Environment);
+  free(Executable);
+
+  return ExitCode;
+}
+
+static void PS_SM_ReadOptions (void)
+{
+  const char *Options;
+
+  Options = PS_EnvGet(&PS_Environment, "PLAINSTARTER_OPTIONS", 20);
+  if (Options == NULL)
+  {
+    Options = "";
+  }
+
+  PS_OPTION_MONITOR_PROCESS    = (strstr(Options, "monitor-process") != NULL);
+  PS_OPTION_DEBUG              = (strstr(Options, "debug") != NULL);
+  PS_OPTION_REPORT_UNDEFINED   = (strstr(Options, "report-undefined") != NULL);
+  PS_OPTION_PRUNE_MISSING_DIRS = (strstr(Options, "prune-missing-dirs") != NULL);
+}
+
+/* Set the variable Name, delete it if Value is NULL */
+static void PS_SM_SetVariable (const char *Name, const char *Value)
+{
+  if (Name[0] == '\0')
+  {
+    PS_MessageAndExit(8, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  if (PS_EnvSet(&PS_Environment, Name, Value) == 0)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  /* The options apply to the following lines, ie report-undefined. They are
+   * kept when the variable is deleted before running the process. */
+  if ((Value != NULL) && (strcmp(Name, "PLAINSTARTER_OPTIONS") == 0))
+  {
+    PS_SM_ReadOptions();
+  }
+}
+
+/* Expand the references to the variables of In into PS_Expanded */
+static char *PS_SM_ExpandVariable (const char *In)
+{
+  PS_EXPAND_REPORT Report;
+
+  Report.UndefinedCount = 0;
+
+  if (PS_EnvExpand(&PS_Environment, In, (PS_EXPAND_PERCENT | PS_EXPAND_BRACES), &PS_Expanded, &Report) == 0)
+  {
+    PS_MessageAndExit(7, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  if ((PS_OPTION_REPORT_UNDEFINED) && (Report.UndefinedCount > 0))
+  {
+    fprintf(stderr, "plainstarter: Undefined variable '%.*s' in:\n%s\n",
+            (int)Report.FirstUndefinedLength, Report.FirstUndefined, In);
+    PS_MessageAndExit(15, "Undefined variable", EXIT_FAILURE);
+  }
+
+  return PS_Expanded.Data;
+}
+
+/* Filter of the option prune-missing-dirs */
+static int PS_SM_DirectoryExists (void *Context, const char *Entry, size_t Length)
+{
+  char        Directory[PATH_MAX];
+  struct stat Status;
+
+  (void)Context;
+
+  /* Too long to be checked, kept */
+  if (Length >= sizeof(Directory))
+  {
+    return 1;
+  }
+
+  memcpy(Directory, Entry, Length);
+  Directory[Length] = '\0';
+
+  return (stat(Directory, &Status) == 0) && S_ISDIR(Status.st_mode);
+}
+
+/* NAME^=VALUE, NAME+=VALUE and NAME-=VALUE: update the list NAME with the
+ * expanded Value */
+static void PS_SM_UpdateList (const char *Name, const char *Value)
+{
+  static PS_STRING List;
+  char             BaseName[PS_MAX_LINE_LENGTH];
+  size_t           Length = strlen(Name) - 1;
+  unsigned int     Operation;
+
+  switch (Name[Length])
+  {
+  case '^': Operation = PS_LIST_PREPEND; break;
+  case '-': Operation = PS_LIST_REMOVE;  break;
+  default:  Operation = PS_LIST_APPEND;  break;
+  }
+
+  memcpy(BaseName, Name, Length);
+  BaseName[Length] = '\0';
+
+  if (PS_EnvUpdateList(PS_EnvGet(&PS_Environment, BaseName, Length),
+                       PS_SM_ExpandVariable(Value),
+                       Operation,
+                       PS_LIST_SEPARATOR,
+                       (PS_OPTION_PRUNE_MISSING_DIRS ? PS_SM_DirectoryExists : NULL),
+                       NULL,
+                       &List) == 0)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  PS_SM_SetVariable(BaseName, List.Data);
+}
+
+/* The lines ignored because their name or value is too long are reported
+ * once, before the command line is executed */
+static void PS_SM_ReportOverlong (const PS_PARSER *Parser)
+{
+  static int Reported = 0;
+
+  if ((Parser->OverlongCount > 0) && (Reported == 0))
+  {
+    Reported = 1;
+    fprintf(stderr,
+            "plainstarter: %u line(s) of the configuration ignored, starting at line %u: "
+            "the names and the values are limited to %u characters\n",
+            Parser->OverlongCount, Parser->OverlongLine, (PS_MAX_LINE_LENGTH - 1));
+  }
+}
+
+static void PS_SM_ProcessVariable (void       *Context,
+                                   const char *Name,
+                                   const char *Value)
+{
+  PS_SM_CONTEXT  *SmContext = Context;
+  char          **Arguments;
+
+  if (strcmp(Name, PS_CMD_LINE) == 0)
+  {
+    PS_SM_ReportOverlong(SmContext->Parser);
+    PS_SM_ReadOptions();
+
+    Arguments = PS_SplitCommandLine(PS_SM_ExpandVariable(Value), SmContext->argc, SmContext->argv);
+
+    /* The expansion is done, delete useless environment variables */
+    PS_SM_SetVariable("PLAINSTARTER_CMD_LINE",  NULL);
+    PS_SM_SetVariable("PLAINSTARTER_PROGNAME",  NULL);
+    PS_SM_SetVariable("PLAINSTARTER_DIRECTORY", NULL);
+    PS_SM_SetVariable("PLAINSTARTER_OPTIONS",   NULL);
+
+    PS_LAST_EXEC_CODE = PS_RunProcess(Arguments);
+    free(Arguments);
+  }
+  else if ((strlen(Name) > 1) && (strchr("^+-", Name[strlen(Name) - 1]) != NULL))
+  {
+    PS_SM_UpdateList(Name, Value);
+  }
+  else
+  {
+    PS_SM_SetVariable(Name, PS_SM_ExpandVariable(Value));
+  }
+}
+
+/* Read and parse the configuration file, mapped in memory at once. Return 0
+ * if the file cannot be opened. */
+static int PS_ReadConfiguration (const char *Filename, int argc, char **argv)
+{
+  PS_SM_CONTEXT  Context;
+  PS_PARSER      Parser;
+  struct stat    Info;
+  const char    *Start;
+  const char    *End;
+  void          *View = NULL;
+  int            Infile;
+
+  Infile = open(Filename, O_RDONLY);
+  if (Infile >= 0)
+  {
+    if (fstat(Infile, &Info) != 0)
+    {
+      PS_MessageAndExit(24, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+    }
+
+    Context.argc   = argc;
+    Context.argv   = argv;
+    Context.Parser = &Parser;
+    PS_ParserInitialize(&Parser, PS_SM_ProcessVariable, &Context);
+
+    /* Empty files cannot be mapped */
+    if (Info.st_size > 0)
+    {
+      View = mmap(NULL, (size_t)Info.st_size, PROT_READ, MAP_PRIVATE, Infile, 0);
+      if (View == MAP_FAILED)
+      {
+        PS_MessageAndExit(26, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+      }
+
+      Start = View;
+      End   = Start + Info.st_size;
+
+      /* UTF-16 Byte Order Marks */
+      if ((Info.st_size >= 2)
+          && ((((unsigned char)Start[0] == 0xFF) && ((unsigned char)Start[1] == 0xFE))
+              || (((unsigned char)Start[0] == 0xFE) && ((unsigned char)Start[1] == 0xFF))))
+      {
+        PS_MessageAndExit(9, "Expecting UTF-8 encoded configuration file.", EXIT_FAILURE);
+      }
+
+      /* UTF-8 Byte Order Mark */
+      if ((Info.st_size >= 3) && (memcmp(Start, "\xEF\xBB\xBF", 3) == 0))
+      {
+        Start += 3;
+      }
+
+      PS_ParseConfiguration(&Parser, Start, End);
+    }
+
+    PS_ParserFinish(&Parser);
+    PS_SM_ReportOverlong(&Parser);
+
+    if (View != NULL)
+    {
+      munmap(View, (size_t)Info.st_size);
+    }
+    close(Infile);
+  }
+
+  return (Infile >= 0);
+}
+
+static char *PS_Basename (char *Filename)
+{
+  char *Slash = strrchr(Filename, '/');
+
+  return (Slash == NULL) ? Filename : (Slash + 1);
+}
+
+/*---------------*/
+/* MAIN FUNCTION */
+/*---------------*/
+
+int main (int argc, char **argv)
+{
+  char  *Executable;
+  char  *ConfigFilename;
+  char **Variable;
+
+  Executable = PS_LocateBinary();
+  if (Executable == NULL)
+  {
+    PS_MessageAndExit(27, "Cannot locate the executable with /proc/self/exe.", EXIT_FAILURE);
+  }
+
+  ConfigFilename = PS_FindConfigFilename(Executable);
+  if (ConfigFilename == NULL)
+  {
+    PS_MessageAndExit(10, "Configuration file not found.", EXIT_FAILURE);
+  }
+  PS_ConfigFilename = ConfigFilename;
+
+  if (PS_EnvInitialize(&PS_Environment) == 0)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  for (Variable = environ ; *Variable != NULL ; Variable++)
+  {
+    if (PS_EnvImportString(&PS_Environment, *Variable) == 0)
+    {
+      PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+    }
+  }
+
+  PS_SM_SetVariable("PLAINSTARTER_PROGNAME", PS_Basename(Executable));
+
+  /* The executable is absolute: the directory is never empty */
+  PS_Basename(Executable)[-1] = '\0';
+  PS_SM_SetVariable("PLAINSTARTER_DIRECTORY", ((Executable[0] == '\0') ? "/" : Executable));
+
+  if (PS_ReadConfiguration(ConfigFilename, argc, argv) == 0)
+  {
+    PS_MessageAndExit(10, "Configuration file not found.", EXIT_FAILURE);
+  }
+
+  free(ConfigFilename);
+  free(Executable);
+  PS_StringFree(&PS_Expanded);
+  PS_EnvFree(&PS_Environment);
+
+  return PS_LAST_EXEC_CODE;
+}
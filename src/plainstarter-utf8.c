@@ -0,0 +1,210 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-utf8.c                                           |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * The configuration files are mostly ASCII. When SSE2 is available (always
+ * the case on x86-64), blocks of 16 bytes are checked at once and widened to
+ * UTF-16 without a per-character loop. The other characters are decoded by
+ * the scalar decoder, which also completes the sequences split between two
+ * chunks. Define PS_UTF8_NO_SIMD to use the scalar decoder only.
+ */
+
+#include "plainstarter-utf8.h"
+
+/*---------------------*/
+/* INCLUDES AND MACROS */
+/*---------------------*/
+
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(PS_UTF8_NO_SIMD)
+#define PS_UTF8_SSE2
+#include <emmintrin.h>
+#endif
+
+/*-----------*/
+/* CONSTANTS */
+/*-----------*/
+
+#define PS_UTF8_REPLACEMENT ((PS_UTF16)0xFFFD)
+
+/*-----------*/
+/* FUNCTIONS */
+/*-----------*/
+
+void PS_Utf8Initialize (PS_UTF8_DECODER *Decoder)
+{
+  Decoder->CodePoint    = 0;
+  Decoder->Remaining    = 0;
+  Decoder->Minimum      = 0;
+  Decoder->InvalidCount = 0;
+}
+
+/* Write the replacement character for an invalid sequence */
+static PS_UTF16 *PS_Utf8Invalid (PS_UTF8_DECODER *Decoder, PS_UTF16 *po)
+{
+  Decoder->Remaining = 0;
+  Decoder->InvalidCount++;
+  *po++ = PS_UTF8_REPLACEMENT;
+
+  return po;
+}
+
+/* Write the completed code point, as a surrogate pair above U+FFFF */
+static PS_UTF16 *PS_Utf8Complete (PS_UTF8_DECODER *Decoder, PS_UTF16 *po)
+{
+  unsigned int CodePoint = Decoder->CodePoint;
+
+  if ((CodePoint < Decoder->Minimum)
+      || (CodePoint > 0x10FFFF)
+      || ((CodePoint >= 0xD800) && (CodePoint <= 0xDFFF)))
+  {
+    po = PS_Utf8Invalid(Decoder, po);
+  }
+  else if (CodePoint >= 0x10000)
+  {
+    CodePoint -= 0x10000;
+    *po++ = (PS_UTF16)(0xD800 | (CodePoint >> 10));
+    *po++ = (PS_UTF16)(0xDC00 | (CodePoint & 0x3FF));
+  }
+  else
+  {
+    *po++ = (PS_UTF16)CodePoint;
+  }
+
+  return po;
+}
+
+size_t PS_Utf8Decode (PS_UTF8_DECODER     *Decoder,
+                      const unsigned char *In,
+                      size_t               InLength,
+                      PS_UTF16            *Out)
+{
+  const unsigned char *pi  = In;
+  const unsigned char *End = In + InLength;
+  PS_UTF16            *po  = Out;
+  unsigned int         Byte;
+
+#if defined(PS_UTF8_SSE2)
+  const __m128i Zero = _mm_setzero_si128();
+  __m128i       Block;
+  int           Mask;
+#endif
+
+  while (pi < End)
+  {
+#if defined(PS_UTF8_SSE2)
+    /* ASCII blocks without null character */
+    if (Decoder->Remaining == 0)
+    {
+      while ((End - pi) >= 16)
+      {
+        Block = _mm_loadu_si128((const __m128i *)pi);
+        Mask  = _mm_movemask_epi8(Block) | _mm_movemask_epi8(_mm_cmpeq_epi8(Block, Zero));
+        if (Mask != 0)
+        {
+          break;
+        }
+
+        _mm_storeu_si128((__m128i *)po,       _mm_unpacklo_epi8(Block, Zero));
+        _mm_storeu_si128((__m128i *)(po + 8), _mm_unpackhi_epi8(Block, Zero));
+        pi += 16;
+        po += 16;
+      }
+
+      if (pi == End)
+      {
+        break;
+      }
+    }
+#endif
+
+    Byte = *pi++;
+
+    if (Byte < 0x80)
+    {
+      if (Decoder->Remaining > 0)
+      {
+        po = PS_Utf8Invalid(Decoder, po);
+      }
+
+      if (Byte == 0)
+      {
+        po = PS_Utf8Invalid(Decoder, po);
+      }
+      else
+      {
+        *po++ = (PS_UTF16)Byte;
+      }
+    }
+    else if (Byte < 0xC0)
+    {
+      /* Continuation byte */
+      if (Decoder->Remaining == 0)
+      {
+        po = PS_Utf8Invalid(Decoder, po);
+      }
+      else
+      {
+        Decoder->CodePoint = (Decoder->CodePoint << 6) | (Byte & 0x3F);
+        Decoder->Remaining--;
+
+        if (Decoder->Remaining == 0)
+        {
+          po = PS_Utf8Complete(Decoder, po);
+        }
+      }
+    }
+    else
+    {
+      /* Leading byte, the pending sequence is truncated */
+      if (Decoder->Remaining > 0)
+      {
+        po = PS_Utf8Invalid(Decoder, po);
+      }
+
+      if ((Byte >= 0xC2) && (Byte <= 0xDF))
+      {
+        Decoder->CodePoint = Byte & 0x1F;
+        Decoder->Remaining = 1;
+        Decoder->Minimum   = 0x80;
+      }
+      else if ((Byte >= 0xE0) && (Byte <= 0xEF))
+      {
+        Decoder->CodePoint = Byte & 0x0F;
+        Decoder->Remaining = 2;
+        Decoder->Minimum   = 0x800;
+      }
+      else if ((Byte >= 0xF0) && (Byte <= 0xF4))
+      {
+        Decoder->CodePoint = Byte & 0x07;
+        Decoder->Remaining = 3;
+        Decoder->Minimum   = 0x10000;
+      }
+      else
+      {
+        po = PS_Utf8Invalid(Decoder, po);
+      }
+    }
+  }
+
+  return (size_t)(po - Out);
+}
+
+size_t PS_Utf8Finish (PS_UTF8_DECODER *Decoder, PS_UTF16 *Out)
+{
+  size_t Length = 0;
+
+  if (Decoder->Remaining > 0)
+  {
+    PS_Utf8Invalid(Decoder, Out);
+    Length = 1;
+  }
+
+  return Length;
+}
@@ -0,0 +1,60 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-utf8.h                                           |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * Validation and conversion of UTF-8 text to UTF-16, used to read the UTF-8
+ * configuration files. The input can be given in several chunks: a sequence
+ * split between two chunks is completed with the next chunk.
+ *
+ * The invalid sequences (overlong forms, surrogates, code points above
+ * U+10FFFF, truncated sequences) are replaced by U+FFFD and counted. The null
+ * character is also considered invalid: it never appears in a text file and
+ * it reveals a UTF-16 file without Byte Order Mark.
+ *
+ * This unit does not depend on the C runtime.
+ */
+
+#ifndef PLAINSTARTER_UTF8_H
+#define PLAINSTARTER_UTF8_H
+
+#include <stddef.h>
+
+/*------------------*/
+/* TYPE DEFINITIONS */
+/*------------------*/
+
+typedef unsigned short PS_UTF16;
+
+/* State of the decoder, kept between the chunks */
+typedef struct {
+  unsigned int CodePoint;
+  unsigned int Remaining;
+  unsigned int Minimum;
+  size_t       InvalidCount;
+} PS_UTF8_DECODER;
+
+/*-----------*/
+/* FUNCTIONS */
+/*-----------*/
+
+void PS_Utf8Initialize (PS_UTF8_DECODER *Decoder);
+
+/* Convert InLength bytes, Out must have room for (InLength + 1) characters.
+ * Return the number of characters written. */
+size_t PS_Utf8Decode (PS_UTF8_DECODER     *Decoder,
+                      const unsigned char *In,
+                      size_t               InLength,
+                      PS_UTF16            *Out);
+
+/* End of the input: a pending sequence is truncated. Out must have room for
+ * 1 character. Return the number of characters written. */
+size_t PS_Utf8Finish (PS_UTF8_DECODER *Decoder, PS_UTF16 *Out);
+
+#endif
@@ -37,6 +37,13 @@
  * - my-app.exe will try to load the configuration file "configs\my-app.cfg",
  * then "config\my-app.cfg" and finally "my-app.cfg".
  *
+ * The list of directories can be changed with the environment variable
+ * PLAINSTARTER_CONFIG_DIRS, ie "configs;C:\shared-configs;" where an empty
+ * entry is the directory of the executable.
+ *
+ * The configuration can also be embedded in the executable as the resource
+ * RCDATA 1 (see tools/plainstarter-embed.c), no file is searched then.
+ *
  * The configuration file is a simple list of environment variables to setup and
  * export to the child processes:
  * PLAINSTARTER_OPTIONS=option-1 option-2
@@ -46,14 +53,21 @@
  * PATH=bin\my-dir\dlls;%PATH%
  * PLAINSTARTER_CMD_LINE=command line
  *
+ * The lists separated by ';' such as PATH are updated without duplicates with
+ * NAME^=VALUE (prepend), NAME+=VALUE (append) and NAME-=VALUE (remove), see
+ * PS_SM_GetListOperation.
+ *
  * Note: the variables can reference any of the Microsoft Windows environment
  * variables (ie. %PATH% or %APPDATA%). It is also possible to override the
  * value of these variables to prepend/append application-defined directory.
  *
+ * The configuration file is encoded in UTF-8 (with or without BOM) or in
+ * UTF-16 LE with a BOM, the lines end with CRLF or LF.
+ *
  * Lines are processed one by one. For this reason, the command line probably
  * need to be set at the end of the file. Comments can be inserted using the
  * character '#'. Variable names or values longer than 1024 characters will be
- * ignored. Files larger than 10240 bytes will lead to an execution error.
+ * ignored. There is no limit on the size of the file.
  *
  * These special variables are used internally by Plainstarter and will not be
  * exported to the child processes.
@@ -62,7 +76,9 @@
  * This is the command line to execute. All the parameters given to Plainstarter
  * will be appended to PLAINSTARTER_CMD_LINE. This behavior is required to
  * transmit command line options to the underlying programs. PLAINSTARTER_CMD_LINE
- * can reference any environment variable.
+ * can reference any environment variable. When the command line is longer than
+ * 32767 characters, the parameters are written to a response file given as
+ * @file (see COMMAND LINE).
  *
  * PLAINSTARTER_OPTIONS
  * Contains a list of options to alter the execution of plainstarter.
@@ -82,6 +98,42 @@
  * init-common-controls
  * monitor-process
  * debug
+ * config-cache
+ * path-cache
+ * report-undefined
+ * prune-missing-dirs
+ * process-pool[=<count>]
+ * job-memory=<size>
+ * process-memory=<size>
+ * cpu-rate=<percent>
+ * active-processes=<count>
+ * kill-on-close
+ * priority=idle|below-normal|normal|above-normal|high
+ * affinity=<mask>
+ * cpu-sets=<id>,<id>,...
+ * processor-group=<group>
+ * numa-node=<node>
+ * efficiency-mode=on|off
+ * trace
+ * stats
+ * capture-output
+ * log-size=<size>
+ * log-files=<count>
+ * raw-arguments
+ * wait-ready=input-idle|window|both
+ * ready-timeout=<milliseconds>
+ * single-instance=<key>
+ * headless
+ * group-wait-any
+ * group-exit-max
+ * group-exit-first
+ *
+ * PLAINSTARTER_LOG_FILE
+ * Log file of the option capture-output.
+ *
+ * PLAINSTARTER_GROUP_CMD_LINE
+ * Command line started in parallel with the next PLAINSTARTER_CMD_LINE, or at
+ * the end of the configuration. Can be repeated, see LAUNCH GROUP.
  */
 
 /*---------------------*/
@@ -93,12 +145,19 @@
 #define _UNICODE
 #endif
 
+/* Windows 7: processor groups */
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0601
+#endif
+
 #define WIN32_LEAN_AND_MEAN
 #include <tchar.h>
 #include <windows.h>
 #include <commctrl.h>
-#include <shellapi.h>
-#include <shlwapi.h>
+#include <psapi.h>
+
+#include "plainstarter-core.h"
+#include "plainstarter-utf8.h"
 
 #define PS_ARRAY_SIZE(array) ((sizeof(array)/sizeof(array[0])))
 
@@ -110,676 +169,5593 @@
  * long-filenames */
 static const size_t PS_MAX_FILENAME_LENGTH_CHAR = (size_t)32767;
 
-/* Maximum size of the file buffer in bytes */
-static const size_t PS_MAX_CONFIG_FILE_SIZE_BYTES = (size_t)10240;
+/* Limit of the command line given to CreateProcess, including the null
+ * character */
+static const size_t PS_MAX_COMMAND_LINE_CHAR = (size_t)32767;
+
+/* Size of the views used to map the configuration file in memory, multiple
+ * of the allocation granularity (64 KiB) */
+static const SIZE_T PS_CONFIG_VIEW_SIZE_BYTES = (SIZE_T)(16 * 65536);
+
+/* Address space reserved for the arena, committed by steps of 64 KiB. The
+ * committed memory beyond PS_ARENA_SLACK_BYTES is returned to the system when
+ * the temporary strings are released. */
+static const SIZE_T PS_ARENA_RESERVE_BYTES = (SIZE_T)(64 * 1024 * 1024);
+static const SIZE_T PS_ARENA_COMMIT_BYTES  = (SIZE_T)65536;
+static const SIZE_T PS_ARENA_SLACK_BYTES   = (SIZE_T)(256 * 1024);
+
+/* Exit code of an error in headless mode, followed by the error id */
+static const int PS_HEADLESS_EXIT_BASE = 100;
 
 static const TCHAR *PS_UNEXPECTED_ERROR = _T("Unexpected error");
-static const TCHAR  PS_CONFIG_DIR_1[8]  = _T("configs\\");
-static const TCHAR  PS_CONFIG_DIR_2[7]  = _T("config\\");
-static const TCHAR  PS_CONFIG_DIR_3[1]  = _T("");
+static const TCHAR *PS_ENCODING_ERROR   = _T("Expecting UTF-8 or UTF-16 encoded configuration file.");
+
+/* Ordered list of the directories containing the configuration file, relative
+ * to the executable directory. Can be overridden with the environment variable
+ * PLAINSTARTER_CONFIG_DIRS. An empty entry is the executable directory. */
+static const TCHAR *PS_CONFIG_SEARCH_LIST = _T("configs\\;config\\;");
+static const TCHAR *PS_CMD_LINE           = _T("PLAINSTARTER_CMD_LINE");
+static const TCHAR *PS_GROUP_CMD_LINE     = _T("PLAINSTARTER_GROUP_CMD_LINE");
+
+/* Identifier of the RCDATA resource containing an embedded configuration,
+ * written by plainstarter-embed */
+#define PS_CONFIG_RESOURCE_ID 1
 
-#define PS_MAX_LINE_LEN_BYTES ((unsigned int)1024)
+/* The cache file is named after the configuration file: my-app.cfgc */
+static const TCHAR  PS_CACHE_SUFFIX[2]  = _T("c");
+static const DWORD  PS_CACHE_MAGIC      = 0x31435350; /* PSC1 */
+
+/* Process pool of the option process-pool: default and maximum number of
+ * suspended processes kept by the broker, delay after which an idle broker
+ * exits and delay given to a busy broker to accept a launcher */
+#define PS_POOL_MAX_SIZE 8
+static const DWORD  PS_POOL_SIZE               = 2;
+static const DWORD  PS_POOL_IDLE_TIMEOUT_MS    = 10 * 60 * 1000;
+static const DWORD  PS_POOL_CONNECT_TIMEOUT_MS = 50;
+static const DWORD  PS_POOL_MAGIC              = 0x31505350; /* PSP1 */
+
+/* Executables resolved by the option path-cache, the file is
+ * %TEMP%\plainstarter-<hash of the configuration file>.pathc */
+#define PS_PATH_CACHE_SIZE 8
+static const DWORD  PS_PATH_CACHE_MAGIC        = 0x31585350; /* PSX1 */
+
+/* Option wait-ready: default timeout, polling period of the windows, size of
+ * the end of the history file read and number of launches summarized */
+static const DWORD  PS_READY_TIMEOUT_MS   = 30000;
+static const DWORD  PS_READY_POLL_MS      = 10;
+#define PS_HISTORY_TAIL_BYTES (64 * 1024)
+#define PS_HISTORY_SAMPLES    256
+
+/* Option single-instance: polling period of the pipe of the running
+ * instance */
+static const DWORD  PS_INSTANCE_POLL_MS   = 20;
+
+/* Output capture of the option capture-output: size of the pipes and of the
+ * read buffers, default size and number of the old log files, delay given
+ * to the output of the processes which survive the monitored ones */
+#define PS_CAPTURE_BUFFER_SIZE (64 * 1024)
+static const ULONGLONG PS_CAPTURE_LOG_SIZE         = 10 * 1024 * 1024;
+static const DWORD     PS_CAPTURE_LOG_FILES        = 3;
+static const DWORD     PS_CAPTURE_FLUSH_TIMEOUT_MS = 2000;
 
 /*------------------*/
-/* GLOBAL VARIABLES */
+/* TYPE DEFINITIONS */
 /*------------------*/
 
-/* Buffer which can contain the largest Windows PATH variable */
-static TCHAR PS_BufferIn[32767];
-static TCHAR PS_BufferOut[32767];
+/* String allocated in the arena, the capacity is in characters and includes
+ * the null character */
+typedef struct {
+  TCHAR *Data;
+  DWORD  Capacity;
+} PS_ARENA_TEXT;
+
+/* Parameters given to Plainstarter, forwarded by the parser callback, and
+ * the parser itself (can be NULL) */
+typedef struct {
+  int              argc;
+  TCHAR          **argv;
+  const PS_PARSER *Parser;
+} PS_SM_CONTEXT;
+
+/*------------------*/
+/* GLOBAL VARIABLES */
+/*------------------*/
 
 static BOOL PS_OPTION_INIT_COMMON_CONTROLS = FALSE;
 static BOOL PS_OPTION_SHOW_CONSOLE         = FALSE;
 static BOOL PS_OPTION_MONITOR_PROCESS      = FALSE;
 static BOOL PS_OPTION_DEBUG                = FALSE;
-static int  PS_LAST_EXEC_CODE              = EXIT_SUCCESS;
+static BOOL PS_OPTION_CONFIG_CACHE         = FALSE;
+static BOOL PS_OPTION_REPORT_UNDEFINED     = FALSE;
+static BOOL PS_OPTION_GROUP_WAIT_ANY       = FALSE;
+static BOOL PS_OPTION_GROUP_EXIT_MAX       = FALSE;
+static BOOL PS_OPTION_GROUP_EXIT_FIRST     = FALSE;
+static BOOL PS_OPTION_PROCESS_POOL         = FALSE;
+static BOOL PS_OPTION_KILL_ON_CLOSE        = FALSE;
+static BOOL PS_OPTION_TRACE                = FALSE;
+static BOOL PS_OPTION_STATS                = FALSE;
+static BOOL PS_OPTION_CAPTURE_OUTPUT       = FALSE;
+static BOOL PS_OPTION_RAW_ARGUMENTS        = FALSE;
+static BOOL PS_OPTION_PATH_CACHE           = FALSE;
+static BOOL PS_OPTION_PRUNE_MISSING_DIRS   = FALSE;
+static BOOL PS_OPTION_SINGLE_INSTANCE      = FALSE;
 
-/*------------------------*/
-/* UTILITY LIBC FUNCTIONS */
-/*------------------------*/
+/* Hash of the key of single-instance */
+static DWORD     PS_OPTION_INSTANCE_KEY     = 0;
+
+/* Option wait-ready: PS_READY_INPUT_IDLE and/or PS_READY_WINDOW, 0 when
+ * disabled, and its timeout in milliseconds */
+static DWORD     PS_OPTION_WAIT_READY       = 0;
+static DWORD     PS_OPTION_READY_TIMEOUT    = 0;
+
+/* Number of processes of process-pool, 1 to PS_POOL_MAX_SIZE */
+static DWORD     PS_OPTION_POOL_SIZE        = 0;
 
-static TCHAR *PS_StringAppend (TCHAR       *Out,
-                               const TCHAR *InStart,
-                               const TCHAR *InEnd)
+/* Rotation of the log file of capture-output */
+static ULONGLONG PS_OPTION_LOG_SIZE         = 0;
+static DWORD     PS_OPTION_LOG_FILES        = 0;
+
+/* Limits of the job object, 0 when disabled */
+static ULONGLONG PS_OPTION_JOB_MEMORY       = 0;
+static ULONGLONG PS_OPTION_PROCESS_MEMORY   = 0;
+static DWORD     PS_OPTION_CPU_RATE         = 0;
+static DWORD     PS_OPTION_ACTIVE_PROCESSES = 0;
+
+/* CPU placement, 0 or -1 when disabled */
+static DWORD     PS_OPTION_PRIORITY_CLASS   = 0;
+static ULONGLONG PS_OPTION_AFFINITY         = 0;
+static int       PS_OPTION_PROCESSOR_GROUP  = -1;
+static int       PS_OPTION_NUMA_NODE        = -1;
+static ULONG     PS_OPTION_CPU_SETS[64];
+static ULONG     PS_OPTION_CPU_SET_COUNT    = 0;
+static int       PS_OPTION_EFFICIENCY_MODE  = -1;
+
+static int       PS_LAST_EXEC_CODE          = EXIT_SUCCESS;
+
+/* Configuration file in use, displayed by the option debug */
+static TCHAR *PS_ConfigFilename = NULL;
+
+/*-----------*/
+/* BENCHMARK */
+/*-----------*/
+
+/* When compiled with PLAINSTARTER_BENCHMARK, the time spent in each phase of
+ * the launch is accumulated and printed on the standard output right before
+ * returning from PS_EffectiveMain. This is used by makefile-benchmark and is
+ * not part of the release binaries.
+ */
+#if defined(PLAINSTARTER_BENCHMARK)
+
+enum PS_BENCH_PHASE {
+  PS_BENCH_TOTAL,
+  PS_BENCH_CONFIG_PROBE,
+  PS_BENCH_PARSE,
+  PS_BENCH_EXPAND,
+  PS_BENCH_SET_VARIABLE,
+  PS_BENCH_ENVIRONMENT,
+  PS_BENCH_CREATE_PROCESS,
+  PS_BENCH_POOL,
+  PS_BENCH_PHASE_COUNT
+};
+
+static const TCHAR *PS_BENCH_PHASE_NAMES[PS_BENCH_PHASE_COUNT] = {
+  _T("total"),
+  _T("config-probe"),
+  _T("parse"),
+  _T("expand"),
+  _T("set-variable"),
+  _T("environment"),
+  _T("create-process"),
+  _T("pool-acquire")
+};
+
+static LONGLONG PS_BenchStart[PS_BENCH_PHASE_COUNT];
+static LONGLONG PS_BenchTicks[PS_BENCH_PHASE_COUNT];
+static DWORD    PS_BenchCount[PS_BENCH_PHASE_COUNT];
+static BOOL     PS_BenchActive[PS_BENCH_PHASE_COUNT];
+
+static void PS_BenchBegin (enum PS_BENCH_PHASE Phase)
+{
+  LARGE_INTEGER Now;
+
+  QueryPerformanceCounter(&Now);
+  PS_BenchStart[Phase]  = Now.QuadPart;
+  PS_BenchActive[Phase] = TRUE;
+}
+
+static void PS_BenchEnd (enum PS_BENCH_PHASE Phase)
+{
+  LARGE_INTEGER Now;
+
+  QueryPerformanceCounter(&Now);
+  PS_BenchTicks[Phase] += (Now.QuadPart - PS_BenchStart[Phase]);
+  PS_BenchCount[Phase]++;
+  PS_BenchActive[Phase] = FALSE;
+}
+
+/* Exclude a nested step from Phase: the callbacks of the parser expand the
+ * variables and can create the process, these are measured by their own
+ * phases and must not be counted twice in the phase parse */
+static void PS_BenchPause (enum PS_BENCH_PHASE Phase)
 {
-  TCHAR       *po = Out;
-  const TCHAR *pi = InStart;
+  LARGE_INTEGER Now;
 
-  while (pi <= InEnd)
+  if (PS_BenchActive[Phase] == TRUE)
   {
-    *po = *pi;
-    pi++;
-    po++;
+    QueryPerformanceCounter(&Now);
+    PS_BenchTicks[Phase] += (Now.QuadPart - PS_BenchStart[Phase]);
   }
+}
+
+static void PS_BenchResume (enum PS_BENCH_PHASE Phase)
+{
+  LARGE_INTEGER Now;
 
-  return po;
+  if (PS_BenchActive[Phase] == TRUE)
+  {
+    QueryPerformanceCounter(&Now);
+    PS_BenchStart[Phase] = Now.QuadPart;
+  }
 }
 
-static void PS_MessageAndExit (char         ErrorId,
-                               const TCHAR *Message,
-                               int          ErrorCode)
+/* Print a single line "phase=microseconds/count ..." so that the results of
+ * many runs can be aggregated by a script */
+static void PS_BenchReport (void)
 {
-  DWORD BytesWritten;
+  static char   Line[1024];
+  static TCHAR  Text[1024];
+  LARGE_INTEGER Frequency;
+  TCHAR        *p;
+  int           Length;
+  DWORD         BytesWritten;
+  int           Phase;
+
+  QueryPerformanceFrequency(&Frequency);
+
+  p = Text;
+  for (Phase = 0 ; Phase < PS_BENCH_PHASE_COUNT ; Phase++)
+  {
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)PS_BENCH_PHASE_NAMES[Phase],
+      (DWORD_PTR)((PS_BenchTicks[Phase] * 1000000) / Frequency.QuadPart),
+      (DWORD_PTR)PS_BenchCount[Phase]
+    };
+
+    p += FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                       | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                       _T("%1!s!=%2!I64u!/%3!u! "),
+                       0,
+                       0,
+                       p,
+                       64,
+                       (char **)Args);
+  }
+  *p++ = _T('\n');
+  *p   = _T('\0');
+
+  Length = WideCharToMultiByte(CP_UTF8, 0, Text, -1, Line, sizeof(Line), NULL, NULL);
+  if (Length > 1)
+  {
+    WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), Line, (Length - 1), &BytesWritten, NULL);
+  }
+}
+
+#define PS_BENCH_BEGIN(Phase)  PS_BenchBegin(Phase)
+#define PS_BENCH_END(Phase)    PS_BenchEnd(Phase)
+#define PS_BENCH_PAUSE(Phase)  PS_BenchPause(Phase)
+#define PS_BENCH_RESUME(Phase) PS_BenchResume(Phase)
+#define PS_BENCH_REPORT()      PS_BenchReport()
+
+#else
+
+#define PS_BENCH_BEGIN(Phase)
+#define PS_BENCH_END(Phase)
+#define PS_BENCH_PAUSE(Phase)
+#define PS_BENCH_RESUME(Phase)
+#define PS_BENCH_REPORT()
+
+#endif
+
+/*------------*/
+/* JSON LINES */
+/*------------*/
+
+/* The trace and the statistics are appended to files given by environment
+ * variables, as a single JSON line per launch encoded in UTF-8. The files are
+ * opened in append mode, the lines of concurrent launches are not mixed.
+ * Nothing is displayed: the errors of these files are ignored.
+ */
+static void PS_JsonAppend (PS_STRING *Line, const TCHAR *Text)
+{
+  PS_StringAppendN(Line, Text, (size_t)lstrlen(Text));
+}
+
+/* Append a JSON string, with the quotes */
+static void PS_JsonAppendString (PS_STRING *Line, const TCHAR *Text)
+{
+  static const TCHAR Hex[] = _T("0123456789abcdef");
+  TCHAR              Escaped[7];
+  const TCHAR       *p;
+
+  PS_JsonAppend(Line, _T("\""));
+  for (p = Text ; *p ; p++)
+  {
+    if ((*p == _T('\"')) || (*p == _T('\\')))
+    {
+      Escaped[0] = _T('\\');
+      Escaped[1] = *p;
+      PS_StringAppendN(Line, Escaped, 2);
+    }
+    else if (*p < 0x20)
+    {
+      Escaped[0] = _T('\\');
+      Escaped[1] = _T('u');
+      Escaped[2] = _T('0');
+      Escaped[3] = _T('0');
+      Escaped[4] = Hex[(*p >> 4) & 0xF];
+      Escaped[5] = Hex[*p & 0xF];
+      PS_StringAppendN(Line, Escaped, 6);
+    }
+    else
+    {
+      PS_StringAppendN(Line, p, 1);
+    }
+  }
+  PS_JsonAppend(Line, _T("\""));
+}
+
+/* Append "Name":Value, preceded by a comma unless Name is the first member */
+static void PS_JsonAppendNumber (PS_STRING   *Line,
+                                 const TCHAR *Name,
+                                 LONGLONG     Value)
+{
+  TCHAR Number[64];
 
   DWORD_PTR Args[] = {
-    (DWORD_PTR)ErrorId
+    (DWORD_PTR)(((Line->Length > 0) && (Line->Data[Line->Length - 1] != _T('{'))) ? _T(",") : _T("")),
+    (DWORD_PTR)Name,
+    (DWORD_PTR)Value
   };
 
-  BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
-                               | FORMAT_MESSAGE_ARGUMENT_ARRAY,
-                               _T("Error#%1!2.2d!"),
-                               0,
-                               0,
-                               PS_BufferIn,
-                               sizeof(PS_BufferIn),
-                               (char **)Args);
-  if (BytesWritten > 0)
+  if (FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                    | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                    _T("%1!s!\"%2!s!\":%3!I64d!"),
+                    0,
+                    0,
+                    Number,
+                    PS_ARRAY_SIZE(Number),
+                    (char **)Args) > 0)
   {
-    MessageBox(NULL, Message, PS_BufferIn, MB_ICONERROR);
+    PS_JsonAppend(Line, Number);
   }
-  else
+}
+
+/* Start the line: {"utc":"2022-05-01T10:00:00.000Z","pid":1234,"config":"..." */
+static void PS_JsonAppendHeader (PS_STRING *Line)
+{
+  TCHAR      Utc[32];
+  SYSTEMTIME Now;
+
+  GetSystemTime(&Now);
+
+  DWORD_PTR Args[] = {
+    (DWORD_PTR)Now.wYear,
+    (DWORD_PTR)Now.wMonth,
+    (DWORD_PTR)Now.wDay,
+    (DWORD_PTR)Now.wHour,
+    (DWORD_PTR)Now.wMinute,
+    (DWORD_PTR)Now.wSecond,
+    (DWORD_PTR)Now.wMilliseconds
+  };
+
+  if (FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                    | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                    _T("%1!04u!-%2!02u!-%3!02u!T%4!02u!:%5!02u!:%6!02u!.%7!03u!Z"),
+                    0,
+                    0,
+                    Utc,
+                    PS_ARRAY_SIZE(Utc),
+                    (char **)Args) == 0)
   {
-    MessageBox(NULL, PS_UNEXPECTED_ERROR, _T("Error"), MB_ICONERROR);
+    Utc[0] = _T('\0');
   }
 
-  ExitProcess(ErrorCode);
+  PS_JsonAppend(Line, _T("{\"utc\":"));
+  PS_JsonAppendString(Line, Utc);
+  PS_JsonAppendNumber(Line, _T("pid"), GetCurrentProcessId());
+  PS_JsonAppend(Line, _T(",\"config\":"));
+  PS_JsonAppendString(Line, ((PS_ConfigFilename != NULL) ? PS_ConfigFilename : _T("")));
 }
 
-/*----------------*/
-/* MAIN FUNCTIONS */
-/*----------------*/
+/* Append the line to the file named by the environment variable Variable of
+ * the parent process, then release the line */
+static void PS_JsonWriteLine (const TCHAR *Variable, PS_STRING *Line)
+{
+  TCHAR  Filename[1024];
+  HANDLE Outfile;
+  char  *Utf8;
+  int    Utf8Length;
+  DWORD  BytesWritten;
+  DWORD  Length;
+
+  Length = GetEnvironmentVariable(Variable, Filename, PS_ARRAY_SIZE(Filename));
+
+  if ((Line->Data != NULL) && (Length > 0) && (Length < PS_ARRAY_SIZE(Filename)))
+  {
+    Utf8Length = WideCharToMultiByte(CP_UTF8, 0, Line->Data, (int)Line->Length, NULL, 0, NULL, NULL);
+    Utf8       = (Utf8Length > 0) ? HeapAlloc(GetProcessHeap(), 0, Utf8Length) : NULL;
+
+    if (Utf8 != NULL)
+    {
+      WideCharToMultiByte(CP_UTF8, 0, Line->Data, (int)Line->Length, Utf8, Utf8Length, NULL, NULL);
+
+      /* A single write in append mode */
+      Outfile = CreateFile(Filename,
+                           FILE_APPEND_DATA,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           NULL,
+                           OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL,
+                           NULL);
+      if (Outfile != INVALID_HANDLE_VALUE)
+      {
+        WriteFile(Outfile, Utf8, (DWORD)Utf8Length, &BytesWritten, NULL);
+        CloseHandle(Outfile);
+      }
+
+      HeapFree(GetProcessHeap(), 0, Utf8);
+    }
+  }
+
+  PS_StringFree(Line);
+}
+
+/*-------*/
+/* TRACE */
+/*-------*/
 
-/* Return a string with the configuration filename.
- * <path>/<Prefix>/<basename>.cfg
+/* When the environment variable PLAINSTARTER_TRACE_FILE is defined, the steps
+ * of the launch are timestamped with QueryPerformanceCounter. With the option
+ * trace, they are appended to this file as a single JSON line per launch:
  *
- * Input : bin\starter-x86_64.exe
- * Output: bin\[configs]\starter-x86_64.cfg
+ * {"utc":"2022-05-01T10:00:00.000Z","pid":1234,"config":"C:\\app\\my-app.cfg",
+ *  "exit":0,"error":0,"dropped":0,"events":[{"event":"config-probe","us":35},
+ *  {"event":"variable","name":"PATH","us":180},...]}
+ *
+ * The times are in microseconds since the start of Plainstarter.
  */
-static TCHAR *PS_GetConfigFilename (const TCHAR *Prefix,
-                                    size_t       PrefixLength,
-                                    TCHAR       *Filename)
+#define PS_TRACE_MAX_EVENTS 256
+
+typedef struct {
+  LONGLONG     Ticks;
+  const TCHAR *Event;
+  TCHAR        Detail[64];
+} PS_TRACE_EVENT;
+
+static BOOL           PS_TraceEnabled = FALSE;
+static LONGLONG       PS_TraceStart;
+static PS_TRACE_EVENT PS_TraceEvents[PS_TRACE_MAX_EVENTS];
+static DWORD          PS_TraceCount   = 0;
+static DWORD          PS_TraceDropped = 0;
+
+static void PS_TraceInitialize (void)
 {
-  int    FilenameLen = lstrlen(Filename);
-  size_t NewFilenameLength;
+  LARGE_INTEGER Now;
 
-  TCHAR *Buffer;
-  TCHAR *BufferEnd;
-  TCHAR *p;
+  QueryPerformanceCounter(&Now);
+  PS_TraceStart   = Now.QuadPart;
+  PS_TraceEnabled = (GetEnvironmentVariable(_T("PLAINSTARTER_TRACE_FILE"), NULL, 0) > 0);
+}
 
-  TCHAR *ProgName;
-  TCHAR *ProgNameEnd;
+/* Record the event, Detail can be NULL */
+static void PS_TraceEvent (const TCHAR *Event, const TCHAR *Detail)
+{
+  PS_TRACE_EVENT *Entry;
+  LARGE_INTEGER   Now;
 
-  NewFilenameLength = (PrefixLength + FilenameLen + 5) * sizeof(TCHAR);
-  if (NewFilenameLength <= PS_MAX_FILENAME_LENGTH_CHAR)
+  if (PS_TraceCount >= PS_TRACE_MAX_EVENTS)
   {
-    Buffer = HeapAlloc(GetProcessHeap(), 0, NewFilenameLength);
-    if (Buffer != NULL)
+    PS_TraceDropped++;
+  }
+  else
+  {
+    QueryPerformanceCounter(&Now);
+
+    Entry            = &PS_TraceEvents[PS_TraceCount++];
+    Entry->Ticks     = Now.QuadPart;
+    Entry->Event     = Event;
+    Entry->Detail[0] = _T('\0');
+
+    if (Detail != NULL)
     {
-      /* find the basename */
-      ProgName    = 0;
-      ProgNameEnd = Filename + FilenameLen - 1; /* end of the Filename */
-      p           = ProgNameEnd;
-      while (ProgName == 0)
-      {
-        if (p == Filename)
-        {
-          ProgName = p;
-        }
-        else if ((*p == _T('.') && (*ProgNameEnd != _T('.'))))
-        {
-          ProgNameEnd = p - 1;
-        }
-        else if (*p ==  _T('\\'))
-        {
-          ProgName = p + 1;
-        }
+      lstrcpyn(Entry->Detail, Detail, PS_ARRAY_SIZE(Entry->Detail));
+    }
+  }
+}
 
-        /* next char */
-        p--;
-      }
+#define PS_TRACE(Event, Detail) \
+  ((PS_TraceEnabled == TRUE) ? PS_TraceEvent((Event), (Detail)) : (void)0)
 
-      BufferEnd = Buffer;
+/* Append the trace of the launch to PLAINSTARTER_TRACE_FILE, only with the
+ * option trace. ErrorId is the identifier given to PS_MessageAndExit, 0 when
+ * the launch succeeded. */
+static void PS_TraceWrite (int ExitCode, char ErrorId)
+{
+  PS_STRING     Line = { NULL, 0, 0 };
+  LARGE_INTEGER Frequency;
+  DWORD         Index;
 
-      /* Filename contains a directory */
-      if (Filename != ProgName)
-        BufferEnd = PS_StringAppend(BufferEnd, Filename, ProgName - 1);
-      /* Non-empty prefix */
-      if (PrefixLength > 1)
-        BufferEnd = PS_StringAppend(BufferEnd, Prefix, (Prefix + PrefixLength - 1));
-      BufferEnd = PS_StringAppend(BufferEnd, ProgName, ProgNameEnd);
-      *BufferEnd++ = _T('.');
-      *BufferEnd++ = _T('c');
-      *BufferEnd++ = _T('f');
-      *BufferEnd++ = _T('g');
-      *BufferEnd++ = _T('\0');
-    }
+  if ((PS_TraceEnabled == FALSE) || (PS_OPTION_TRACE == FALSE))
+  {
+    return;
   }
-  else
+
+  /* Only once, ie PS_MessageAndExit called while reporting the exit code */
+  PS_TraceEnabled = FALSE;
+
+  QueryPerformanceFrequency(&Frequency);
+
+  PS_JsonAppendHeader(&Line);
+  PS_JsonAppendNumber(&Line, _T("exit"), ExitCode);
+  PS_JsonAppendNumber(&Line, _T("error"), ErrorId);
+  PS_JsonAppendNumber(&Line, _T("dropped"), PS_TraceDropped);
+  PS_JsonAppend(&Line, _T(",\"events\":["));
+
+  for (Index = 0 ; Index < PS_TraceCount ; Index++)
   {
-    Buffer = NULL;
+    PS_JsonAppend(&Line, ((Index == 0) ? _T("{\"event\":") : _T(",{\"event\":")));
+    PS_JsonAppendString(&Line, PS_TraceEvents[Index].Event);
+    if (PS_TraceEvents[Index].Detail[0] != _T('\0'))
+    {
+      PS_JsonAppend(&Line, _T(",\"name\":"));
+      PS_JsonAppendString(&Line, PS_TraceEvents[Index].Detail);
+    }
+    PS_JsonAppendNumber(&Line,
+                        _T("us"),
+                        (((PS_TraceEvents[Index].Ticks - PS_TraceStart) * 1000000) / Frequency.QuadPart));
+    PS_JsonAppend(&Line, _T("}"));
   }
+  PS_JsonAppend(&Line, _T("]}\n"));
 
-  return Buffer;
+  PS_JsonWriteLine(_T("PLAINSTARTER_TRACE_FILE"), &Line);
 }
 
-/* Read a file and return a new allocated buffer with the data. No support for
- * large files because the size of a configuration file should be a few
- * kilobytes, smaller than PS_MAX_CONFIG_FILE_SIZE_BYTES.
+/*----------*/
+/* HEADLESS */
+/*----------*/
+
+/* Unattended runs (continuous integration, scheduled tasks) cannot click on a
+ * message box. When the environment variable PLAINSTARTER_HEADLESS is defined
+ * and not empty, or with the option headless, nothing is displayed: each
+ * message is written as a JSON line encoded in UTF-8 to the file
+ * PLAINSTARTER_ERROR_FILE, or to the standard error when this variable is not
+ * defined:
+ *
+ * {"utc":"2022-05-01T10:00:00.000Z","pid":1234,"config":"C:\\app\\my-app.cfg",
+ *  "level":"error","title":"Error#10","error":10,"exit":110,
+ *  "message":"Configuration file not found."}
+ *
+ * An error exits immediately with PS_HEADLESS_EXIT_BASE + the error id, the
+ * record of an abnormal termination of the child (error 5) also has its exit
+ * code "child_exit". The messages of the options debug and report-undefined
+ * have the level "info" or "warning", and no exit code.
  */
-static TCHAR *PS_FileSlurp (TCHAR *Filename)
+static int      PS_Headless          = -1;
+static LONGLONG PS_HeadlessChildExit = -1;
+
+/* The variable is read on first use: the command line can fail to be split
+ * before the configuration is read */
+static BOOL PS_HeadlessIsEnabled (void)
 {
-  HANDLE Infile;
-  DWORD  InfileSize;
-  DWORD  BytesRead;
+  if (PS_Headless < 0)
+  {
+    PS_Headless = (GetEnvironmentVariable(_T("PLAINSTARTER_HEADLESS"), NULL, 0) > 0) ? 1 : 0;
+  }
+
+  return (PS_Headless > 0) ? TRUE : FALSE;
+}
+
+/* Write the record, then release it */
+static void PS_HeadlessWriteLine (PS_STRING *Line)
+{
+  HANDLE Output;
+  char  *Utf8;
+  int    Utf8Length;
   DWORD  BytesWritten;
-  char  *Buffer = NULL;
 
-  Infile = CreateFile(Filename,
-                      GENERIC_READ,
-                      FILE_SHARE_READ,
-                      NULL,
-                      OPEN_EXISTING,
-                      FILE_ATTRIBUTE_NORMAL
-                      | FILE_ATTRIBUTE_READONLY
-                      | FILE_ATTRIBUTE_HIDDEN,
-                      NULL);
+  if (GetEnvironmentVariable(_T("PLAINSTARTER_ERROR_FILE"), NULL, 0) > 0)
+  {
+    PS_JsonWriteLine(_T("PLAINSTARTER_ERROR_FILE"), Line);
+    return;
+  }
 
-  if (Infile != INVALID_HANDLE_VALUE)
+  Output = GetStdHandle(STD_ERROR_HANDLE);
+  if ((Line->Data != NULL) && (Output != NULL) && (Output != INVALID_HANDLE_VALUE))
   {
-    InfileSize = GetFileSize(Infile, NULL);
-    if ((InfileSize != INVALID_FILE_SIZE) && (InfileSize < PS_MAX_CONFIG_FILE_SIZE_BYTES))
-    {
-      Buffer = HeapAlloc(GetProcessHeap(), 0, ((InfileSize + 2) * sizeof(char)));
-      if (Buffer)
-      {
-        if (ReadFile(Infile, Buffer, InfileSize, &BytesRead, NULL) == TRUE)
-        {
-          Buffer[InfileSize] = _T('\0');
-        }
-        else
-        {
-          PS_MessageAndExit(1, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
-        }
-      }
-      else
-      {
-        PS_MessageAndExit(2, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
-      }
-    }
-    else
+    Utf8Length = WideCharToMultiByte(CP_UTF8, 0, Line->Data, (int)Line->Length, NULL, 0, NULL, NULL);
+    Utf8       = (Utf8Length > 0) ? HeapAlloc(GetProcessHeap(), 0, Utf8Length) : NULL;
+
+    if (Utf8 != NULL)
     {
-      DWORD_PTR Args[] = {
-        (DWORD_PTR)Filename,
-        (DWORD_PTR)InfileSize,
-        (DWORD_PTR)PS_MAX_CONFIG_FILE_SIZE_BYTES
-      };
-
-      BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
-                                   | FORMAT_MESSAGE_ARGUMENT_ARRAY,
-                                   _T("Configuration file is too large.\n")
-                                   _T("File: '%1!s!'\n")
-                                   _T("Size: %2!d! bytes\n")
-                                   _T("Software limit: %3!d! bytes"),
-                                   0,
-                                   0,
-                                   PS_BufferIn,
-                                   sizeof(PS_BufferIn),
-                                   (char **)Args);
-      if (BytesWritten > 0)
-      {
-        PS_MessageAndExit(3, PS_BufferIn, EXIT_FAILURE);
-      }
-      else
-      {
-        PS_MessageAndExit(4, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
-      }
+      WideCharToMultiByte(CP_UTF8, 0, Line->Data, (int)Line->Length, Utf8, Utf8Length, NULL, NULL);
+      WriteFile(Output, Utf8, (DWORD)Utf8Length, &BytesWritten, NULL);
+      HeapFree(GetProcessHeap(), 0, Utf8);
     }
+  }
 
-    /* Release resources */
-    CloseHandle(Infile);
+  PS_StringFree(Line);
+}
+
+/* Record a message instead of displaying it. ErrorId is 0 for the messages
+ * which are not errors, ExitCode is then ignored. */
+static void PS_HeadlessReport (const TCHAR *Level,
+                               const TCHAR *Title,
+                               const TCHAR *Message,
+                               char         ErrorId,
+                               int          ExitCode)
+{
+  PS_STRING Line = { NULL, 0, 0 };
+
+  PS_JsonAppendHeader(&Line);
+  PS_JsonAppend(&Line, _T(",\"level\":"));
+  PS_JsonAppendString(&Line, Level);
+  PS_JsonAppend(&Line, _T(",\"title\":"));
+  PS_JsonAppendString(&Line, Title);
+  if (ErrorId != 0)
+  {
+    PS_JsonAppendNumber(&Line, _T("error"), ErrorId);
+    PS_JsonAppendNumber(&Line, _T("exit"), ExitCode);
   }
+  if (PS_HeadlessChildExit >= 0)
+  {
+    PS_JsonAppendNumber(&Line, _T("child_exit"), PS_HeadlessChildExit);
+  }
+  PS_JsonAppend(&Line, _T(",\"message\":"));
+  PS_JsonAppendString(&Line, Message);
+  PS_JsonAppend(&Line, _T("}\n"));
 
-  return (TCHAR *)Buffer;
+  PS_HeadlessWriteLine(&Line);
 }
 
-/* Return a new allocated string containing the directory where is located the
- * plainstarter binary
+/*------------------------*/
+/* DELAY-LOADED FUNCTIONS */
+/*------------------------*/
+
+/* Only kernel32.dll is imported: the loader maps it in every process anyway.
+ * user32.dll is loaded to display a message or with the option wait-ready,
+ * comctl32.dll with the option init-common-controls. A launch without any
+ * message does not map them.
+ *
+ * PLAINSTARTER_STATIC_IMPORTS restores the imports of user32.dll, shell32.dll,
+ * comctl32.dll and shlwapi.dll without using them: the cold start benchmark
+ * compares both builds.
  */
-static TCHAR *PS_LocateWin32BinaryDirectory (TCHAR  *Buffer,
-                                             size_t  BufferLen)
+#if defined(PLAINSTARTER_STATIC_IMPORTS)
+#include <shellapi.h>
+#include <shlwapi.h>
+
+const void *PS_StaticImports[] = {
+  (const void *)MessageBoxW,
+  (const void *)InitCommonControls,
+  (const void *)CommandLineToArgvW,
+  (const void *)StrStrW
+};
+#endif
+
+typedef int  (WINAPI *PS_MESSAGE_BOX) (HWND, LPCWSTR, LPCWSTR, UINT);
+typedef void (WINAPI *PS_INIT_COMMON_CONTROLS) (void);
+
+/* LoadLibrary returns the module if it is already loaded */
+static FARPROC PS_LoadFunction (const TCHAR *Library, const char *Name)
 {
-  size_t  DirLength;
-  TCHAR  *NewString;
-  TCHAR  *Progname;
-  TCHAR  *LastBackslash;
-  TCHAR  *LastDot;
-  TCHAR  *p;
+  HMODULE Module;
 
-  /* Retrieve the full path of the current executable file */
-  if (GetModuleFileName(GetModuleHandle(NULL), Buffer, BufferLen) != 0)
+  Module = LoadLibrary(Library);
+
+  return (Module != NULL) ? GetProcAddress(Module, Name) : NULL;
+}
+
+static int PS_MessageBox (HWND Window, const TCHAR *Text, const TCHAR *Caption, UINT Type)
+{
+  static PS_MESSAGE_BOX MessageBoxFunction = NULL;
+
+  if (PS_HeadlessIsEnabled() == TRUE)
+  {
+    PS_HeadlessReport(((Type & MB_ICONERROR) == MB_ICONERROR) ? _T("error")
+                      : ((Type & MB_ICONWARNING) == MB_ICONWARNING) ? _T("warning")
+                      : _T("info"),
+                      Caption,
+                      Text,
+                      0,
+                      0);
+    return 0;
+  }
+
+  if (MessageBoxFunction == NULL)
+  {
+    MessageBoxFunction = (PS_MESSAGE_BOX)PS_LoadFunction(_T("user32.dll"), "MessageBoxW");
+  }
+
+  return (MessageBoxFunction != NULL) ? MessageBoxFunction(Window, Text, Caption, Type) : 0;
+}
+
+static void PS_InitCommonControls (void)
+{
+  PS_INIT_COMMON_CONTROLS InitCommonControlsFunction;
+
+  InitCommonControlsFunction = (PS_INIT_COMMON_CONTROLS)PS_LoadFunction(_T("comctl32.dll"), "InitCommonControls");
+  if (InitCommonControlsFunction != NULL)
+  {
+    InitCommonControlsFunction();
+  }
+}
+
+/*------------------------*/
+/* UTILITY LIBC FUNCTIONS */
+/*------------------------*/
+
+/* Same as StrStr, without importing shlwapi.dll */
+static const TCHAR *PS_StrStr (const TCHAR *String, const TCHAR *Search)
+{
+  const TCHAR *ps;
+  const TCHAR *pf;
+
+  for ( ; *String ; String++)
+  {
+    ps = String;
+    pf = Search;
+    while ((*pf) && (*ps == *pf))
+    {
+      ps++;
+      pf++;
+    }
+
+    if (*pf == _T('\0'))
+    {
+      return String;
+    }
+  }
+
+  return (*Search == _T('\0')) ? String : NULL;
+}
+
+/* Split the command line like CommandLineToArgvW, without importing
+ * shell32.dll. The program name ends at the next quote, or the next blank
+ * when it is not quoted. For the other arguments, 2n backslashes followed by
+ * a quote give n backslashes and toggle the quoting, 2n+1 backslashes
+ * followed by a quote give n backslashes and a quote, and a quote following
+ * a closing quote is literal. The result is released with HeapFree. */
+static TCHAR **PS_SplitCommandLine (const TCHAR *CommandLine, int *ArgCount)
+{
+  size_t       Length  = (size_t)lstrlen(CommandLine);
+  size_t       MaxArgs = (Length / 2) + 3;
+  const TCHAR *s       = CommandLine;
+  TCHAR      **Argv;
+  TCHAR       *d;
+  int          Count   = 0;
+  int          QuoteCount;
+  int          BackslashCount;
+
+  /* The arguments are never longer than the command line, each one ends
+   * with a null character */
+  Argv = HeapAlloc(GetProcessHeap(), 0, ((MaxArgs * sizeof(TCHAR *)) + ((Length + MaxArgs) * sizeof(TCHAR))));
+  if (Argv == NULL)
+  {
+    return NULL;
+  }
+  d = (TCHAR *)(Argv + MaxArgs);
+
+  /* Program name */
+  Argv[Count++] = d;
+  if (*s == _T('\"'))
+  {
+    s++;
+    while ((*s) && (*s != _T('\"')))
+    {
+      *d++ = *s++;
+    }
+    if (*s)
+    {
+      s++;
+    }
+  }
+  else
+  {
+    while ((*s) && (*s != _T(' ')) && (*s != _T('\t')))
+    {
+      *d++ = *s++;
+    }
+  }
+  *d++ = _T('\0');
+
+  for (;;)
+  {
+    while ((*s == _T(' ')) || (*s == _T('\t')))
+    {
+      s++;
+    }
+    if (*s == _T('\0'))
+    {
+      break;
+    }
+
+    Argv[Count++]  = d;
+    QuoteCount     = 0;
+    BackslashCount = 0;
+
+    while ((*s) && (((*s != _T(' ')) && (*s != _T('\t'))) || (QuoteCount != 0)))
+    {
+      if (*s == _T('\\'))
+      {
+        *d++ = *s++;
+        BackslashCount++;
+      }
+      else if (*s == _T('\"'))
+      {
+        if ((BackslashCount % 2) == 0)
+        {
+          /* Unescaped quote */
+          d -= BackslashCount / 2;
+          QuoteCount++;
+        }
+        else
+        {
+          /* Escaped quote */
+          d -= (BackslashCount / 2) + 1;
+          *d++ = _T('\"');
+        }
+        s++;
+        BackslashCount = 0;
+
+        /* Consecutive quotes, QuoteCount includes the opening quote and
+         * the one just read */
+        while (*s == _T('\"'))
+        {
+          QuoteCount++;
+          if (QuoteCount == 3)
+          {
+            *d++       = _T('\"');
+            QuoteCount = 0;
+          }
+          s++;
+        }
+        if (QuoteCount == 2)
+        {
+          QuoteCount = 0;
+        }
+      }
+      else
+      {
+        *d++           = *s++;
+        BackslashCount = 0;
+      }
+    }
+    *d++ = _T('\0');
+  }
+
+  Argv[Count] = NULL;
+  *ArgCount   = Count;
+
+  return Argv;
+}
+
+static void PS_MessageAndExit (char         ErrorId,
+                               const TCHAR *Message,
+                               int          ErrorCode)
+{
+  TCHAR Title[16];
+  DWORD BytesWritten;
+
+  DWORD_PTR Args[] = {
+    (DWORD_PTR)ErrorId
+  };
+
+  if (PS_HeadlessIsEnabled() == TRUE)
+  {
+    ErrorCode = PS_HEADLESS_EXIT_BASE + ErrorId;
+  }
+
+  PS_TraceWrite(ErrorCode, ErrorId);
+
+  BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                               | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                               _T("Error#%1!2.2d!"),
+                               0,
+                               0,
+                               Title,
+                               PS_ARRAY_SIZE(Title),
+                               (char **)Args);
+  if (PS_HeadlessIsEnabled() == TRUE)
+  {
+    PS_HeadlessReport(_T("error"), ((BytesWritten > 0) ? Title : _T("Error")), Message, ErrorId, ErrorCode);
+  }
+  else if (BytesWritten > 0)
+  {
+    PS_MessageBox(NULL, Message, Title, MB_ICONERROR);
+  }
+  else
+  {
+    PS_MessageBox(NULL, PS_UNEXPECTED_ERROR, _T("Error"), MB_ICONERROR);
+  }
+
+  ExitProcess(ErrorCode);
+}
+
+/*-------*/
+/* ARENA */
+/*-------*/
+
+/* The temporary strings (filenames, directories, converted configuration,
+ * messages) are allocated in a single arena: PS_ARENA_RESERVE_BYTES of address
+ * space are reserved at the first allocation and committed on demand. An
+ * allocation moves a pointer. A function releases its temporary strings by
+ * restoring the mark taken on entry, the strings needed until the exit are
+ * allocated by PS_EffectiveMain and never released.
+ *
+ * The growable buffers (environment table, command line, cache records) and
+ * the lines of the trace, which is written when the arena fails, stay on the
+ * process heap.
+ */
+static BYTE  *PS_ArenaBase        = NULL;
+static SIZE_T PS_ArenaUsed        = 0;
+static SIZE_T PS_ArenaCommitted   = 0;
+static SIZE_T PS_ArenaPeak        = 0;
+static DWORD  PS_ArenaAllocations = 0;
+
+/* Return Size bytes aligned on 16 bytes, exit if the arena is full */
+static void *PS_ArenaAlloc (SIZE_T Size)
+{
+  SIZE_T Offset = PS_ArenaUsed;
+  SIZE_T Commit;
+
+  if (PS_ArenaBase == NULL)
+  {
+    PS_ArenaBase = VirtualAlloc(NULL, PS_ARENA_RESERVE_BYTES, MEM_RESERVE, PAGE_NOACCESS);
+    if (PS_ArenaBase == NULL)
+    {
+      PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+    }
+  }
+
+  Size = (Size + 15) & ~(SIZE_T)15;
+  if (Size > (PS_ARENA_RESERVE_BYTES - Offset))
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  if ((Offset + Size) > PS_ArenaCommitted)
+  {
+    Commit = ((Offset + Size - PS_ArenaCommitted) + PS_ARENA_COMMIT_BYTES - 1) & ~(PS_ARENA_COMMIT_BYTES - 1);
+    if (Commit > (PS_ARENA_RESERVE_BYTES - PS_ArenaCommitted))
+    {
+      Commit = PS_ARENA_RESERVE_BYTES - PS_ArenaCommitted;
+    }
+
+    if (VirtualAlloc((PS_ArenaBase + PS_ArenaCommitted), Commit, MEM_COMMIT, PAGE_READWRITE) == NULL)
+    {
+      PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+    }
+    PS_ArenaCommitted += Commit;
+  }
+
+  PS_ArenaUsed = Offset + Size;
+  PS_ArenaAllocations++;
+  if (PS_ArenaUsed > PS_ArenaPeak)
+  {
+    PS_ArenaPeak = PS_ArenaUsed;
+  }
+
+  return (PS_ArenaBase + Offset);
+}
+
+static SIZE_T PS_ArenaMark (void)
+{
+  return PS_ArenaUsed;
+}
+
+/* Release everything allocated after Mark */
+static void PS_ArenaRelease (SIZE_T Mark)
+{
+  SIZE_T Keep = (Mark + PS_ARENA_SLACK_BYTES + PS_ARENA_COMMIT_BYTES - 1) & ~(PS_ARENA_COMMIT_BYTES - 1);
+
+  PS_ArenaUsed = Mark;
+
+  if (PS_ArenaCommitted > Keep)
+  {
+    VirtualFree((PS_ArenaBase + Keep), (PS_ArenaCommitted - Keep), MEM_DECOMMIT);
+    PS_ArenaCommitted = Keep;
+  }
+}
+
+/* Return an empty string of Capacity characters */
+static PS_ARENA_TEXT PS_ArenaText (DWORD Capacity)
+{
+  PS_ARENA_TEXT Text;
+
+  Text.Data     = PS_ArenaAlloc((SIZE_T)Capacity * sizeof(TCHAR));
+  Text.Capacity = Capacity;
+  Text.Data[0]  = _T('\0');
+
+  return Text;
+}
+
+static TCHAR *PS_ArenaCopy (const TCHAR *String)
+{
+  PS_ARENA_TEXT Text = PS_ArenaText((DWORD)lstrlen(String) + 1);
+
+  lstrcpy(Text.Data, String);
+
+  return Text.Data;
+}
+
+/* Return the filename of the executable, or NULL. The buffer starts at
+ * MAX_PATH characters and grows for the long filenames. */
+static TCHAR *PS_ArenaModuleFilename (void)
+{
+  SIZE_T        Mark     = PS_ArenaMark();
+  DWORD         Capacity = MAX_PATH;
+  PS_ARENA_TEXT Text;
+  DWORD         Length;
+
+  for (;;)
+  {
+    Text   = PS_ArenaText(Capacity);
+    Length = GetModuleFileName(NULL, Text.Data, Text.Capacity);
+    if ((Length > 0) && (Length < Text.Capacity))
+    {
+      return Text.Data;
+    }
+
+    PS_ArenaRelease(Mark);
+    if ((Length == 0) || (Capacity >= PS_MAX_FILENAME_LENGTH_CHAR))
+    {
+      return NULL;
+    }
+
+    Capacity = ((Capacity * 2) < PS_MAX_FILENAME_LENGTH_CHAR) ? (Capacity * 2) : (DWORD)PS_MAX_FILENAME_LENGTH_CHAR;
+  }
+}
+
+/*-------------*/
+/* ENVIRONMENT */
+/*-------------*/
+
+/* The environment of the child process is built in memory instead of updating
+ * the environment of Plainstarter with SetEnvironmentVariable. The table and
+ * the expansion of the variables are implemented in plainstarter-env.c, these
+ * functions only report the failures. The table is seeded with the block
+ * returned by GetEnvironmentStrings, which is referenced and not copied.
+ */
+static PS_ENV    PS_Environment;
+static PS_STRING PS_Expanded;
+
+/* Block inherited from the parent process, also given to the broker of the
+ * option process-pool */
+static const TCHAR *PS_ParentEnvironment = NULL;
+
+static void PS_EnvInheritParent (void)
+{
+  const TCHAR *Block;
+
+  Block = GetEnvironmentStrings();
+  if (Block == NULL)
+  {
+    PS_MessageAndExit(14, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  if ((PS_EnvInitialize(&PS_Environment) == 0)
+      || (PS_EnvImportBlock(&PS_Environment, Block) == 0))
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  PS_ParentEnvironment = Block;
+}
+
+/* Set the variable Name, delete it if Value is NULL */
+static void PS_EnvSetVariable (const TCHAR *Name, const TCHAR *Value)
+{
+  if (Name[0] == _T('\0'))
+  {
+    PS_MessageAndExit(8, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  if (PS_EnvSet(&PS_Environment, Name, Value) == 0)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+}
+
+/* Expand the references to the variables of In into PS_Expanded. With the
+ * option report-undefined, a reference to an undefined variable is an
+ * error. */
+static TCHAR *PS_EnvExpandVariable (const TCHAR *In)
+{
+  PS_EXPAND_REPORT Report;
+  PS_ARENA_TEXT    Message;
+  DWORD            BytesWritten;
+  TCHAR            Name[PS_MAX_LINE_LENGTH];
+  size_t           NameLength;
+
+  Report.UndefinedCount = 0;
+
+  if (PS_EnvExpand(&PS_Environment, In, PS_EXPAND_PERCENT, &PS_Expanded, &Report) == 0)
+  {
+    PS_MessageAndExit(7, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  if ((PS_OPTION_REPORT_UNDEFINED == TRUE) && (Report.UndefinedCount > 0))
+  {
+    NameLength = Report.FirstUndefinedLength + 1;
+    if (NameLength > PS_ARRAY_SIZE(Name))
+    {
+      NameLength = PS_ARRAY_SIZE(Name);
+    }
+    lstrcpyn(Name, Report.FirstUndefined, (int)NameLength);
+
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)Name,
+      (DWORD_PTR)In
+    };
+
+    Message      = PS_ArenaText((DWORD)(NameLength + lstrlen(In) + 32));
+    BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                                 | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                                 _T("Undefined variable '%1!s!' in:\n%2!s!"),
+                                 0,
+                                 0,
+                                 Message.Data,
+                                 Message.Capacity,
+                                 (char **)Args);
+
+    PS_MessageAndExit(15, ((BytesWritten > 0) ? Message.Data : PS_UNEXPECTED_ERROR), EXIT_FAILURE);
+  }
+
+  return PS_Expanded.Data;
+}
+
+/*---------------------*/
+/* CONFIGURATION CACHE */
+/*---------------------*/
+
+/* When the option config-cache is enabled, the result of the configuration
+ * processing is stored in a binary file next to the configuration file. The
+ * next launches replay the variables from this file without parsing nor
+ * expanding anything.
+ *
+ * The cache is valid as long as the size and the modification time of the
+ * configuration file are unchanged, and the values of the variables inherited
+ * from the parent process (ie %APPDATA%) are unchanged. These are identified
+ * during the parsing and their values are hashed.
+ *
+ * Layout: PS_CACHE_HEADER, NameCount variable names, RecordCount pairs of
+ * name/value. All the strings are null-terminated. The values are expanded,
+ * except for PLAINSTARTER_CMD_LINE which is expanded at each launch because
+ * the parameters given to Plainstarter are appended to it.
+ *
+ * The option is part of the configuration, it is only known once parsed: the
+ * variables are recorded only when a cache file exists. A launch finding the
+ * option without recording creates an empty cache file, the next launch
+ * records the variables and writes the cache. The configurations without the
+ * option only pay for the lookup of the cache file.
+ */
+typedef struct {
+  DWORD    Magic;
+  DWORD    Size;
+  DWORD    ConfigSizeLow;
+  DWORD    ConfigSizeHigh;
+  FILETIME ConfigWriteTime;
+  DWORD    EnvironmentHash;
+  DWORD    NameCount;
+  DWORD    RecordCount;
+} PS_CACHE_HEADER;
+
+/* Growable heap buffer */
+typedef struct {
+  BYTE   *Data;
+  SIZE_T  Size;
+  SIZE_T  Capacity;
+} PS_BUFFER;
+
+#define PS_FNV_OFFSET_BASIS ((DWORD)2166136261)
+#define PS_FNV_PRIME        ((DWORD)16777619)
+
+static BOOL      PS_CacheRecording       = FALSE;
+static BOOL      PS_CacheExists          = FALSE;
+static PS_BUFFER PS_CacheNames;
+static PS_BUFFER PS_CacheRecords;
+static DWORD     PS_CacheNameCount       = 0;
+static DWORD     PS_CacheRecordCount     = 0;
+static DWORD     PS_CacheEnvironmentHash = PS_FNV_OFFSET_BASIS;
+
+/* Names of PS_CacheNames and PS_CacheRecords, the values are empty */
+static PS_ENV    PS_CacheKnownNames;
+
+/* Destination of the recording, and size of the names and records at the
+ * last write */
+static const TCHAR                     *PS_CacheFilename   = NULL;
+static const WIN32_FILE_ATTRIBUTE_DATA *PS_CacheConfigInfo = NULL;
+static SIZE_T                           PS_CacheWrittenSize = (SIZE_T)-1;
+
+static void PS_BufferAppend (PS_BUFFER  *Buffer,
+                             const void *Data,
+                             SIZE_T      Size)
+{
+  const BYTE *pi = Data;
+  BYTE       *NewData;
+  SIZE_T      NewCapacity;
+  SIZE_T      Index;
+
+  if ((Buffer->Size + Size) > Buffer->Capacity)
+  {
+    NewCapacity = (Buffer->Capacity * 2) + Size + 4096;
+
+    if (Buffer->Data == NULL)
+    {
+      NewData = HeapAlloc(GetProcessHeap(), 0, NewCapacity);
+    }
+    else
+    {
+      NewData = HeapReAlloc(GetProcessHeap(), 0, Buffer->Data, NewCapacity);
+    }
+
+    if (NewData == NULL)
+    {
+      PS_MessageAndExit(12, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+    }
+
+    Buffer->Data     = NewData;
+    Buffer->Capacity = NewCapacity;
+  }
+
+  for (Index = 0 ; Index < Size ; Index++)
+  {
+    Buffer->Data[Buffer->Size + Index] = pi[Index];
+  }
+  Buffer->Size += Size;
+}
+
+static void PS_BufferAppendString (PS_BUFFER *Buffer, const TCHAR *String)
+{
+  PS_BufferAppend(Buffer, String, ((lstrlen(String) + 1) * sizeof(TCHAR)));
+}
+
+/* FNV-1a, including the null character */
+static DWORD PS_HashString (DWORD Hash, const TCHAR *String)
+{
+  const TCHAR *p = String;
+
+  do
+  {
+    Hash = (Hash ^ (DWORD)*p) * PS_FNV_PRIME;
+  } while (*p++);
+
+  return Hash;
+}
+
+/* Hash the name and the current value of an environment variable, return
+ * TRUE if the variable is defined */
+static BOOL PS_HashVariable (DWORD *Hash, const TCHAR *Name)
+{
+  const TCHAR *Value = PS_EnvGet(&PS_Environment, Name, lstrlen(Name));
+  BOOL         Defined;
+
+  Defined = (Value != NULL);
+
+  *Hash = PS_HashString(*Hash, Name);
+  if (Defined == TRUE)
+  {
+    *Hash = PS_HashString(*Hash, Value);
+  }
+  else
+  {
+    *Hash = (*Hash ^ (DWORD)0xFFFF) * PS_FNV_PRIME;
+  }
+
+  return Defined;
+}
+
+/* Return TRUE if Name is already recorded as a referenced variable or as a
+ * variable defined by the configuration */
+static BOOL PS_CacheIsKnownName (const TCHAR *Name)
+{
+  return (PS_EnvGet(&PS_CacheKnownNames, Name, lstrlen(Name)) != NULL);
+}
+
+static void PS_CacheAddKnownName (const TCHAR *Name)
+{
+  if (PS_EnvSet(&PS_CacheKnownNames, Name, _T("")) == 0)
+  {
+    PS_MessageAndExit(12, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+}
+
+/* Record the variables referenced by Value which are not defined by the
+ * configuration itself. The references are searched the same way as
+ * PS_EnvExpand: an undefined %NAME% is kept as-is and its
+ * closing '%' can start another reference.
+ */
+static void PS_CacheRecordReferences (const TCHAR *Value)
+{
+  TCHAR        Name[PS_MAX_LINE_LENGTH];
+  const TCHAR *p;
+  const TCHAR *NameEnd;
+  BOOL         Defined;
+  size_t       Length;
+
+  p = Value;
+  while (*p)
+  {
+    if (*p == _T('%'))
+    {
+      NameEnd = p + 1;
+      while ((*NameEnd) && (*NameEnd != _T('%')))
+      {
+        NameEnd++;
+      }
+
+      if (*NameEnd == _T('\0'))
+      {
+        break;
+      }
+
+      Length  = NameEnd - (p + 1);
+      Defined = FALSE;
+
+      if ((Length > 0) && (Length < PS_MAX_LINE_LENGTH))
+      {
+        lstrcpyn(Name, (p + 1), (Length + 1));
+
+        if (PS_CacheIsKnownName(Name) == TRUE)
+        {
+          Defined = TRUE;
+        }
+        else
+        {
+          Defined = PS_HashVariable(&PS_CacheEnvironmentHash, Name);
+          PS_BufferAppendString(&PS_CacheNames, Name);
+          PS_CacheAddKnownName(Name);
+          PS_CacheNameCount++;
+        }
+      }
+
+      p = (Defined == TRUE) ? (NameEnd + 1) : NameEnd;
+    }
+    else
+    {
+      p++;
+    }
+  }
+}
+
+static void PS_CacheRecordVariable (const TCHAR *Name, const TCHAR *Value)
+{
+  PS_BufferAppendString(&PS_CacheRecords, Name);
+  PS_BufferAppendString(&PS_CacheRecords, Value);
+  PS_CacheAddKnownName(Name);
+  PS_CacheRecordCount++;
+}
+
+/* Record the processing of the configuration into CacheFilename */
+static void PS_CacheStartRecording (const TCHAR                     *CacheFilename,
+                                    const WIN32_FILE_ATTRIBUTE_DATA *ConfigInfo)
+{
+  if (PS_EnvInitialize(&PS_CacheKnownNames) == 0)
+  {
+    PS_MessageAndExit(12, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  PS_CacheFilename   = CacheFilename;
+  PS_CacheConfigInfo = ConfigInfo;
+  PS_CacheRecording  = TRUE;
+}
+
+/* Return the position following the null-terminated string p, or NULL if
+ * the string is not terminated before End */
+static const TCHAR *PS_CacheNextString (const TCHAR *p, const TCHAR *End)
+{
+  while ((p < End) && (*p))
+  {
+    p++;
+  }
+
+  return (p < End) ? (p + 1) : NULL;
+}
+
+static BOOL PS_CacheValidate (const PS_CACHE_HEADER           *Header,
+                              DWORD                            FileSize,
+                              const WIN32_FILE_ATTRIBUTE_DATA *ConfigInfo)
+{
+  const TCHAR *p;
+  const TCHAR *End;
+  DWORD        Hash;
+  DWORD        Index;
+  BOOL         Valid;
+
+  Valid = (Header->Magic == PS_CACHE_MAGIC)
+    && (Header->Size == FileSize)
+    && (Header->ConfigSizeLow  == ConfigInfo->nFileSizeLow)
+    && (Header->ConfigSizeHigh == ConfigInfo->nFileSizeHigh)
+    && (CompareFileTime(&Header->ConfigWriteTime, &ConfigInfo->ftLastWriteTime) == 0);
+
+  p   = (const TCHAR *)(Header + 1);
+  End = (const TCHAR *)((const BYTE *)Header + FileSize);
+
+  /* Compare the inherited variables */
+  Hash = PS_FNV_OFFSET_BASIS;
+  for (Index = 0 ; (Index < Header->NameCount) && (Valid == TRUE) ; Index++)
+  {
+    if (PS_CacheNextString(p, End) == NULL)
+    {
+      Valid = FALSE;
+    }
+    else
+    {
+      PS_HashVariable(&Hash, p);
+      p = PS_CacheNextString(p, End);
+    }
+  }
+
+  if ((Valid == TRUE) && (Hash != Header->EnvironmentHash))
+  {
+    Valid = FALSE;
+  }
+
+  /* Check that the records are well-formed before using any of them */
+  for (Index = 0 ; (Index < (Header->RecordCount * 2)) && (Valid == TRUE) ; Index++)
+  {
+    p     = PS_CacheNextString(p, End);
+    Valid = (p != NULL);
+  }
+
+  return Valid;
+}
+
+/* Return the name of the cache file, allocated in the arena */
+static TCHAR *PS_GetCacheFilename (const TCHAR *ConfigFilename)
+{
+  int           Length = lstrlen(ConfigFilename);
+  PS_ARENA_TEXT Text;
+
+  Text = PS_ArenaText((DWORD)(Length + PS_ARRAY_SIZE(PS_CACHE_SUFFIX)));
+  lstrcpy(Text.Data, ConfigFilename);
+  lstrcpy((Text.Data + Length), PS_CACHE_SUFFIX);
+
+  return Text.Data;
+}
+
+/* Write the cache file. A temporary file is written and renamed, so that
+ * concurrent launchers never read a partial file. Failures are silent: the
+ * configuration will be parsed again at the next launch.
+ */
+static void PS_CacheWrite (const TCHAR                     *CacheFilename,
+                           const WIN32_FILE_ATTRIBUTE_DATA *ConfigInfo)
+{
+  PS_CACHE_HEADER Header;
+  SIZE_T          Mark = PS_ArenaMark();
+  PS_ARENA_TEXT   Temporary;
+  HANDLE          Outfile;
+  DWORD           BytesWritten;
+  BOOL            Success;
+
+  Header.Magic           = PS_CACHE_MAGIC;
+  Header.Size            = sizeof(Header) + PS_CacheNames.Size + PS_CacheRecords.Size;
+  Header.ConfigSizeLow   = ConfigInfo->nFileSizeLow;
+  Header.ConfigSizeHigh  = ConfigInfo->nFileSizeHigh;
+  Header.ConfigWriteTime = ConfigInfo->ftLastWriteTime;
+  Header.EnvironmentHash = PS_CacheEnvironmentHash;
+  Header.NameCount       = PS_CacheNameCount;
+  Header.RecordCount     = PS_CacheRecordCount;
+
+  Temporary = PS_ArenaText((DWORD)lstrlen(CacheFilename) + 5);
+  lstrcpy(Temporary.Data, CacheFilename);
+  lstrcat(Temporary.Data, _T(".tmp"));
+
+  Outfile = CreateFile(Temporary.Data,
+                       GENERIC_WRITE,
+                       0,
+                       NULL,
+                       CREATE_ALWAYS,
+                       FILE_ATTRIBUTE_NORMAL,
+                       NULL);
+
+  if (Outfile != INVALID_HANDLE_VALUE)
+  {
+    Success = WriteFile(Outfile, &Header, sizeof(Header), &BytesWritten, NULL)
+      && WriteFile(Outfile, PS_CacheNames.Data, PS_CacheNames.Size, &BytesWritten, NULL)
+      && WriteFile(Outfile, PS_CacheRecords.Data, PS_CacheRecords.Size, &BytesWritten, NULL);
+
+    CloseHandle(Outfile);
+
+    if ((Success == FALSE)
+        || (MoveFileEx(Temporary.Data, CacheFilename, MOVEFILE_REPLACE_EXISTING) == 0))
+    {
+      DeleteFile(Temporary.Data);
+    }
+  }
+
+  PS_ArenaRelease(Mark);
+}
+
+/* Write the cache if something was recorded since the last write. Called
+ * before starting the process, which can be monitored for hours, and at the
+ * end of the configuration for the lines following PLAINSTARTER_CMD_LINE. */
+static void PS_CacheFlush (void)
+{
+  SIZE_T Size = PS_CacheNames.Size + PS_CacheRecords.Size;
+
+  if ((PS_CacheRecording == TRUE)
+      && (PS_OPTION_CONFIG_CACHE == TRUE)
+      && (Size != PS_CacheWrittenSize))
+  {
+    PS_CacheWrite(PS_CacheFilename, PS_CacheConfigInfo);
+    PS_CacheWrittenSize = Size;
+  }
+}
+
+/* The option is enabled but nothing was recorded: an empty cache file
+ * enables the recording at the next launch */
+static void PS_CacheRequest (const TCHAR *CacheFilename)
+{
+  HANDLE Outfile;
+
+  Outfile = CreateFile(CacheFilename,
+                       GENERIC_WRITE,
+                       0,
+                       NULL,
+                       CREATE_NEW,
+                       FILE_ATTRIBUTE_NORMAL,
+                       NULL);
+  if (Outfile != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(Outfile);
+  }
+}
+
+/*----------------*/
+/* MAIN FUNCTIONS */
+/*----------------*/
+
+/* Return the filename of the first configuration file found, or NULL. The
+ * candidates are built in a buffer of the arena and each of them is probed
+ * with a single attribute query, which also provides the size and the
+ * modification time used to validate the cache. Only the buffer of the
+ * filename found is kept.
+ */
+static int PS_ProbeConfigFilename (void *Context, const TCHAR *Filename)
+{
+  WIN32_FILE_ATTRIBUTE_DATA *ConfigInfo = Context;
+
+  return (GetFileAttributesEx(Filename, GetFileExInfoStandard, ConfigInfo) != 0)
+    && ((ConfigInfo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0);
+}
+
+static TCHAR *PS_FindConfigFilename (const TCHAR               *Executable,
+                                     WIN32_FILE_ATTRIBUTE_DATA *ConfigInfo)
+{
+  SIZE_T        Start = PS_ArenaMark();
+  SIZE_T        Mark;
+  PS_ARENA_TEXT SearchList;
+  PS_ARENA_TEXT Candidate;
+  DWORD         Capacity;
+  DWORD         Length;
+  BOOL          Found;
+
+  Capacity = GetEnvironmentVariable(_T("PLAINSTARTER_CONFIG_DIRS"), NULL, 0);
+  if (Capacity <= (DWORD)lstrlen(PS_CONFIG_SEARCH_LIST))
+  {
+    Capacity = (DWORD)lstrlen(PS_CONFIG_SEARCH_LIST) + 1;
+  }
+
+  /* The longest candidate is made of the executable name, the longest entry,
+   * a separator and ".cfg", see PS_GetConfigFilename */
+  Candidate = PS_ArenaText((DWORD)lstrlen(Executable) + Capacity + 6);
+  Mark      = PS_ArenaMark();
+
+  SearchList = PS_ArenaText(Capacity);
+  Length     = GetEnvironmentVariable(_T("PLAINSTARTER_CONFIG_DIRS"), SearchList.Data, SearchList.Capacity);
+  if ((Length == 0) || (Length >= SearchList.Capacity))
+  {
+    lstrcpy(SearchList.Data, PS_CONFIG_SEARCH_LIST);
+  }
+
+  Found = PS_SearchConfigFilename(SearchList.Data,
+                                  Executable,
+                                  Candidate.Data,
+                                  Candidate.Capacity,
+                                  PS_ProbeConfigFilename,
+                                  ConfigInfo);
+
+  PS_ArenaRelease((Found == TRUE) ? Mark : Start);
+
+  return (Found == TRUE) ? Candidate.Data : NULL;
+}
+
+/* Return the directory where is located the plainstarter binary, allocated
+ * in the arena. ModuleFilename is the full path of the executable, or NULL.
+ */
+static TCHAR *PS_LocateWin32BinaryDirectory (const TCHAR *ModuleFilename)
+{
+  TCHAR  *Buffer;
+  TCHAR  *Progname;
+  TCHAR  *LastBackslash;
+  TCHAR  *LastDot;
+  TCHAR  *p;
+
+  /* The copy is truncated in place */
+  Buffer = (ModuleFilename != NULL) ? PS_ArenaCopy(ModuleFilename) : NULL;
+  if (Buffer != NULL)
+  {
+    /* Find the end of the string and last backslash location */
+    LastBackslash = Buffer;
+    LastDot       = NULL;
+    p             = Buffer;
+    while (*p)
+    {
+      if (*p == _T('\\'))
+      {
+        LastBackslash = p;
+      }
+      else if (*p == _T('.'))
+      {
+        LastDot = p;
+      }
+      p++;
+    }
+
+    /* Set Progname, a dot of the directory is not an extension */
+    Progname = LastBackslash + 1;
+    if (LastDot > LastBackslash)
+    {
+      *LastDot = _T('\0');
+    }
+    PS_EnvSetVariable(_T("PLAINSTARTER_PROGNAME"), Progname);
+
+    /* The directory is the beginning of the filename */
+    *LastBackslash = _T('\0');
+  }
+
+  return Buffer;
+}
+
+static void PS_ReportExecutionError (int ErrorCode)
+{
+  PS_ARENA_TEXT Message = PS_ArenaText(256);
+  DWORD         BytesWritten;
+
+  DWORD_PTR Args[] = {
+    (DWORD_PTR)ErrorCode
+  };
+
+  BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                               | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                               _T("Plainstarter\n")
+                               _T("The child process terminated abnormally.\n")
+                               _T("Return code %1!d! (0x%1!x!)"),
+                               0,
+                               0,
+                               Message.Data,
+                               Message.Capacity,
+                               (char **)Args);
+
+  PS_HeadlessChildExit = (LONGLONG)(DWORD)ErrorCode;
+
+  if (BytesWritten > 0)
+  {
+    PS_MessageAndExit(5, Message.Data, MB_ICONERROR);
+  }
+  else
+  {
+    PS_MessageAndExit(6, PS_UNEXPECTED_ERROR, MB_ICONERROR);
+  }
+}
+
+/*------------*/
+/* JOB OBJECT */
+/*------------*/
+
+/* With the options job-memory, process-memory, cpu-rate, active-processes or
+ * kill-on-close, the child processes and their own children are placed in a
+ * Job Object. The processes are created suspended and resumed once they are
+ * assigned to the job, so that no grandchild can escape it.
+ *
+ * The notifications of the job are read by a thread: a memory or active
+ * process limit violation terminates the whole job, the exit code of the
+ * processes is then ERROR_NOT_ENOUGH_QUOTA or ERROR_NO_PROC_SLOTS and is
+ * reported like any other exit code. The violations are only detected while
+ * Plainstarter is running, ie with monitor-process.
+ *
+ * The option stats also creates a job, only to account the whole tree of
+ * processes: without limits, a process which cannot be assigned to the job
+ * (ie Plainstarter already in a job on Windows 7) is started anyway.
+ */
+static HANDLE PS_Job     = NULL;
+static HANDLE PS_JobPort = NULL;
+
+static BOOL PS_JobHasLimits (void)
+{
+  return (PS_OPTION_JOB_MEMORY > 0)
+    || (PS_OPTION_PROCESS_MEMORY > 0)
+    || (PS_OPTION_CPU_RATE > 0)
+    || (PS_OPTION_ACTIVE_PROCESSES > 0)
+    || (PS_OPTION_KILL_ON_CLOSE == TRUE);
+}
+
+static BOOL PS_JobIsEnabled (void)
+{
+  return (PS_JobHasLimits() == TRUE)
+    || ((PS_OPTION_STATS == TRUE)
+        && ((PS_OPTION_MONITOR_PROCESS == TRUE) || (PS_OPTION_DEBUG == TRUE)));
+}
+
+static DWORD WINAPI PS_JobWatch (LPVOID Parameter)
+{
+  DWORD        Message;
+  ULONG_PTR    Key;
+  LPOVERLAPPED Overlapped;
+
+  while (GetQueuedCompletionStatus(PS_JobPort, &Message, &Key, &Overlapped, INFINITE) == TRUE)
+  {
+    switch (Message)
+    {
+    case JOB_OBJECT_MSG_JOB_MEMORY_LIMIT:
+    case JOB_OBJECT_MSG_PROCESS_MEMORY_LIMIT:
+      TerminateJobObject(PS_Job, ERROR_NOT_ENOUGH_QUOTA);
+      break;
+
+    case JOB_OBJECT_MSG_ACTIVE_PROCESS_LIMIT:
+      TerminateJobObject(PS_Job, ERROR_NO_PROC_SLOTS);
+      break;
+    }
+  }
+
+  return 0;
+}
+
+static void PS_JobCreate (void)
+{
+  JOBOBJECT_EXTENDED_LIMIT_INFORMATION   Limits;
+  JOBOBJECT_CPU_RATE_CONTROL_INFORMATION Rate;
+  JOBOBJECT_ASSOCIATE_COMPLETION_PORT    Port;
+  HANDLE                                 Thread;
+  BOOL                                   Success;
+
+  PS_Job = CreateJobObject(NULL, NULL);
+  Success = (PS_Job != NULL);
+
+  if (Success == TRUE)
+  {
+    SecureZeroMemory(&Limits, sizeof(Limits));
+
+    if (PS_OPTION_JOB_MEMORY > 0)
+    {
+      Limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_JOB_MEMORY;
+      Limits.JobMemoryLimit                    = (SIZE_T)PS_OPTION_JOB_MEMORY;
+    }
+
+    if (PS_OPTION_PROCESS_MEMORY > 0)
+    {
+      Limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_MEMORY;
+      Limits.ProcessMemoryLimit                = (SIZE_T)PS_OPTION_PROCESS_MEMORY;
+    }
+
+    if (PS_OPTION_ACTIVE_PROCESSES > 0)
+    {
+      Limits.BasicLimitInformation.LimitFlags        |= JOB_OBJECT_LIMIT_ACTIVE_PROCESS;
+      Limits.BasicLimitInformation.ActiveProcessLimit = PS_OPTION_ACTIVE_PROCESSES;
+    }
+
+    if (PS_OPTION_KILL_ON_CLOSE == TRUE)
+    {
+      Limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    }
+
+    Success = SetInformationJobObject(PS_Job, JobObjectExtendedLimitInformation, &Limits, sizeof(Limits));
+  }
+
+  /* Hard cap, in 1/100 of percent of all the processors (Windows 8) */
+  if ((Success == TRUE) && (PS_OPTION_CPU_RATE > 0))
+  {
+    SecureZeroMemory(&Rate, sizeof(Rate));
+    Rate.ControlFlags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE | JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+    Rate.CpuRate      = PS_OPTION_CPU_RATE * 100;
+
+    Success = SetInformationJobObject(PS_Job, JobObjectCpuRateControlInformation, &Rate, sizeof(Rate));
+  }
+
+  if (Success == FALSE)
+  {
+    PS_MessageAndExit(20, _T("The job object could not be created."), EXIT_FAILURE);
+  }
+
+  /* The notifications are optional, the limits apply anyway */
+  PS_JobPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+  if (PS_JobPort != NULL)
+  {
+    Port.CompletionKey  = PS_Job;
+    Port.CompletionPort = PS_JobPort;
+
+    if (SetInformationJobObject(PS_Job, JobObjectAssociateCompletionPortInformation, &Port, sizeof(Port)) == TRUE)
+    {
+      Thread = CreateThread(NULL, 0, PS_JobWatch, NULL, 0, NULL);
+      if (Thread != NULL)
+      {
+        CloseHandle(Thread);
+      }
+    }
+  }
+}
+
+/*------------*/
+/* STATISTICS */
+/*------------*/
+
+/* With the options stats and monitor-process, the resources used by each
+ * monitored process are read once it exits, before its handle is closed:
+ * times, peak working set, page faults, peak commit and I/O. The whole tree,
+ * including the grandchildren, is accounted by the job object, which is
+ * created for this purpose.
+ *
+ * When the environment variable PLAINSTARTER_STATS_FILE is defined, the
+ * statistics are appended to this file as a single JSON line per launch:
+ *
+ * {"utc":"2022-05-01T10:00:00.000Z","pid":1234,"config":"C:\\app\\my-app.cfg",
+ *  "exit":0,"processes":[{"command":"app.exe","exit":0,"wall_ms":1200,
+ *  "user_ms":900,"kernel_ms":80,"peak_working_set":52428800,"page_faults":14000,
+ *  "peak_commit":61440000,"read_bytes":1048576,"write_bytes":4096,
+ *  "read_ops":12,"write_ops":3}],"tree":{"processes":3,"user_ms":1500,
+ *  "kernel_ms":130,"page_faults":30000,"peak_job_memory":90000000,
+ *  "read_bytes":2097152,"write_bytes":8192,"read_ops":40,"write_ops":9}}
+ *
+ * The sizes are in bytes. With the option debug, a summary is displayed.
+ */
+static PS_STRING PS_StatsProcesses;
+static PS_STRING PS_StatsSummary;
+
+/* FILETIME durations are counted in 100 ns */
+static LONGLONG PS_StatsMilliseconds (const FILETIME *Time)
+{
+  return (LONGLONG)((((ULONGLONG)Time->dwHighDateTime << 32) | Time->dwLowDateTime) / 10000);
+}
+
+static void PS_StatsAppendIo (PS_STRING *Line, const IO_COUNTERS *Io)
+{
+  PS_JsonAppendNumber(Line, _T("read_bytes"),  (LONGLONG)Io->ReadTransferCount);
+  PS_JsonAppendNumber(Line, _T("write_bytes"), (LONGLONG)Io->WriteTransferCount);
+  PS_JsonAppendNumber(Line, _T("read_ops"),    (LONGLONG)Io->ReadOperationCount);
+  PS_JsonAppendNumber(Line, _T("write_ops"),   (LONGLONG)Io->WriteOperationCount);
+}
+
+/* Read the statistics of the exited process, the counters which cannot be
+ * read are 0 */
+static void PS_StatsCollect (HANDLE Process, const TCHAR *CommandLine, DWORD ExitCode)
+{
+  PS_STRING               *Line = &PS_StatsProcesses;
+  FILETIME                 Creation;
+  FILETIME                 Exit;
+  FILETIME                 Kernel;
+  FILETIME                 User;
+  PROCESS_MEMORY_COUNTERS  Memory;
+  IO_COUNTERS              Io;
+  LONGLONG                 Wall = 0;
+  SIZE_T                   Mark;
+  PS_ARENA_TEXT            Summary;
+
+  if (PS_OPTION_STATS == FALSE)
+  {
+    return;
+  }
+
+  SecureZeroMemory(&Kernel, sizeof(Kernel));
+  SecureZeroMemory(&User, sizeof(User));
+  SecureZeroMemory(&Memory, sizeof(Memory));
+  SecureZeroMemory(&Io, sizeof(Io));
+
+  if (GetProcessTimes(Process, &Creation, &Exit, &Kernel, &User) == TRUE)
+  {
+    Wall = PS_StatsMilliseconds(&Exit) - PS_StatsMilliseconds(&Creation);
+  }
+  GetProcessMemoryInfo(Process, &Memory, sizeof(Memory));
+  GetProcessIoCounters(Process, &Io);
+
+  PS_JsonAppend(Line, ((Line->Length == 0) ? _T("{\"command\":") : _T(",{\"command\":")));
+  PS_JsonAppendString(Line, CommandLine);
+  PS_JsonAppendNumber(Line, _T("exit"),             ExitCode);
+  PS_JsonAppendNumber(Line, _T("wall_ms"),          Wall);
+  PS_JsonAppendNumber(Line, _T("user_ms"),          PS_StatsMilliseconds(&User));
+  PS_JsonAppendNumber(Line, _T("kernel_ms"),        PS_StatsMilliseconds(&Kernel));
+  PS_JsonAppendNumber(Line, _T("peak_working_set"), (LONGLONG)Memory.PeakWorkingSetSize);
+  PS_JsonAppendNumber(Line, _T("page_faults"),      Memory.PageFaultCount);
+  PS_JsonAppendNumber(Line, _T("peak_commit"),      (LONGLONG)Memory.PeakPagefileUsage);
+  PS_StatsAppendIo(Line, &Io);
+  PS_JsonAppend(Line, _T("}"));
+
+  if (PS_OPTION_DEBUG == TRUE)
+  {
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)CommandLine,
+      (DWORD_PTR)Wall,
+      (DWORD_PTR)PS_StatsMilliseconds(&User),
+      (DWORD_PTR)PS_StatsMilliseconds(&Kernel),
+      (DWORD_PTR)(Memory.PeakWorkingSetSize / 1024),
+      (DWORD_PTR)(Memory.PeakPagefileUsage / 1024),
+      (DWORD_PTR)Memory.PageFaultCount,
+      (DWORD_PTR)Io.ReadTransferCount,
+      (DWORD_PTR)Io.WriteTransferCount
+    };
+
+    Mark    = PS_ArenaMark();
+    Summary = PS_ArenaText((DWORD)lstrlen(CommandLine) + 512);
+    if (FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                      | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                      _T("%1!s!\n")
+                      _T("Time: %2!I64d! ms (user %3!I64d! ms, kernel %4!I64d! ms)\n")
+                      _T("Memory: peak working set %5!I64u! KiB, peak commit %6!I64u! KiB, %7!u! page faults\n")
+                      _T("I/O: %8!I64u! bytes read, %9!I64u! bytes written\n\n"),
+                      0,
+                      0,
+                      Summary.Data,
+                      Summary.Capacity,
+                      (char **)Args) > 0)
+    {
+      PS_JsonAppend(&PS_StatsSummary, Summary.Data);
+    }
+    PS_ArenaRelease(Mark);
+  }
+}
+
+/* Write the statistics of the launch, once all the monitored processes have
+ * exited */
+static void PS_StatsWrite (DWORD ExitCode)
+{
+  PS_STRING                                     Line = { NULL, 0, 0 };
+  JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION Accounting;
+  JOBOBJECT_EXTENDED_LIMIT_INFORMATION          Limits;
+  TCHAR                                         Summary[512];
+
+  if (PS_OPTION_STATS == FALSE)
+  {
+    return;
+  }
+
+  PS_JsonAppendHeader(&Line);
+  PS_JsonAppendNumber(&Line, _T("exit"), ExitCode);
+  PS_JsonAppend(&Line, _T(",\"processes\":["));
+  if (PS_StatsProcesses.Length > 0)
+  {
+    PS_JsonAppend(&Line, PS_StatsProcesses.Data);
+  }
+  PS_JsonAppend(&Line, _T("]"));
+
+  if ((PS_Job != NULL)
+      && (QueryInformationJobObject(PS_Job, JobObjectBasicAndIoAccountingInformation, &Accounting, sizeof(Accounting), NULL) == TRUE)
+      && (QueryInformationJobObject(PS_Job, JobObjectExtendedLimitInformation, &Limits, sizeof(Limits), NULL) == TRUE))
+  {
+    PS_JsonAppend(&Line, _T(",\"tree\":{"));
+    PS_JsonAppendNumber(&Line, _T("processes"),       Accounting.BasicInfo.TotalProcesses);
+    PS_JsonAppendNumber(&Line, _T("user_ms"),         Accounting.BasicInfo.TotalUserTime.QuadPart / 10000);
+    PS_JsonAppendNumber(&Line, _T("kernel_ms"),       Accounting.BasicInfo.TotalKernelTime.QuadPart / 10000);
+    PS_JsonAppendNumber(&Line, _T("page_faults"),     Accounting.BasicInfo.TotalPageFaultCount);
+    PS_JsonAppendNumber(&Line, _T("peak_job_memory"), (LONGLONG)Limits.PeakJobMemoryUsed);
+    PS_StatsAppendIo(&Line, &Accounting.IoInfo);
+    PS_JsonAppend(&Line, _T("}"));
+
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)Accounting.BasicInfo.TotalProcesses,
+      (DWORD_PTR)(Accounting.BasicInfo.TotalUserTime.QuadPart / 10000),
+      (DWORD_PTR)(Accounting.BasicInfo.TotalKernelTime.QuadPart / 10000),
+      (DWORD_PTR)(Limits.PeakJobMemoryUsed / 1024)
+    };
+
+    if ((PS_OPTION_DEBUG == TRUE)
+        && (FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                          | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                          _T("Tree: %1!u! processes, user %2!I64d! ms, kernel %3!I64d! ms, peak memory %4!I64u! KiB"),
+                          0,
+                          0,
+                          Summary,
+                          PS_ARRAY_SIZE(Summary),
+                          (char **)Args) > 0))
+    {
+      PS_JsonAppend(&PS_StatsSummary, Summary);
+    }
+  }
+  PS_JsonAppend(&Line, _T("}\n"));
+
+  PS_JsonWriteLine(_T("PLAINSTARTER_STATS_FILE"), &Line);
+
+  if ((PS_OPTION_DEBUG == TRUE) && (PS_StatsSummary.Length > 0))
+  {
+    PS_MessageBox(NULL, PS_StatsSummary.Data, _T("STATISTICS"), MB_ICONINFORMATION);
+  }
+
+  /* A new launch group starts from scratch, the text of this one included */
+  PS_StringFree(&PS_StatsProcesses);
+  PS_StringFree(&PS_StatsSummary);
+}
+
+/*-----------*/
+/* READINESS */
+/*-----------*/
+
+/* With the option wait-ready, Plainstarter waits for the started process to
+ * be ready before monitoring it or exiting:
+ * - input-idle: WaitForInputIdle, the process waits for user input with no
+ *   input pending. It fails immediately for a console process.
+ * - window: the first visible top-level window without owner, polled every
+ *   PS_READY_POLL_MS. It belongs to the process or, when a job object is
+ *   created, to any process of the job (ie a GUI started by an interpreter).
+ * - both: input-idle, then window.
+ *
+ * The latency is measured from CreateProcess (or from the request to the
+ * process pool) and is bounded by ready-timeout. It is traced as the event
+ * "ready". When the environment variable PLAINSTARTER_HISTORY_FILE is
+ * defined, a JSON line is appended to this launch history:
+ *
+ * {"utc":"2022-05-01T10:00:00.000Z","pid":1234,"config":"C:\\app\\my-app.cfg",
+ *  "command":"app.exe","wait":"window","input_idle_ms":-1,"window_ms":420,
+ *  "ready_ms":420,"samples":25,"p50_ms":410,"p90_ms":530,"p99_ms":610}
+ *
+ * The percentiles are computed over the previous launches of the same
+ * configuration found in the last PS_HISTORY_TAIL_BYTES of the file, along
+ * with this one. "ready_ms" and the percentiles are omitted when the timeout
+ * expires. With the option debug, they are displayed.
+ *
+ * The launch group is not measured. The functions of user32.dll are loaded on
+ * first use.
+ */
+#define PS_READY_INPUT_IDLE 1
+#define PS_READY_WINDOW     2
+
+typedef DWORD (WINAPI *PS_WAIT_FOR_INPUT_IDLE) (HANDLE, DWORD);
+typedef BOOL  (WINAPI *PS_ENUM_WINDOWS) (WNDENUMPROC, LPARAM);
+typedef DWORD (WINAPI *PS_GET_WINDOW_THREAD_PROCESS_ID) (HWND, LPDWORD);
+typedef BOOL  (WINAPI *PS_IS_WINDOW_VISIBLE) (HWND);
+typedef HWND  (WINAPI *PS_GET_WINDOW) (HWND, UINT);
+
+static struct {
+  PS_WAIT_FOR_INPUT_IDLE          WaitForInputIdle;
+  PS_ENUM_WINDOWS                 EnumWindows;
+  PS_GET_WINDOW_THREAD_PROCESS_ID GetWindowThreadProcessId;
+  PS_IS_WINDOW_VISIBLE            IsWindowVisible;
+  PS_GET_WINDOW                   GetWindow;
+} PS_User32;
+
+/* Window found by PS_ReadyEnumWindow */
+typedef struct {
+  DWORD ProcessId;
+  HWND  Window;
+} PS_READY_SEARCH;
+
+/* Set just before the process is created or requested from the pool */
+static LONGLONG PS_ReadyStart = 0;
+
+static void PS_ReadyMarkStart (void)
+{
+  LARGE_INTEGER Now;
+
+  QueryPerformanceCounter(&Now);
+  PS_ReadyStart = Now.QuadPart;
+}
+
+/* Milliseconds elapsed since PS_ReadyStart */
+static LONGLONG PS_ReadyElapsed (void)
+{
+  LARGE_INTEGER Now;
+  LARGE_INTEGER Frequency;
+
+  QueryPerformanceCounter(&Now);
+  QueryPerformanceFrequency(&Frequency);
+
+  return ((Now.QuadPart - PS_ReadyStart) * 1000) / Frequency.QuadPart;
+}
+
+static BOOL PS_ReadyLoadUser32 (void)
+{
+  if (PS_User32.GetWindow == NULL)
+  {
+    PS_User32.WaitForInputIdle         = (PS_WAIT_FOR_INPUT_IDLE)PS_LoadFunction(_T("user32.dll"), "WaitForInputIdle");
+    PS_User32.EnumWindows              = (PS_ENUM_WINDOWS)PS_LoadFunction(_T("user32.dll"), "EnumWindows");
+    PS_User32.GetWindowThreadProcessId = (PS_GET_WINDOW_THREAD_PROCESS_ID)PS_LoadFunction(_T("user32.dll"), "GetWindowThreadProcessId");
+    PS_User32.IsWindowVisible          = (PS_IS_WINDOW_VISIBLE)PS_LoadFunction(_T("user32.dll"), "IsWindowVisible");
+    PS_User32.GetWindow                = (PS_GET_WINDOW)PS_LoadFunction(_T("user32.dll"), "GetWindow");
+  }
+
+  return (PS_User32.WaitForInputIdle != NULL)
+    && (PS_User32.EnumWindows != NULL)
+    && (PS_User32.GetWindowThreadProcessId != NULL)
+    && (PS_User32.IsWindowVisible != NULL)
+    && (PS_User32.GetWindow != NULL);
+}
+
+/* Return TRUE if ProcessId is the started process or one of its job */
+static BOOL PS_ReadyIsLaunched (DWORD ProcessId, DWORD LaunchedId)
+{
+  HANDLE Process;
+  BOOL   InJob = FALSE;
+
+  if (ProcessId == LaunchedId)
+  {
+    return TRUE;
+  }
+
+  if (PS_Job != NULL)
+  {
+    Process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, ProcessId);
+    if (Process != NULL)
+    {
+      if (IsProcessInJob(Process, PS_Job, &InJob) == FALSE)
+      {
+        InJob = FALSE;
+      }
+      CloseHandle(Process);
+    }
+  }
+
+  return InJob;
+}
+
+static BOOL CALLBACK PS_ReadyEnumWindow (HWND Window, LPARAM Parameter)
+{
+  PS_READY_SEARCH *Search    = (PS_READY_SEARCH *)Parameter;
+  DWORD            ProcessId = 0;
+
+  if ((PS_User32.IsWindowVisible(Window) == FALSE)
+      || (PS_User32.GetWindow(Window, GW_OWNER) != NULL))
+  {
+    return TRUE;
+  }
+
+  PS_User32.GetWindowThreadProcessId(Window, &ProcessId);
+  if (PS_ReadyIsLaunched(ProcessId, Search->ProcessId) == TRUE)
+  {
+    Search->Window = Window;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Return the latencies of the input idle state and of the first window in
+ * InputIdle and Window, -1 when not reached */
+static void PS_ReadyWait (const PROCESS_INFORMATION *pi,
+                          LONGLONG                  *InputIdle,
+                          LONGLONG                  *Window)
+{
+  PS_READY_SEARCH Search;
+  DWORD           Timeout = PS_OPTION_READY_TIMEOUT;
+  LONGLONG        Elapsed;
+
+  *InputIdle = -1;
+  *Window    = -1;
+
+  if ((PS_OPTION_WAIT_READY & PS_READY_INPUT_IDLE)
+      && (PS_User32.WaitForInputIdle(pi->hProcess, Timeout) == 0))
+  {
+    *InputIdle = PS_ReadyElapsed();
+  }
+
+  if (PS_OPTION_WAIT_READY & PS_READY_WINDOW)
+  {
+    Search.ProcessId = pi->dwProcessId;
+    Search.Window    = NULL;
+
+    for (;;)
+    {
+      PS_User32.EnumWindows(PS_ReadyEnumWindow, (LPARAM)&Search);
+      Elapsed = PS_ReadyElapsed();
+
+      if (Search.Window != NULL)
+      {
+        *Window = Elapsed;
+        break;
+      }
+
+      /* Exited without window, or too late */
+      if ((Elapsed >= (LONGLONG)Timeout)
+          || (WaitForSingleObject(pi->hProcess, PS_READY_POLL_MS) == WAIT_OBJECT_0))
+      {
+        break;
+      }
+    }
+  }
+}
+
+/* Insert Value in the sorted array Samples of Count values */
+static void PS_HistoryInsert (LONGLONG *Samples, DWORD Count, LONGLONG Value)
+{
+  DWORD Index = Count;
+
+  while ((Index > 0) && (Samples[Index - 1] > Value))
+  {
+    Samples[Index] = Samples[Index - 1];
+    Index--;
+  }
+  Samples[Index] = Value;
+}
+
+/* Read "ready_ms" of the last PS_HISTORY_SAMPLES launches of the
+ * configuration Key in the end of the history file. Return the number of
+ * samples, sorted. */
+static DWORD PS_HistoryRead (const TCHAR *Key, LONGLONG *Samples)
+{
+  SIZE_T         Mark  = PS_ArenaMark();
+  DWORD          Total = 0;
+  DWORD          Count;
+  DWORD          Index;
+  PS_ARENA_TEXT  Filename;
+  PS_ARENA_TEXT  Text;
+  HANDLE         Infile;
+  LARGE_INTEGER  Size;
+  LARGE_INTEGER  Offset;
+  char          *Buffer;
+  DWORD          BytesRead = 0;
+  TCHAR         *Line;
+  TCHAR         *LineEnd;
+  const TCHAR   *p;
+  LONGLONG       Value;
+
+  Filename = PS_ArenaText(GetEnvironmentVariable(_T("PLAINSTARTER_HISTORY_FILE"), NULL, 0) + 1);
+  if (GetEnvironmentVariable(_T("PLAINSTARTER_HISTORY_FILE"), Filename.Data, Filename.Capacity) == 0)
+  {
+    PS_ArenaRelease(Mark);
+    return 0;
+  }
+
+  Infile = CreateFile(Filename.Data,
+                      GENERIC_READ,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE,
+                      NULL,
+                      OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL,
+                      NULL);
+  if (Infile != INVALID_HANDLE_VALUE)
+  {
+    if (GetFileSizeEx(Infile, &Size) == TRUE)
+    {
+      Offset.QuadPart = (Size.QuadPart > (LONGLONG)PS_HISTORY_TAIL_BYTES) ? (Size.QuadPart - (LONGLONG)PS_HISTORY_TAIL_BYTES) : 0;
+      Buffer          = PS_ArenaAlloc(PS_HISTORY_TAIL_BYTES);
+
+      if ((SetFilePointerEx(Infile, Offset, NULL, FILE_BEGIN) == TRUE)
+          && (ReadFile(Infile, Buffer, PS_HISTORY_TAIL_BYTES, &BytesRead, NULL) == TRUE)
+          && (BytesRead > 0))
+      {
+        Text = PS_ArenaText(BytesRead + 1);
+        Text.Data[MultiByteToWideChar(CP_UTF8, 0, Buffer, (int)BytesRead, Text.Data, (int)BytesRead)] = _T('\0');
+
+        /* The first line is partial unless the file is read from the
+         * beginning, the last one is partial if it is being written */
+        Line = Text.Data;
+        if (Offset.QuadPart > 0)
+        {
+          while ((*Line) && (*Line != _T('\n')))
+          {
+            Line++;
+          }
+        }
+
+        while (*Line)
+        {
+          for (LineEnd = Line ; (*LineEnd) && (*LineEnd != _T('\n')) ; LineEnd++)
+          {
+          }
+          if (*LineEnd == _T('\0'))
+          {
+            break;
+          }
+          *LineEnd = _T('\0');
+
+          p = PS_StrStr(Line, _T("\"ready_ms\":"));
+          if ((p != NULL) && (PS_StrStr(Line, Key) != NULL))
+          {
+            for (p += 11, Value = 0 ; (*p >= _T('0')) && (*p <= _T('9')) ; p++)
+            {
+              Value = (Value * 10) + (*p - _T('0'));
+            }
+
+            /* The oldest samples are overwritten */
+            Samples[Total % PS_HISTORY_SAMPLES] = Value;
+            Total++;
+          }
+
+          Line = LineEnd + 1;
+        }
+      }
+    }
+
+    CloseHandle(Infile);
+  }
+
+  PS_ArenaRelease(Mark);
+
+  /* Insertion sort */
+  Count = (Total < PS_HISTORY_SAMPLES) ? Total : PS_HISTORY_SAMPLES;
+  for (Index = 1 ; Index < Count ; Index++)
+  {
+    Value = Samples[Index];
+    PS_HistoryInsert(Samples, Index, Value);
+  }
+
+  return Count;
+}
+
+/* Nearest-rank percentile of the sorted array Samples */
+static LONGLONG PS_HistoryPercentile (const LONGLONG *Samples, DWORD Count, DWORD Percent)
+{
+  DWORD Rank = ((Count * Percent) + 99) / 100;
+
+  return Samples[(Rank > 0) ? (Rank - 1) : 0];
+}
+
+/* Wait until the process is ready, then trace, record and display the
+ * latency */
+static void PS_ReadyRecord (const PROCESS_INFORMATION *pi, const TCHAR *CommandLine)
+{
+  static const TCHAR *Modes[] = { _T(""), _T("input-idle"), _T("window"), _T("both") };
+  static LONGLONG     Samples[PS_HISTORY_SAMPLES + 1];
+  PS_STRING           Line  = { NULL, 0, 0 };
+  PS_STRING           Key   = { NULL, 0, 0 };
+  LONGLONG            InputIdle;
+  LONGLONG            Window;
+  LONGLONG            Ready;
+  DWORD               Count = 0;
+  TCHAR               Summary[256];
+
+  if (PS_ReadyLoadUser32() == FALSE)
+  {
+    return;
+  }
+
+  PS_ReadyWait(pi, &InputIdle, &Window);
+  Ready = (PS_OPTION_WAIT_READY & PS_READY_WINDOW) ? Window : InputIdle;
+  PS_TRACE(_T("ready"), ((Ready >= 0) ? Modes[PS_OPTION_WAIT_READY] : _T("timeout")));
+
+  PS_JsonAppend(&Key, _T("\"config\":"));
+  PS_JsonAppendString(&Key, ((PS_ConfigFilename != NULL) ? PS_ConfigFilename : _T("")));
+
+  if (Ready >= 0)
+  {
+    Count = PS_HistoryRead(Key.Data, Samples);
+    PS_HistoryInsert(Samples, Count++, Ready);
+  }
+
+  PS_JsonAppendHeader(&Line);
+  PS_JsonAppend(&Line, _T(",\"command\":"));
+  PS_JsonAppendString(&Line, CommandLine);
+  PS_JsonAppend(&Line, _T(",\"wait\":"));
+  PS_JsonAppendString(&Line, Modes[PS_OPTION_WAIT_READY]);
+  PS_JsonAppendNumber(&Line, _T("input_idle_ms"), InputIdle);
+  PS_JsonAppendNumber(&Line, _T("window_ms"),     Window);
+  if (Ready >= 0)
+  {
+    PS_JsonAppendNumber(&Line, _T("ready_ms"), Ready);
+    PS_JsonAppendNumber(&Line, _T("samples"),  Count);
+    PS_JsonAppendNumber(&Line, _T("p50_ms"),   PS_HistoryPercentile(Samples, Count, 50));
+    PS_JsonAppendNumber(&Line, _T("p90_ms"),   PS_HistoryPercentile(Samples, Count, 90));
+    PS_JsonAppendNumber(&Line, _T("p99_ms"),   PS_HistoryPercentile(Samples, Count, 99));
+  }
+  PS_JsonAppend(&Line, _T("}\n"));
+
+  PS_JsonWriteLine(_T("PLAINSTARTER_HISTORY_FILE"), &Line);
+  PS_StringFree(&Key);
+
+  if (PS_OPTION_DEBUG == TRUE)
+  {
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)Ready,
+      (DWORD_PTR)InputIdle,
+      (DWORD_PTR)Window,
+      (DWORD_PTR)Count,
+      (DWORD_PTR)((Count > 0) ? PS_HistoryPercentile(Samples, Count, 50) : -1),
+      (DWORD_PTR)((Count > 0) ? PS_HistoryPercentile(Samples, Count, 90) : -1),
+      (DWORD_PTR)((Count > 0) ? PS_HistoryPercentile(Samples, Count, 99) : -1)
+    };
+
+    if (FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                      | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                      _T("Ready: %1!I64d! ms (input idle %2!I64d! ms, window %3!I64d! ms)\n")
+                      _T("Last %4!u! launches: p50 %5!I64d! ms, p90 %6!I64d! ms, p99 %7!I64d! ms"),
+                      0,
+                      0,
+                      Summary,
+                      PS_ARRAY_SIZE(Summary),
+                      (char **)Args) > 0)
+    {
+      PS_MessageBox(NULL, Summary, _T("READY"), MB_ICONINFORMATION);
+    }
+  }
+}
+
+/*----------------*/
+/* OUTPUT CAPTURE */
+/*----------------*/
+
+/* With the option capture-output, the standard output and error of the child
+ * processes are pipes read by a thread of Plainstarter. Each pipe is read
+ * with overlapped I/O in two large buffers: the next read is pending while
+ * the previous data is written, so that the child does not wait for the log
+ * file. The data is copied unchanged to the standard handles of Plainstarter,
+ * if any, and to the log file.
+ *
+ * The log file is PLAINSTARTER_LOG_FILE, by default %TEMP%\<name of the
+ * configuration>.log. When it exceeds log-size, it is renamed to .1, the
+ * previous .1 to .2 and so on, keeping log-files old files.
+ */
+typedef struct {
+  HANDLE     Pipe;       /* Read end, overlapped            */
+  HANDLE     Writer;     /* Write end, inherited by the children */
+  HANDLE     Console;    /* Standard handle of Plainstarter */
+  OVERLAPPED Overlapped;
+  BYTE      *Buffers[2];
+  DWORD      Current;    /* Buffer of the pending read      */
+  BOOL       Pending;
+} PS_CAPTURE_STREAM;
+
+static PS_CAPTURE_STREAM PS_CaptureStreams[2];
+static HANDLE            PS_CaptureThread   = NULL;
+static BOOL              PS_CaptureStopping = FALSE;
+static HANDLE            PS_CaptureLog      = INVALID_HANDLE_VALUE;
+static ULONGLONG         PS_CaptureLogSize  = 0;
+static DWORD             PS_CaptureRunCount = 0;
+static TCHAR             PS_CaptureFilename[1024];
+
+/* %TEMP%\<name of the configuration>.log when PLAINSTARTER_LOG_FILE is not
+ * set */
+static void PS_CaptureGetFilename (void)
+{
+  const TCHAR *ProgName = PS_ConfigFilename;
+  const TCHAR *Extension;
+  const TCHAR *p;
+  DWORD        Length;
+
+  if (PS_CaptureFilename[0] != _T('\0'))
+  {
+    return;
+  }
+
+  for (p = PS_ConfigFilename ; *p ; p++)
+  {
+    if ((*p == _T('\\')) || (*p == _T('/')))
+    {
+      ProgName = p + 1;
+    }
+  }
+
+  /* my-app.cfg, or my-app.exe with an embedded configuration: my-app.log */
+  Extension = p;
+  for (p = ProgName ; *p ; p++)
+  {
+    if (*p == _T('.'))
+    {
+      Extension = p;
+    }
+  }
+
+  Length = GetTempPath(PS_ARRAY_SIZE(PS_CaptureFilename), PS_CaptureFilename);
+  if ((Length == 0)
+      || ((Length + (DWORD)(Extension - ProgName) + 5) >= PS_ARRAY_SIZE(PS_CaptureFilename)))
+  {
+    PS_CaptureFilename[0] = _T('\0');
+    return;
+  }
+
+  /* lstrcpyn includes the null character */
+  lstrcpyn(PS_CaptureFilename + Length, ProgName, (int)(Extension - ProgName) + 1);
+  lstrcat(PS_CaptureFilename, _T(".log"));
+}
+
+static void PS_CaptureOpenLog (void)
+{
+  LARGE_INTEGER Size;
+
+  PS_CaptureLog = CreateFile(PS_CaptureFilename,
+                             FILE_APPEND_DATA,
+                             FILE_SHARE_READ | FILE_SHARE_DELETE,
+                             NULL,
+                             OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL,
+                             NULL);
+
+  PS_CaptureLogSize = 0;
+  if ((PS_CaptureLog != INVALID_HANDLE_VALUE) && (GetFileSizeEx(PS_CaptureLog, &Size) == TRUE))
+  {
+    PS_CaptureLogSize = (ULONGLONG)Size.QuadPart;
+  }
+}
+
+/* my-app.log.2 to my-app.log.3, my-app.log.1 to my-app.log.2, my-app.log to
+ * my-app.log.1 */
+static void PS_CaptureRotateLog (void)
+{
+  /* Static: both paths on the stack need ___chkstk_ms, the log is only
+   * rotated by the thread draining the pipes */
+  static TCHAR From[1040];
+  static TCHAR To[1040];
+  DWORD        Index;
+
+  CloseHandle(PS_CaptureLog);
+
+  for (Index = PS_OPTION_LOG_FILES ; Index > 0 ; Index--)
+  {
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)PS_CaptureFilename,
+      (DWORD_PTR)(Index - 1),
+      (DWORD_PTR)Index
+    };
+
+    if ((FormatMessage(FORMAT_MESSAGE_FROM_STRING | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                       ((Index == 1) ? _T("%1!s!") : _T("%1!s!.%2!u!")),
+                       0, 0, From, PS_ARRAY_SIZE(From), (char **)Args) > 0)
+        && (FormatMessage(FORMAT_MESSAGE_FROM_STRING | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                          _T("%1!s!.%3!u!"),
+                          0, 0, To, PS_ARRAY_SIZE(To), (char **)Args) > 0))
+    {
+      MoveFileEx(From, To, MOVEFILE_REPLACE_EXISTING);
+    }
+  }
+
+  if (PS_OPTION_LOG_FILES == 0)
+  {
+    DeleteFile(PS_CaptureFilename);
+  }
+
+  PS_CaptureOpenLog();
+}
+
+static void PS_CaptureWrite (PS_CAPTURE_STREAM *Stream, const BYTE *Data, DWORD Length)
+{
+  DWORD BytesWritten;
+
+  /* The console or the redirection of Plainstarter can be closed */
+  if ((Stream->Console != NULL)
+      && (WriteFile(Stream->Console, Data, Length, &BytesWritten, NULL) == FALSE))
+  {
+    Stream->Console = NULL;
+  }
+
+  if (PS_CaptureLog != INVALID_HANDLE_VALUE)
+  {
+    if ((PS_OPTION_LOG_SIZE > 0)
+        && (PS_CaptureLogSize > 0)
+        && ((PS_CaptureLogSize + Length) > PS_OPTION_LOG_SIZE))
+    {
+      PS_CaptureRotateLog();
+    }
+
+    if ((PS_CaptureLog != INVALID_HANDLE_VALUE)
+        && (WriteFile(PS_CaptureLog, Data, Length, &BytesWritten, NULL) == TRUE))
+    {
+      PS_CaptureLogSize += BytesWritten;
+    }
+  }
+}
+
+/* Start the next read in the current buffer, the pipe is closed when all the
+ * processes holding the write end have exited */
+static void PS_CaptureRead (PS_CAPTURE_STREAM *Stream)
+{
+  Stream->Pending = (PS_CaptureStopping == FALSE)
+    && ((ReadFile(Stream->Pipe,
+                              Stream->Buffers[Stream->Current],
+                              PS_CAPTURE_BUFFER_SIZE,
+                              NULL,
+                              &Stream->Overlapped) == TRUE)
+        || (GetLastError() == ERROR_IO_PENDING));
+}
+
+static DWORD WINAPI PS_CaptureDrain (LPVOID Parameter)
+{
+  PS_CAPTURE_STREAM *Stream;
+  PS_CAPTURE_STREAM *Waited[2];
+  HANDLE             Events[2];
+  const BYTE        *Data;
+  DWORD              Count;
+  DWORD              Index;
+  DWORD              BytesRead;
+
+  for (Index = 0 ; Index < 2 ; Index++)
+  {
+    PS_CaptureRead(&PS_CaptureStreams[Index]);
+  }
+
+  for (;;)
+  {
+    Count = 0;
+    for (Index = 0 ; Index < 2 ; Index++)
+    {
+      if (PS_CaptureStreams[Index].Pending == TRUE)
+      {
+        Waited[Count] = &PS_CaptureStreams[Index];
+        Events[Count] = PS_CaptureStreams[Index].Overlapped.hEvent;
+        Count++;
+      }
+    }
+
+    if (Count == 0)
+    {
+      break;
+    }
+
+    Index = WaitForMultipleObjects(Count, Events, FALSE, INFINITE) - WAIT_OBJECT_0;
+    if (Index >= Count)
+    {
+      break;
+    }
+
+    Stream = Waited[Index];
+    if (GetOverlappedResult(Stream->Pipe, &Stream->Overlapped, &BytesRead, FALSE) == FALSE)
+    {
+      /* ERROR_BROKEN_PIPE: end of the output, or the read is cancelled */
+      Stream->Pending = FALSE;
+      continue;
+    }
+
+    /* Read in the other buffer while this one is written */
+    Data            = Stream->Buffers[Stream->Current];
+    Stream->Current = 1 - Stream->Current;
+    PS_CaptureRead(Stream);
+
+    PS_CaptureWrite(Stream, Data, BytesRead);
+  }
+
+  return 0;
+}
+
+/* Create the pipes given to the child processes and start reading them */
+static void PS_CaptureStart (void)
+{
+  PS_CAPTURE_STREAM   *Stream;
+  SECURITY_ATTRIBUTES  Inheritable;
+  TCHAR                PipeName[64];
+  DWORD                Index;
+  BOOL                 Success = TRUE;
+
+  Inheritable.nLength              = sizeof(Inheritable);
+  Inheritable.lpSecurityDescriptor = NULL;
+  Inheritable.bInheritHandle       = TRUE;
+
+  if (PS_CaptureLog == INVALID_HANDLE_VALUE)
+  {
+    PS_CaptureGetFilename();
+    if (PS_CaptureFilename[0] != _T('\0'))
+    {
+      PS_CaptureOpenLog();
+    }
+  }
+
+  PS_CaptureRunCount++;
+  PS_CaptureStopping = FALSE;
+
+  for (Index = 0 ; (Index < 2) && (Success == TRUE) ; Index++)
+  {
+    Stream = &PS_CaptureStreams[Index];
+    SecureZeroMemory(Stream, sizeof(*Stream));
+
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)GetCurrentProcessId(),
+      (DWORD_PTR)PS_CaptureRunCount,
+      (DWORD_PTR)Index
+    };
+
+    FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                  | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                  _T("\\\\.\\pipe\\plainstarter-capture-%1!u!-%2!u!-%3!u!"),
+                  0,
+                  0,
+                  PipeName,
+                  PS_ARRAY_SIZE(PipeName),
+                  (char **)Args);
+
+    Stream->Console    = GetStdHandle((Index == 0) ? STD_OUTPUT_HANDLE : STD_ERROR_HANDLE);
+    Stream->Buffers[0] = HeapAlloc(GetProcessHeap(), 0, 2 * PS_CAPTURE_BUFFER_SIZE);
+    Stream->Buffers[1] = Stream->Buffers[0] + PS_CAPTURE_BUFFER_SIZE;
+    Stream->Overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    Stream->Pipe = CreateNamedPipe(PipeName,
+                                   PIPE_ACCESS_INBOUND
+                                   | FILE_FLAG_OVERLAPPED
+                                   | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                   PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                   1,
+                                   0,
+                                   PS_CAPTURE_BUFFER_SIZE,
+                                   0,
+                                   NULL);
+
+    if (Stream->Console == INVALID_HANDLE_VALUE)
+    {
+      Stream->Console = NULL;
+    }
+
+    Success = (Stream->Buffers[0] != NULL)
+      && (Stream->Overlapped.hEvent != NULL)
+      && (Stream->Pipe != INVALID_HANDLE_VALUE);
+
+    if (Success == TRUE)
+    {
+      Stream->Writer = CreateFile(PipeName,
+                                  GENERIC_WRITE,
+                                  0,
+                                  &Inheritable,
+                                  OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  NULL);
+      Success = (Stream->Writer != INVALID_HANDLE_VALUE);
+    }
+  }
+
+  if (Success == TRUE)
+  {
+    PS_CaptureThread = CreateThread(NULL, 0, PS_CaptureDrain, NULL, 0, NULL);
+    Success = (PS_CaptureThread != NULL);
+  }
+
+  if (Success == FALSE)
+  {
+    PS_MessageAndExit(22, _T("The output of the process could not be captured."), EXIT_FAILURE);
+  }
+}
+
+/* Once the monitored processes have exited: close the write ends and let the
+ * thread read the remaining output. The processes started by the children
+ * can keep the pipes open: after PS_CAPTURE_FLUSH_TIMEOUT_MS, the reads are
+ * cancelled. */
+static void PS_CaptureFinish (void)
+{
+  PS_CAPTURE_STREAM *Stream;
+  DWORD              Index;
+
+  if (PS_CaptureThread == NULL)
+  {
+    return;
+  }
+
+  for (Index = 0 ; Index < 2 ; Index++)
+  {
+    CloseHandle(PS_CaptureStreams[Index].Writer);
+  }
+
+  if (WaitForSingleObject(PS_CaptureThread, PS_CAPTURE_FLUSH_TIMEOUT_MS) == WAIT_TIMEOUT)
+  {
+    /* A read can be started by the thread just after the cancellation */
+    PS_CaptureStopping = TRUE;
+    do
+    {
+      for (Index = 0 ; Index < 2 ; Index++)
+      {
+        CancelIoEx(PS_CaptureStreams[Index].Pipe, NULL);
+      }
+    } while (WaitForSingleObject(PS_CaptureThread, 100) == WAIT_TIMEOUT);
+  }
+
+  for (Index = 0 ; Index < 2 ; Index++)
+  {
+    Stream = &PS_CaptureStreams[Index];
+    CloseHandle(Stream->Pipe);
+    CloseHandle(Stream->Overlapped.hEvent);
+    HeapFree(GetProcessHeap(), 0, Stream->Buffers[0]);
+  }
+
+  CloseHandle(PS_CaptureThread);
+  PS_CaptureThread = NULL;
+}
+
+/*------------*/
+/* PATH CACHE */
+/*------------*/
+
+/* With a command line such as "python.exe script.py", CreateProcess searches
+ * the program in the directory of Plainstarter, the current directory, the
+ * system directories and every entry of PATH at each launch. With the option
+ * path-cache, the result of this search is kept in a small file of the
+ * temporary directory and given to CreateProcess as the application name.
+ *
+ * An entry is identified by the program name and a hash of PATH and of the
+ * current directory. It is checked with a single attribute query: a program
+ * which was removed is searched again. The program names containing a
+ * directory, and the programs which are not .exe files (ie batch files), are
+ * left to CreateProcess.
+ */
+typedef struct {
+  DWORD Key;
+  TCHAR Program[MAX_PATH];
+  TCHAR Path[MAX_PATH];
+} PS_PATH_ENTRY;
+
+typedef struct {
+  DWORD         Magic;
+  DWORD         Next;
+  PS_PATH_ENTRY Entries[PS_PATH_CACHE_SIZE];
+} PS_PATH_CACHE;
+
+static PS_PATH_CACHE PS_PathCache;
+static BOOL          PS_PathCacheLoaded = FALSE;
+static TCHAR         PS_PathCacheFilename[MAX_PATH];
+
+static void PS_PathCacheLoad (void)
+{
+  TCHAR  Directory[MAX_PATH];
+  HANDLE Infile;
+  DWORD  BytesRead = 0;
+  DWORD  Length;
+
+  PS_PathCacheLoaded = TRUE;
+  SecureZeroMemory(&PS_PathCache, sizeof(PS_PathCache));
+  PS_PathCache.Magic = PS_PATH_CACHE_MAGIC;
+
+  Length = GetTempPath(PS_ARRAY_SIZE(Directory), Directory);
+  if ((Length == 0) || (Length >= PS_ARRAY_SIZE(Directory)))
+  {
+    return;
+  }
+
+  DWORD_PTR Args[] = {
+    (DWORD_PTR)Directory,
+    (DWORD_PTR)PS_HashString(PS_FNV_OFFSET_BASIS, PS_ConfigFilename)
+  };
+
+  if (FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                    | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                    _T("%1!s!plainstarter-%2!08x!.pathc"),
+                    0,
+                    0,
+                    PS_PathCacheFilename,
+                    PS_ARRAY_SIZE(PS_PathCacheFilename),
+                    (char **)Args) == 0)
+  {
+    PS_PathCacheFilename[0] = _T('\0');
+    return;
+  }
+
+  Infile = CreateFile(PS_PathCacheFilename,
+                      GENERIC_READ,
+                      FILE_SHARE_READ | FILE_SHARE_DELETE,
+                      NULL,
+                      OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL,
+                      NULL);
+
+  if (Infile != INVALID_HANDLE_VALUE)
+  {
+    if ((ReadFile(Infile, &PS_PathCache, sizeof(PS_PathCache), &BytesRead, NULL) == 0)
+        || (BytesRead != sizeof(PS_PathCache))
+        || (PS_PathCache.Magic != PS_PATH_CACHE_MAGIC)
+        || (PS_PathCache.Next >= PS_PATH_CACHE_SIZE))
+    {
+      SecureZeroMemory(&PS_PathCache, sizeof(PS_PathCache));
+      PS_PathCache.Magic = PS_PATH_CACHE_MAGIC;
+    }
+    CloseHandle(Infile);
+  }
+}
+
+/* Written and renamed like the configuration cache, failures are silent */
+static void PS_PathCacheWrite (void)
+{
+  TCHAR  TemporaryFilename[MAX_PATH + 4];
+  HANDLE Outfile;
+  DWORD  BytesWritten;
+  BOOL   Success;
+
+  if (PS_PathCacheFilename[0] == _T('\0'))
+  {
+    return;
+  }
+
+  lstrcpy(TemporaryFilename, PS_PathCacheFilename);
+  lstrcat(TemporaryFilename, _T(".tmp"));
+
+  Outfile = CreateFile(TemporaryFilename,
+                       GENERIC_WRITE,
+                       0,
+                       NULL,
+                       CREATE_ALWAYS,
+                       FILE_ATTRIBUTE_NORMAL,
+                       NULL);
+
+  if (Outfile != INVALID_HANDLE_VALUE)
+  {
+    Success = WriteFile(Outfile, &PS_PathCache, sizeof(PS_PathCache), &BytesWritten, NULL);
+
+    CloseHandle(Outfile);
+
+    if ((Success == FALSE)
+        || (MoveFileEx(TemporaryFilename, PS_PathCacheFilename, MOVEFILE_REPLACE_EXISTING) == 0))
+    {
+      DeleteFile(TemporaryFilename);
+    }
+  }
+}
+
+/* Search Program in the same directories as CreateProcess, in the same order.
+ * Return FALSE if it is not found or if it is not a .exe file. */
+static BOOL PS_PathSearch (const TCHAR *Program, TCHAR *Found)
+{
+  PS_STRING    List = { NULL, 0, 0 };
+  TCHAR        Directory[MAX_PATH];
+  const TCHAR *Path;
+  DWORD        Length;
+  BOOL         Success = FALSE;
+
+  /* Directory of Plainstarter */
+  Length = GetModuleFileName(NULL, Directory, PS_ARRAY_SIZE(Directory));
+  while ((Length > 0) && (Directory[Length - 1] != _T('\\')))
+  {
+    Length--;
+  }
+  PS_StringAppendN(&List, Directory, Length);
+  PS_StringAppendN(&List, _T(";.;"), 3);
+
+  Length = GetSystemDirectory(Directory, PS_ARRAY_SIZE(Directory));
+  if (Length < PS_ARRAY_SIZE(Directory))
+  {
+    PS_StringAppendN(&List, Directory, Length);
+    PS_StringAppendN(&List, _T(";"), 1);
+  }
+
+  Length = GetWindowsDirectory(Directory, PS_ARRAY_SIZE(Directory));
+  if (Length < PS_ARRAY_SIZE(Directory))
+  {
+    PS_StringAppendN(&List, Directory, Length);
+    PS_StringAppendN(&List, _T(";"), 1);
+  }
+
+  Path = PS_EnvGet(&PS_Environment, _T("PATH"), 4);
+  if (Path != NULL)
+  {
+    PS_StringAppendN(&List, Path, (size_t)lstrlen(Path));
+  }
+
+  if (List.Data != NULL)
+  {
+    Length = SearchPath(List.Data, Program, _T(".exe"), MAX_PATH, Found, NULL);
+    Success = (Length > 4)
+      && (Length < MAX_PATH)
+      && (lstrcmpi((Found + Length - 4), _T(".exe")) == 0);
+  }
+
+  PS_StringFree(&List);
+
+  return Success;
+}
+
+/* Return the absolute path of the program of CommandLine, or NULL to let
+ * CreateProcess search it */
+static const TCHAR *PS_PathResolve (const TCHAR *CommandLine)
+{
+  TCHAR          Program[MAX_PATH];
+  TCHAR          Directory[MAX_PATH];
+  const TCHAR   *p = CommandLine;
+  const TCHAR   *Path;
+  PS_PATH_ENTRY *Entry = NULL;
+  DWORD          Attributes;
+  DWORD          Key;
+  DWORD          Index;
+  int            Length = 0;
+
+  if (PS_OPTION_PATH_CACHE == FALSE)
+  {
+    return NULL;
+  }
+
+  /* Program name, delimited like in PS_SplitCommandLine */
+  if (*p == _T('\"'))
+  {
+    p++;
+    while ((*p) && (*p != _T('\"')) && (Length < (MAX_PATH - 1)))
+    {
+      Program[Length++] = *p++;
+    }
+  }
+  else
+  {
+    while ((*p) && (*p != _T(' ')) && (*p != _T('\t')) && (Length < (MAX_PATH - 1)))
+    {
+      Program[Length++] = *p++;
+    }
+  }
+  Program[Length] = _T('\0');
+
+  if ((Length == 0)
+      || (Length >= (MAX_PATH - 1))
+      || (PS_StrStr(Program, _T("\\")) != NULL)
+      || (PS_StrStr(Program, _T("/")) != NULL)
+      || (PS_StrStr(Program, _T(":")) != NULL))
+  {
+    return NULL;
+  }
+
+  if (PS_PathCacheLoaded == FALSE)
+  {
+    PS_PathCacheLoad();
+  }
+
+  Path = PS_EnvGet(&PS_Environment, _T("PATH"), 4);
+  Key  = PS_HashString(PS_FNV_OFFSET_BASIS, ((Path != NULL) ? Path : _T("")));
+  if (GetCurrentDirectory(PS_ARRAY_SIZE(Directory), Directory) > 0)
+  {
+    Key = PS_HashString(Key, Directory);
+  }
+
+  for (Index = 0 ; Index < PS_PATH_CACHE_SIZE ; Index++)
+  {
+    if ((PS_PathCache.Entries[Index].Key == Key)
+        && (lstrcmpi(PS_PathCache.Entries[Index].Program, Program) == 0))
+    {
+      Entry      = &PS_PathCache.Entries[Index];
+      Attributes = GetFileAttributes(Entry->Path);
+      if ((Attributes != INVALID_FILE_ATTRIBUTES)
+          && ((Attributes & FILE_ATTRIBUTE_DIRECTORY) == 0))
+      {
+        PS_TRACE(_T("path-cache-hit"), Program);
+        return Entry->Path;
+      }
+      break;
+    }
+  }
+
+  /* Missing or stale entry */
+  if (Entry == NULL)
+  {
+    Entry = &PS_PathCache.Entries[PS_PathCache.Next];
+    PS_PathCache.Next = (PS_PathCache.Next + 1) % PS_PATH_CACHE_SIZE;
+  }
+
+  if (PS_PathSearch(Program, Entry->Path) == FALSE)
+  {
+    Entry->Key = 0;
+    Entry->Program[0] = _T('\0');
+    Entry->Path[0]    = _T('\0');
+    PS_TRACE(_T("path-search"), Program);
+    return NULL;
+  }
+
+  Entry->Key = Key;
+  lstrcpy(Entry->Program, Program);
+  PS_PathCacheWrite();
+  PS_TRACE(_T("path-search"), Program);
+
+  return Entry->Path;
+}
+
+/*---------------*/
+/* CPU PLACEMENT */
+/*---------------*/
+
+/* The options priority, processor-group and numa-node are given to
+ * CreateProcess. The options affinity, cpu-sets and efficiency-mode are
+ * applied to the suspended process, before its main thread runs.
+ *
+ * SetProcessDefaultCpuSets (Windows 10) and SetProcessInformation (Windows 8)
+ * are loaded dynamically: on older versions, cpu-sets and efficiency-mode are
+ * ignored.
+ */
+typedef BOOL (WINAPI *PS_SET_PROCESS_DEFAULT_CPU_SETS) (HANDLE, const ULONG *, ULONG);
+typedef BOOL (WINAPI *PS_SET_PROCESS_INFORMATION) (HANDLE, int, LPVOID, DWORD);
+
+/* Values of winnt.h and processthreadsapi.h, missing from older SDKs */
+#define PS_PROCESS_POWER_THROTTLING           4
+#define PS_POWER_THROTTLING_CURRENT_VERSION   1
+#define PS_POWER_THROTTLING_EXECUTION_SPEED   0x1
+
+typedef struct {
+  ULONG Version;
+  ULONG ControlMask;
+  ULONG StateMask;
+} PS_POWER_THROTTLING_STATE;
+
+/* Settings applied to the suspended process */
+static BOOL PS_PlacementIsDeferred (void)
+{
+  return ((PS_OPTION_AFFINITY != 0)
+          && (PS_OPTION_PROCESSOR_GROUP < 0)
+          && (PS_OPTION_NUMA_NODE < 0))
+    || (PS_OPTION_CPU_SET_COUNT > 0)
+    || (PS_OPTION_EFFICIENCY_MODE >= 0);
+}
+
+/* Return the attribute list with the processor group of the process, NULL
+ * without the options processor-group and numa-node. Affinity is referenced
+ * by the list and must remain valid until the process is created. */
+static LPPROC_THREAD_ATTRIBUTE_LIST PS_PlacementCreateAttributes (GROUP_AFFINITY *Affinity)
+{
+  LPPROC_THREAD_ATTRIBUTE_LIST Attributes = NULL;
+  SIZE_T                       Size       = 0;
+  DWORD                        Count;
+  BOOL                         Success;
+
+  if ((PS_OPTION_PROCESSOR_GROUP < 0) && (PS_OPTION_NUMA_NODE < 0))
+  {
+    return NULL;
+  }
+
+  SecureZeroMemory(Affinity, sizeof(*Affinity));
+
+  if (PS_OPTION_NUMA_NODE >= 0)
+  {
+    Success = GetNumaNodeProcessorMaskEx((USHORT)PS_OPTION_NUMA_NODE, Affinity);
+  }
+  else
+  {
+    Count              = GetActiveProcessorCount((WORD)PS_OPTION_PROCESSOR_GROUP);
+    Affinity->Group    = (WORD)PS_OPTION_PROCESSOR_GROUP;
+    Affinity->Mask     = (Count >= (8 * sizeof(KAFFINITY))) ? ~(KAFFINITY)0 : (((KAFFINITY)1 << Count) - 1);
+    Success            = (Count > 0);
+  }
+
+  if (PS_OPTION_AFFINITY != 0)
+  {
+    Affinity->Mask &= (KAFFINITY)PS_OPTION_AFFINITY;
+  }
+
+  Success = Success && (Affinity->Mask != 0);
+
+  if (Success == TRUE)
+  {
+    InitializeProcThreadAttributeList(NULL, 1, 0, &Size);
+    Attributes = HeapAlloc(GetProcessHeap(), 0, Size);
+    Success    = (Attributes != NULL)
+      && InitializeProcThreadAttributeList(Attributes, 1, 0, &Size);
+  }
+
+  if (Success == TRUE)
+  {
+    Success = UpdateProcThreadAttribute(Attributes,
+                                        0,
+                                        PROC_THREAD_ATTRIBUTE_GROUP_AFFINITY,
+                                        Affinity,
+                                        sizeof(*Affinity),
+                                        NULL,
+                                        NULL);
+  }
+
+  if (Success == FALSE)
+  {
+    PS_MessageAndExit(21, _T("Invalid processor group, NUMA node or affinity."), EXIT_FAILURE);
+  }
+
+  return Attributes;
+}
+
+static void PS_PlacementFreeAttributes (LPPROC_THREAD_ATTRIBUTE_LIST Attributes)
+{
+  if (Attributes != NULL)
+  {
+    DeleteProcThreadAttributeList(Attributes);
+    HeapFree(GetProcessHeap(), 0, Attributes);
+  }
+}
+
+/* Apply the deferred settings to the suspended process */
+static void PS_PlacementApply (HANDLE Process)
+{
+  HMODULE                         Kernel32;
+  PS_SET_PROCESS_DEFAULT_CPU_SETS SetProcessDefaultCpuSets;
+  PS_SET_PROCESS_INFORMATION      SetProcessInformation;
+  PS_POWER_THROTTLING_STATE       Throttling;
+  BOOL                            Success = TRUE;
+
+  /* With a processor group, the mask is part of the group affinity */
+  if ((PS_OPTION_AFFINITY != 0)
+      && (PS_OPTION_PROCESSOR_GROUP < 0)
+      && (PS_OPTION_NUMA_NODE < 0))
+  {
+    Success = SetProcessAffinityMask(Process, (DWORD_PTR)PS_OPTION_AFFINITY);
+  }
+
+  Kernel32 = GetModuleHandle(_T("kernel32.dll"));
+
+  if ((Success == TRUE) && (PS_OPTION_CPU_SET_COUNT > 0) && (Kernel32 != NULL))
+  {
+    SetProcessDefaultCpuSets = (PS_SET_PROCESS_DEFAULT_CPU_SETS)GetProcAddress(Kernel32, "SetProcessDefaultCpuSets");
+    if (SetProcessDefaultCpuSets != NULL)
+    {
+      Success = SetProcessDefaultCpuSets(Process, PS_OPTION_CPU_SETS, PS_OPTION_CPU_SET_COUNT);
+    }
+  }
+
+  if (Success == FALSE)
+  {
+    TerminateProcess(Process, EXIT_FAILURE);
+    PS_MessageAndExit(21, _T("Invalid processor group, NUMA node or affinity."), EXIT_FAILURE);
+  }
+
+  /* EcoQoS, ignored when not supported */
+  if ((PS_OPTION_EFFICIENCY_MODE >= 0) && (Kernel32 != NULL))
+  {
+    SetProcessInformation = (PS_SET_PROCESS_INFORMATION)GetProcAddress(Kernel32, "SetProcessInformation");
+    if (SetProcessInformation != NULL)
+    {
+      Throttling.Version     = PS_POWER_THROTTLING_CURRENT_VERSION;
+      Throttling.ControlMask = PS_POWER_THROTTLING_EXECUTION_SPEED;
+      Throttling.StateMask   = (PS_OPTION_EFFICIENCY_MODE == 1) ? PS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+
+      SetProcessInformation(Process, PS_PROCESS_POWER_THROTTLING, &Throttling, sizeof(Throttling));
+    }
+  }
+}
+
+/* Show the configuration and the command line with the option debug, then
+ * create the process with the environment block and the additional
+ * CreationFlags, in the job object if any. The failure is reported to the
+ * user. Return FALSE if the process cannot be created, otherwise the handles
+ * of pi must be closed by the caller. */
+static BOOL PS_CreateProcess (TCHAR               *CommandLine,
+                              TCHAR               *Environment,
+                              DWORD                CreationFlags,
+                              PROCESS_INFORMATION *pi)
+{
+  BOOL                         CpResult;
+  STARTUPINFOEX                si;
+  SIZE_T                       Mark;
+  PS_ARENA_TEXT                Message;
+  DWORD                        BytesWritten;
+  BOOL                         InheritHandles;
+  BOOL                         Resume;
+  const TCHAR                 *Path;
+  const TCHAR                 *Application;
+  LPPROC_THREAD_ATTRIBUTE_LIST Attributes;
+  GROUP_AFFINITY               Affinity;
+
+  SecureZeroMemory(&si, sizeof(si));
+  SecureZeroMemory(pi, sizeof(*pi));
+
+  si.StartupInfo.cb = sizeof(si.StartupInfo);
+
+  InheritHandles = PS_OPTION_SHOW_CONSOLE;
+
+  if (PS_CaptureThread != NULL)
+  {
+    si.StartupInfo.dwFlags   |= STARTF_USESTDHANDLES;
+    si.StartupInfo.hStdInput  = GetStdHandle(STD_INPUT_HANDLE);
+    si.StartupInfo.hStdOutput = PS_CaptureStreams[0].Writer;
+    si.StartupInfo.hStdError  = PS_CaptureStreams[1].Writer;
+    InheritHandles            = TRUE;
+  }
+
+  Attributes = PS_PlacementCreateAttributes(&Affinity);
+  if (Attributes != NULL)
+  {
+    si.StartupInfo.cb  = sizeof(si);
+    si.lpAttributeList = Attributes;
+    CreationFlags     |= EXTENDED_STARTUPINFO_PRESENT;
+  }
+
+  /* The process is created suspended to be configured before it runs */
+  Resume = ((CreationFlags & CREATE_SUSPENDED) == 0)
+    && ((PS_Job != NULL) || (PS_PlacementIsDeferred() == TRUE));
+
+  if (PS_OPTION_DEBUG == TRUE)
+  {
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)PS_ConfigFilename,
+      (DWORD_PTR)CommandLine,
+      (DWORD_PTR)PS_ArenaAllocations,
+      (DWORD_PTR)PS_ArenaPeak
+    };
+
+    Mark         = PS_ArenaMark();
+    Message      = PS_ArenaText((DWORD)(lstrlen(PS_ConfigFilename) + lstrlen(CommandLine) + 128));
+    BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                                 | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                                 _T("Configuration: %1!s!\n")
+                                 _T("Arena: %3!u! allocations, peak %4!Iu! bytes\n\n%2!s!"),
+                                 0,
+                                 0,
+                                 Message.Data,
+                                 Message.Capacity,
+                                 (char **)Args);
+
+    PS_MessageBox(NULL, ((BytesWritten > 0) ? Message.Data : CommandLine), _T("DEBUG"), MB_ICONINFORMATION);
+    PS_ArenaRelease(Mark);
+  }
+
+  Application = PS_PathResolve(CommandLine);
+
+  PS_BENCH_BEGIN(PS_BENCH_CREATE_PROCESS);
+  PS_ReadyMarkStart();
+  CpResult = CreateProcess(Application,    /* NULL: search the program      */
+                           CommandLine,    /* Command line                  */
+                           NULL,           /* Process handle not inheritable*/
+                           NULL,           /* Thread handle not inheritable */
+                           InheritHandles, /* No handle inheritance         */
+                           CREATE_UNICODE_ENVIRONMENT
+                           | CreationFlags
+                           | PS_OPTION_PRIORITY_CLASS
+                           | ((Resume == TRUE) ? CREATE_SUSPENDED : 0),
+                                           /* Creation flags                */
+                           Environment,    /* Environment block             */
+                           NULL,           /* Use parent starting directory */
+                           &si.StartupInfo, /* STARTUPINFO structure        */
+                           pi);            /* PROCESS_INFORMATION structure */
+  PS_BENCH_END(PS_BENCH_CREATE_PROCESS);
+  PS_TRACE(_T("create-process"), NULL);
+
+  PS_PlacementFreeAttributes(Attributes);
+
+  if (CpResult == TRUE)
+  {
+    if ((PS_Job != NULL)
+        && (AssignProcessToJobObject(PS_Job, pi->hProcess) == FALSE)
+        && (PS_JobHasLimits() == TRUE))
+    {
+      TerminateProcess(pi->hProcess, EXIT_FAILURE);
+      PS_MessageAndExit(20, _T("The process could not be assigned to the job object."), EXIT_FAILURE);
+    }
+
+    PS_PlacementApply(pi->hProcess);
+
+    if (Resume == TRUE)
+    {
+      ResumeThread(pi->hThread);
+    }
+  }
+
+  if (CpResult == FALSE)
+  {
+    Path = PS_EnvGet(&PS_Environment, _T("PATH"), 4);
+    if (Path == NULL)
+    {
+      Path = _T("");
+    }
+
+    DWORD_PTR Args[] = {
+      (DWORD_PTR)CommandLine,
+      (DWORD_PTR)Path
+    };
+
+    Mark         = PS_ArenaMark();
+    Message      = PS_ArenaText((DWORD)(lstrlen(CommandLine) + lstrlen(Path) + 128));
+    BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                                 | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                                 _T("Error: the command line could not be executed\n")
+                                 _T("[%1!s!]\n\n")
+                                 _T("PATH: '%2!s!'\n"),
+                                 0,
+                                 0,
+                                 Message.Data,
+                                 Message.Capacity,
+                                 (char **)Args);
+    if (PS_HeadlessIsEnabled() == TRUE)
+    {
+      PS_HeadlessReport(_T("error"),
+                        _T("Error#08"),
+                        ((BytesWritten > 0) ? Message.Data : PS_UNEXPECTED_ERROR),
+                        8,
+                        (PS_HEADLESS_EXIT_BASE + 8));
+    }
+    else if (BytesWritten > 0)
+    {
+      PS_MessageBox(NULL, Message.Data, _T("Error#08"), MB_ICONERROR);
+    }
+    else
+    {
+      PS_MessageBox(NULL, PS_UNEXPECTED_ERROR, _T("Error#09"), MB_ICONERROR);
+    }
+    PS_ArenaRelease(Mark);
+  }
+
+  return CpResult;
+}
+
+/* Report the exit code of a monitored process: always with the option debug,
+ * only a failure for the GUI version */
+static void PS_ReportExitCode (DWORD ExitCode)
+{
+  /* Headless: the exit code of a successful child is kept, even with the
+   * option debug */
+  if ((PS_HeadlessIsEnabled() == TRUE) && (ExitCode == 0))
+  {
+    return;
+  }
+
+  if (PS_OPTION_DEBUG == TRUE)
+  {
+    PS_ReportExecutionError(ExitCode);
+  }
+#if defined(PLAINSTARTER_WINDOWS)
+  if ((PS_OPTION_MONITOR_PROCESS == TRUE) && (ExitCode != 0))
+  {
+    PS_ReportExecutionError(ExitCode);
+  }
+#endif
+}
+
+/*--------------*/
+/* LAUNCH GROUP */
+/*--------------*/
+
+/* Each line PLAINSTARTER_GROUP_CMD_LINE is expanded where it appears and
+ * added to the launch group. The group is started with the next
+ * PLAINSTARTER_CMD_LINE, or at the end of the configuration: all the
+ * processes are created before waiting for any of them, so that their
+ * startup times overlap.
+ *
+ * With the option monitor-process, Plainstarter waits for all the processes,
+ * or only the first one to exit with group-wait-any (the others keep
+ * running). The exit codes are combined by order of priority:
+ * - group-exit-first: exit code of the first process to exit
+ * - group-exit-max:   highest exit code
+ * - otherwise:        first non-zero exit code, in the order of the
+ *                     configuration file, PLAINSTARTER_CMD_LINE being last
+ */
+static PS_STRING PS_GroupCommands;
+static DWORD     PS_GroupCount = 0;
+
+static void PS_GroupAdd (const TCHAR *CommandLine)
+{
+  /* The process of PLAINSTARTER_CMD_LINE is waited with the group */
+  if (PS_GroupCount >= (MAXIMUM_WAIT_OBJECTS - 1))
+  {
+    PS_MessageAndExit(19, _T("Too many processes in the launch group."), EXIT_FAILURE);
+  }
+
+  /* The command lines are stored one after the other, null-terminated */
+  if (PS_StringAppendN(&PS_GroupCommands, CommandLine, (size_t)lstrlen(CommandLine) + 1) == 0)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  PS_GroupCount++;
+}
+
+/* Start the group and CommandLine (can be NULL), then combine the exit
+ * codes */
+static DWORD PS_GroupRun (TCHAR *CommandLine, TCHAR *Environment)
+{
+  HANDLE               Handles[MAXIMUM_WAIT_OBJECTS];
+  DWORD                Members[MAXIMUM_WAIT_OBJECTS];
+  TCHAR               *Commands[MAXIMUM_WAIT_OBJECTS];
+  DWORD                ExitCodes[MAXIMUM_WAIT_OBJECTS];
+  BOOL                 Exited[MAXIMUM_WAIT_OBJECTS];
+  DWORD                MemberCount = PS_GroupCount + ((CommandLine != NULL) ? 1 : 0);
+  DWORD                Remaining   = 0;
+  DWORD                FirstExited = MemberCount;
+  DWORD                ExitCode    = 0;
+  DWORD                Member;
+  DWORD                Index;
+  TCHAR               *Command     = PS_GroupCommands.Data;
+  PROCESS_INFORMATION  pi;
+
+  /* Create all the processes before waiting */
+  for (Member = 0 ; Member < MemberCount ; Member++)
+  {
+    Exited[Member] = FALSE;
+
+    if (Member == PS_GroupCount)
+    {
+      Command = CommandLine;
+    }
+    Commands[Member] = Command;
+
+    if (PS_CreateProcess(Command, Environment, 0, &pi) == TRUE)
+    {
+      CloseHandle(pi.hThread);
+      Handles[Remaining] = pi.hProcess;
+      Members[Remaining] = Member;
+      Remaining++;
+    }
+    else
+    {
+      ExitCodes[Member] = (DWORD)-1;
+      Exited[Member]    = TRUE;
+      if (FirstExited == MemberCount)
+      {
+        FirstExited = Member;
+      }
+    }
+
+    if (Member < PS_GroupCount)
+    {
+      Command += lstrlen(Command) + 1;
+    }
+  }
+
+  if ((PS_OPTION_MONITOR_PROCESS == TRUE) || (PS_OPTION_DEBUG == TRUE))
+  {
+    while (Remaining > 0)
+    {
+      Index = WaitForMultipleObjects(Remaining, Handles, FALSE, INFINITE) - WAIT_OBJECT_0;
+      if (Index >= Remaining)
+      {
+        /* WAIT_FAILED, nothing more can be monitored */
+        ExitCode = 99999;
+        break;
+      }
+
+      PS_TRACE(_T("child-exit"), NULL);
+
+      Member = Members[Index];
+      if (GetExitCodeProcess(Handles[Index], &ExitCodes[Member]) == FALSE)
+      {
+        ExitCodes[Member] = 99999;
+      }
+      PS_StatsCollect(Handles[Index], Commands[Member], ExitCodes[Member]);
+      Exited[Member] = TRUE;
+      if (FirstExited == MemberCount)
+      {
+        FirstExited = Member;
+      }
+
+      /* Remove the handle from the list of waited handles */
+      CloseHandle(Handles[Index]);
+      Remaining--;
+      Handles[Index] = Handles[Remaining];
+      Members[Index] = Members[Remaining];
+
+      if (PS_OPTION_GROUP_WAIT_ANY == TRUE)
+      {
+        break;
+      }
+    }
+
+    PS_CaptureFinish();
+
+    /* Combine the exit codes */
+    if (ExitCode == 0)
+    {
+      if (PS_OPTION_GROUP_EXIT_FIRST == TRUE)
+      {
+        ExitCode = (FirstExited < MemberCount) ? ExitCodes[FirstExited] : 0;
+      }
+      else
+      {
+        for (Member = 0 ; Member < MemberCount ; Member++)
+        {
+          if (Exited[Member] == FALSE)
+          {
+            continue;
+          }
+
+          if (PS_OPTION_GROUP_EXIT_MAX == TRUE)
+          {
+            if (ExitCodes[Member] > ExitCode)
+            {
+              ExitCode = ExitCodes[Member];
+            }
+          }
+          else if (ExitCodes[Member] != 0)
+          {
+            ExitCode = ExitCodes[Member];
+            break;
+          }
+        }
+      }
+    }
+
+    PS_StatsWrite(ExitCode);
+    PS_ReportExitCode(ExitCode);
+  }
+  else if (FirstExited < MemberCount)
+  {
+    /* A process could not be created */
+    ExitCode = (DWORD)-1;
+  }
+
+  /* The processes still running are not monitored anymore */
+  for (Index = 0 ; Index < Remaining ; Index++)
+  {
+    CloseHandle(Handles[Index]);
+  }
+
+  /* The group is started, the following lines start a new one */
+  PS_GroupCommands.Length = 0;
+  PS_GroupCount           = 0;
+
+  return ExitCode;
+}
+
+/*--------------*/
+/* PROCESS POOL */
+/*--------------*/
+
+/* With the option process-pool, the first launch starts a broker: a copy of
+ * Plainstarter running the same configuration in the background, with the
+ * marker PLAINSTARTER_BROKER in its environment. Instead of running the
+ * command line, the broker keeps PS_OPTION_POOL_SIZE processes created with
+ * CREATE_SUSPENDED and the environment applied, and listens on a named pipe
+ * specific to the session and to the configuration file.
+ *
+ * The next launches send the hash of their command line and of their
+ * environment (current directory included) to the broker. When they match,
+ * the broker duplicates the handle of a pooled process into the launcher,
+ * resumes it and refills the pool once the launcher is served. The startup
+ * of the interpreter is then done ahead of time.
+ *
+ * A suspended process already has its command line: the launches with
+ * parameters, or with a different environment, do not match and create
+ * their process as usual. A mismatch means the pool is outdated, the broker
+ * exits and the next launch starts a new one. The broker also exits after
+ * PS_POOL_IDLE_TIMEOUT_MS without any request. The pooled processes have no
+ * console, the option is meant for GUI programs and is ignored with
+ * show-console, launch groups and the options of the job object.
+ */
+typedef struct {
+  DWORD Magic;
+  DWORD CommandHash;
+  DWORD EnvironmentHash;
+} PS_POOL_REQUEST;
+
+/* Process is a handle valid in the launcher process, 0 if the pool cannot
+ * serve the request */
+typedef struct {
+  DWORD     Magic;
+  DWORD     ProcessId;
+  ULONGLONG Process;
+} PS_POOL_REPLY;
+
+static BOOL  PS_PoolIsBroker    = FALSE;
+static BOOL  PS_PoolStartBroker = FALSE;
+static TCHAR PS_PoolPipeName[64];
+
+static BOOL PS_PoolIsEnabled (const TCHAR *CommandLine)
+{
+  return (PS_OPTION_PROCESS_POOL == TRUE)
+    && (PS_OPTION_SHOW_CONSOLE == FALSE)
+    && (PS_OPTION_CAPTURE_OUTPUT == FALSE)
+    && (PS_JobIsEnabled() == FALSE)
+    && (CommandLine != NULL)
+    && (PS_GroupCount == 0);
+}
+
+/* \\.\pipe\plainstarter-pool-<session>-<hash of the configuration file> */
+static void PS_PoolGetPipeName (void)
+{
+  DWORD SessionId = 0;
+
+  ProcessIdToSessionId(GetCurrentProcessId(), &SessionId);
+
+  DWORD_PTR Args[] = {
+    (DWORD_PTR)SessionId,
+    (DWORD_PTR)PS_HashString(PS_FNV_OFFSET_BASIS, PS_ConfigFilename)
+  };
+
+  FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                _T("\\\\.\\pipe\\plainstarter-pool-%1!u!-%2!08x!"),
+                0,
+                0,
+                PS_PoolPipeName,
+                PS_ARRAY_SIZE(PS_PoolPipeName),
+                (char **)Args);
+}
+
+static void PS_PoolGetKey (const TCHAR     *CommandLine,
+                           const TCHAR     *Environment,
+                           PS_POOL_REQUEST *Key)
+{
+  SIZE_T        Mark = PS_ArenaMark();
+  PS_ARENA_TEXT Directory;
+  const TCHAR  *p;
+  DWORD         Hash = PS_FNV_OFFSET_BASIS;
+
+  Directory = PS_ArenaText(GetCurrentDirectory(0, NULL) + 1);
+  if (GetCurrentDirectory(Directory.Capacity, Directory.Data) > 0)
+  {
+    Hash = PS_HashString(Hash, Directory.Data);
+  }
+  PS_ArenaRelease(Mark);
+
+  for (p = Environment ; *p ; p += (lstrlen(p) + 1))
+  {
+    Hash = PS_HashString(Hash, p);
+  }
+
+  Key->Magic           = PS_POOL_MAGIC;
+  Key->CommandHash     = PS_HashString(PS_FNV_OFFSET_BASIS, CommandLine);
+  Key->EnvironmentHash = Hash;
+}
+
+/* Wait for the completion of an overlapped operation on the pipe */
+static BOOL PS_PoolComplete (HANDLE      Pipe,
+                             OVERLAPPED *Overlapped,
+                             BOOL        Result,
+                             DWORD      *Bytes)
+{
+  if ((Result == FALSE) && (GetLastError() == ERROR_IO_PENDING))
+  {
+    Result = GetOverlappedResult(Pipe, Overlapped, Bytes, TRUE);
+  }
+
+  return Result;
+}
+
+/* Ask the broker for a process of the pool. Return TRUE with the handle of
+ * the resumed process in pi->hProcess, pi->hThread is NULL. */
+static BOOL PS_PoolAcquire (TCHAR               *CommandLine,
+                            TCHAR               *Environment,
+                            PROCESS_INFORMATION *pi)
+{
+  PS_POOL_REQUEST Request;
+  PS_POOL_REPLY   Reply;
+  DWORD           BytesRead;
+  BOOL            Acquired = FALSE;
+
+  SecureZeroMemory(pi, sizeof(*pi));
+
+  PS_BENCH_BEGIN(PS_BENCH_POOL);
+  PS_ReadyMarkStart();
+  PS_PoolGetPipeName();
+  PS_PoolGetKey(CommandLine, Environment, &Request);
+
+  if (CallNamedPipe(PS_PoolPipeName,
+                    &Request,
+                    sizeof(Request),
+                    &Reply,
+                    sizeof(Reply),
+                    &BytesRead,
+                    PS_POOL_CONNECT_TIMEOUT_MS) == TRUE)
+  {
+    if ((BytesRead == sizeof(Reply))
+        && (Reply.Magic == PS_POOL_MAGIC)
+        && (Reply.Process != 0))
+    {
+      pi->hProcess    = (HANDLE)(ULONG_PTR)Reply.Process;
+      pi->dwProcessId = Reply.ProcessId;
+      Acquired        = TRUE;
+
+      PS_TRACE(_T("pool-acquire"), NULL);
+    }
+  }
+  else if (GetLastError() == ERROR_FILE_NOT_FOUND)
+  {
+    /* Started once the process of this launch is created */
+    PS_PoolStartBroker = TRUE;
+  }
+  PS_BENCH_END(PS_BENCH_POOL);
+
+  return Acquired;
+}
+
+/* Start a copy of Plainstarter in the background with the environment of
+ * the parent process and the marker PLAINSTARTER_BROKER. The block is built
+ * again from a table: CreateProcess requires the variables sorted by name. */
+static void PS_PoolStart (void)
+{
+  SIZE_T              Mark        = PS_ArenaMark();
+  TCHAR              *Environment = NULL;
+  PS_ENV              Broker;
+  PS_ARENA_TEXT       CommandLine;
+  TCHAR              *Module;
+  STARTUPINFO         si;
+  PROCESS_INFORMATION ProcessInfo;
+
+  /* Quoted filename of the executable */
+  Module = PS_ArenaModuleFilename();
+  if (Module == NULL)
+  {
+    return;
+  }
+  CommandLine = PS_ArenaText((DWORD)lstrlen(Module) + 3);
+  lstrcpy(CommandLine.Data, _T("\""));
+  lstrcat(CommandLine.Data, Module);
+  lstrcat(CommandLine.Data, _T("\""));
+
+  /* The block copies the strings, the table is released right away */
+  if (PS_EnvInitialize(&Broker) == 1)
+  {
+    if ((PS_EnvImportBlock(&Broker, PS_ParentEnvironment) == 1)
+        && (PS_EnvSet(&Broker, _T("PLAINSTARTER_BROKER"), _T("1")) == 1))
+    {
+      Environment = PS_EnvBuildBlock(&Broker);
+    }
+    PS_EnvFree(&Broker);
+  }
+
+  if (Environment != NULL)
+  {
+    SecureZeroMemory(&si, sizeof(si));
+    si.cb = sizeof(si);
+
+    if (CreateProcess(NULL,
+                      CommandLine.Data,
+                      NULL,
+                      NULL,
+                      FALSE,
+                      DETACHED_PROCESS
+                      | CREATE_NEW_PROCESS_GROUP
+                      | CREATE_UNICODE_ENVIRONMENT,
+                      Environment,
+                      NULL,
+                      &si,
+                      &ProcessInfo) == TRUE)
+    {
+      CloseHandle(ProcessInfo.hProcess);
+      CloseHandle(ProcessInfo.hThread);
+    }
+
+    PS_EnvFreeBlock(Environment);
+  }
+
+  PS_ArenaRelease(Mark);
+}
+
+/* Serve the launchers until the pool is outdated or idle */
+static void PS_PoolServe (TCHAR *CommandLine, TCHAR *Environment)
+{
+  PROCESS_INFORMATION Pool[PS_POOL_MAX_SIZE];
+  PS_POOL_REQUEST     Key;
+  PS_POOL_REQUEST     Request;
+  PS_POOL_REPLY       Reply;
+  OVERLAPPED          Overlapped;
+  HANDLE              Pipe;
+  HANDLE              Client;
+  HANDLE              Target;
+  DWORD               ClientId;
+  DWORD               Bytes;
+  DWORD               Count   = 0;
+  DWORD               Index;
+  BOOL                Running = TRUE;
+  BOOL                Success;
+
+  /* Nobody can see the messages of the broker */
+  PS_OPTION_DEBUG = FALSE;
+
+  PS_PoolGetPipeName();
+  PS_PoolGetKey(CommandLine, Environment, &Key);
+
+  /* Fails if another broker serves this configuration */
+  Pipe = CreateNamedPipe(PS_PoolPipeName,
+                         PIPE_ACCESS_DUPLEX
+                         | FILE_FLAG_FIRST_PIPE_INSTANCE
+                         | FILE_FLAG_OVERLAPPED,
+                         PIPE_TYPE_MESSAGE
+                         | PIPE_READMODE_MESSAGE
+                         | PIPE_WAIT
+                         | PIPE_REJECT_REMOTE_CLIENTS,
+                         1,
+                         sizeof(Reply),
+                         sizeof(Request),
+                         0,
+                         NULL);
+  if (Pipe == INVALID_HANDLE_VALUE)
+  {
+    return;
+  }
+
+  SecureZeroMemory(&Overlapped, sizeof(Overlapped));
+  Overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (Overlapped.hEvent == NULL)
+  {
+    Running = FALSE;
+  }
+
+  while (Running == TRUE)
+  {
+    /* Refill the pool while no launcher is waiting */
+    while (Count < PS_OPTION_POOL_SIZE)
+    {
+      if (PS_CreateProcess(CommandLine, Environment, (CREATE_SUSPENDED | CREATE_NO_WINDOW), &Pool[Count]) == FALSE)
+      {
+        break;
+      }
+      Count++;
+    }
+
+    if (Count == 0)
+    {
+      break;
+    }
+
+    /* Wait for the next launcher */
+    Success = ConnectNamedPipe(Pipe, &Overlapped);
+    if ((Success == FALSE) && (GetLastError() == ERROR_IO_PENDING))
+    {
+      if (WaitForSingleObject(Overlapped.hEvent, PS_POOL_IDLE_TIMEOUT_MS) == WAIT_OBJECT_0)
+      {
+        Success = GetOverlappedResult(Pipe, &Overlapped, &Bytes, FALSE);
+      }
+      else
+      {
+        CancelIo(Pipe);
+        break;
+      }
+    }
+    else if ((Success == FALSE) && (GetLastError() == ERROR_PIPE_CONNECTED))
+    {
+      Success = TRUE;
+    }
+
+    if (Success == FALSE)
+    {
+      break;
+    }
+
+    Reply.Magic     = PS_POOL_MAGIC;
+    Reply.ProcessId = 0;
+    Reply.Process   = 0;
+
+    Success = PS_PoolComplete(Pipe, &Overlapped, ReadFile(Pipe, &Request, sizeof(Request), &Bytes, &Overlapped), &Bytes);
+    if ((Success == TRUE) && (Bytes == sizeof(Request)) && (Request.Magic == PS_POOL_MAGIC))
+    {
+      if ((Request.CommandHash != Key.CommandHash)
+          || (Request.EnvironmentHash != Key.EnvironmentHash))
+      {
+        /* The configuration or the environment changed */
+        Running = FALSE;
+      }
+      else if (GetNamedPipeClientProcessId(Pipe, &ClientId) == TRUE)
+      {
+        Client = OpenProcess(PROCESS_DUP_HANDLE, FALSE, ClientId);
+        if (Client != NULL)
+        {
+          Count--;
+          if (DuplicateHandle(GetCurrentProcess(),
+                              Pool[Count].hProcess,
+                              Client,
+                              &Target,
+                              0,
+                              FALSE,
+                              DUPLICATE_SAME_ACCESS) == TRUE)
+          {
+            ResumeThread(Pool[Count].hThread);
+            Reply.ProcessId = Pool[Count].dwProcessId;
+            Reply.Process   = (ULONGLONG)(ULONG_PTR)Target;
+          }
+          else
+          {
+            TerminateProcess(Pool[Count].hProcess, 0);
+          }
+
+          CloseHandle(Pool[Count].hProcess);
+          CloseHandle(Pool[Count].hThread);
+          CloseHandle(Client);
+        }
+      }
+    }
+
+    PS_PoolComplete(Pipe, &Overlapped, WriteFile(Pipe, &Reply, sizeof(Reply), &Bytes, &Overlapped), &Bytes);
+    FlushFileBuffers(Pipe);
+    DisconnectNamedPipe(Pipe);
+  }
+
+  /* The processes which were never resumed are not needed anymore */
+  for (Index = 0 ; Index < Count ; Index++)
+  {
+    TerminateProcess(Pool[Index].hProcess, 0);
+    CloseHandle(Pool[Index].hProcess);
+    CloseHandle(Pool[Index].hThread);
+  }
+
+  if (Overlapped.hEvent != NULL)
+  {
+    CloseHandle(Overlapped.hEvent);
+  }
+  CloseHandle(Pipe);
+}
+
+/*--------------*/
+/* COMMAND LINE */
+/*--------------*/
+
+/* PLAINSTARTER_CMD_LINE followed by the parameters given to Plainstarter is
+ * built in PS_CommandLine. Each parameter is quoted so that the child process
+ * gets it back unchanged with CommandLineToArgvW (see PS_SplitCommandLine):
+ * the backslashes preceding a quote or the closing quote are doubled and the
+ * quotes are escaped. With the option raw-arguments, the command line of
+ * Plainstarter following the program name is appended as-is instead.
+ *
+ * CreateProcess accepts at most 32767 characters. Beyond this limit, the
+ * parameters are written in UTF-8 to a temporary response file and replaced
+ * by "@<file>", which is understood by most compilers and linters. The
+ * response file is deleted when the process exits, so Plainstarter monitors
+ * the process in this case.
+ */
+static PS_STRING PS_CommandLine;
+static PS_STRING PS_CommandArguments;
+static TCHAR     PS_ResponseFilename[MAX_PATH];
+
+static void PS_CommandAppend (PS_STRING *Out, const TCHAR *Data, size_t Length)
+{
+  if (PS_StringAppendN(Out, Data, Length) == 0)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+}
+
+/* Append a blank and Argument quoted */
+static void PS_CommandAppendArgument (PS_STRING *Out, const TCHAR *Argument)
+{
+  const TCHAR *p              = Argument;
+  size_t       BackslashCount = 0;
+  size_t       Index;
+
+  PS_CommandAppend(Out, _T(" \""), 2);
+
+  for (;;)
+  {
+    if (*p == _T('\\'))
+    {
+      BackslashCount++;
+    }
+    else
+    {
+      /* The backslashes are doubled before a quote or the closing quote */
+      if ((*p == _T('\"')) || (*p == _T('\0')))
+      {
+        BackslashCount *= 2;
+      }
+      for (Index = 0 ; Index < BackslashCount ; Index++)
+      {
+        PS_CommandAppend(Out, _T("\\"), 1);
+      }
+      BackslashCount = 0;
+
+      if (*p == _T('\0'))
+      {
+        break;
+      }
+      else if (*p == _T('\"'))
+      {
+        PS_CommandAppend(Out, _T("\\\""), 2);
+      }
+      else
+      {
+        PS_CommandAppend(Out, p, 1);
+      }
+    }
+    p++;
+  }
+
+  PS_CommandAppend(Out, _T("\""), 1);
+}
+
+/* Command line of Plainstarter without the program name, delimited like in
+ * PS_SplitCommandLine */
+static const TCHAR *PS_CommandRawArguments (void)
+{
+  const TCHAR *p = GetCommandLine();
+
+  if (*p == _T('\"'))
+  {
+    p++;
+    while ((*p) && (*p != _T('\"')))
+    {
+      p++;
+    }
+    if (*p)
+    {
+      p++;
+    }
+  }
+  else
+  {
+    while ((*p) && (*p != _T(' ')) && (*p != _T('\t')))
+    {
+      p++;
+    }
+  }
+
+  while ((*p == _T(' ')) || (*p == _T('\t')))
+  {
+    p++;
+  }
+
+  return p;
+}
+
+/* Write Arguments to a new file of the temporary directory, its name is
+ * stored in PS_ResponseFilename */
+static void PS_CommandWriteResponseFile (const TCHAR *Arguments)
+{
+  TCHAR  Directory[MAX_PATH];
+  SIZE_T Mark         = PS_ArenaMark();
+  HANDLE File;
+  char  *Buffer;
+  int    Size;
+  DWORD  BytesWritten = 0;
+  BOOL   Success      = FALSE;
+
+  if ((GetTempPath(PS_ARRAY_SIZE(Directory), Directory) > 0)
+      && (GetTempFileName(Directory, _T("psa"), 0, PS_ResponseFilename) != 0))
+  {
+    Size   = WideCharToMultiByte(CP_UTF8, 0, Arguments, -1, NULL, 0, NULL, NULL);
+    Buffer = (Size > 0) ? PS_ArenaAlloc((SIZE_T)Size) : NULL;
+    if (Buffer != NULL)
+    {
+      /* Without the null character */
+      Size = WideCharToMultiByte(CP_UTF8, 0, Arguments, -1, Buffer, Size, NULL, NULL) - 1;
+
+      File = CreateFile(PS_ResponseFilename,
+                        GENERIC_WRITE,
+                        0,
+                        NULL,
+                        CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_TEMPORARY,
+                        NULL);
+      if (File != INVALID_HANDLE_VALUE)
+      {
+        Success = (Size >= 0)
+          && (WriteFile(File, Buffer, (DWORD)Size, &BytesWritten, NULL) != 0)
+          && (BytesWritten == (DWORD)Size);
+        CloseHandle(File);
+      }
+      PS_ArenaRelease(Mark);
+    }
+
+    if (Success == FALSE)
+    {
+      DeleteFile(PS_ResponseFilename);
+    }
+  }
+
+  if (Success == FALSE)
+  {
+    PS_MessageAndExit(23, _T("The response file cannot be written."), EXIT_FAILURE);
+  }
+}
+
+static void PS_CommandDeleteResponseFile (void)
+{
+  if (PS_ResponseFilename[0] != _T('\0'))
+  {
+    DeleteFile(PS_ResponseFilename);
+    PS_ResponseFilename[0] = _T('\0');
+  }
+}
+
+/* Build and expand the command line from the value of PLAINSTARTER_CMD_LINE
+ * and the parameters given to Plainstarter */
+static TCHAR *PS_CommandBuild (const TCHAR *Value, int argc, TCHAR **argv)
+{
+  const TCHAR *Expanded;
+  const TCHAR *Raw;
+  int          i;
+
+  PS_CommandLine.Length      = 0;
+  PS_CommandArguments.Length = 0;
+  PS_CommandAppend(&PS_CommandArguments, _T(""), 0);
+
+  if (PS_OPTION_RAW_ARGUMENTS == TRUE)
+  {
+    Raw = PS_CommandRawArguments();
+    if (*Raw)
+    {
+      PS_CommandAppend(&PS_CommandArguments, _T(" "), 1);
+      PS_CommandAppend(&PS_CommandArguments, Raw, (size_t)lstrlen(Raw));
+    }
+  }
+  else
+  {
+    for (i=1 ; i<argc ; i++)
+    {
+      PS_CommandAppendArgument(&PS_CommandArguments, argv[i]);
+    }
+  }
+
+  /* The parameters are expanded along with the command line */
+  PS_CommandAppend(&PS_CommandLine, Value, (size_t)lstrlen(Value));
+  PS_CommandAppend(&PS_CommandLine, PS_CommandArguments.Data, PS_CommandArguments.Length);
+
+  PS_BENCH_BEGIN(PS_BENCH_EXPAND);
+  Expanded = PS_EnvExpandVariable(PS_CommandLine.Data);
+  PS_BENCH_END(PS_BENCH_EXPAND);
+
+  if ((size_t)lstrlen(Expanded) < PS_MAX_COMMAND_LINE_CHAR)
+  {
+    return (TCHAR *)Expanded;
+  }
+  else if (PS_CommandArguments.Length == 0)
+  {
+    PS_MessageAndExit(23, _T("The command line is longer than 32767 characters."), EXIT_FAILURE);
+  }
+
+  /* Too long: the command line is followed by the response file */
+  PS_CommandLine.Length = 0;
+  Expanded = PS_EnvExpandVariable(Value);
+  PS_CommandAppend(&PS_CommandLine, Expanded, (size_t)lstrlen(Expanded));
+
+  /* Without the leading blank */
+  Expanded = PS_EnvExpandVariable(PS_CommandArguments.Data + 1);
+  PS_CommandWriteResponseFile(Expanded);
+
+  PS_CommandArguments.Length = 0;
+  PS_CommandAppend(&PS_CommandArguments, _T("@"), 1);
+  PS_CommandAppend(&PS_CommandArguments, PS_ResponseFilename, (size_t)lstrlen(PS_ResponseFilename));
+  PS_CommandAppendArgument(&PS_CommandLine, PS_CommandArguments.Data);
+
+  if (PS_CommandLine.Length >= PS_MAX_COMMAND_LINE_CHAR)
+  {
+    PS_CommandDeleteResponseFile();
+    PS_MessageAndExit(23, _T("The command line is longer than 32767 characters."), EXIT_FAILURE);
+  }
+
+  PS_OPTION_MONITOR_PROCESS = TRUE;
+
+  return PS_CommandLine.Data;
+}
+
+/*-----------------*/
+/* SINGLE INSTANCE */
+/*-----------------*/
+
+/* With the option single-instance=<key>, a single child process runs for the
+ * configuration and the key. The first launcher owns the mutex
+ * Local\plainstarter-instance-<key>-<config>, the hashes of the key and of
+ * the configuration filename (ASCII case insensitive), it monitors its child
+ * process and releases the mutex when the child exits.
+ *
+ * The child receives the name of a pipe in the variable
+ * PLAINSTARTER_INSTANCE_PIPE,
+ * \\.\pipe\plainstarter-instance-<session>-<key>-<config>.
+ * It announces that it is ready to receive arguments by creating this pipe
+ * (any number of instances, inbound). Each next launcher connects to the
+ * pipe, writes a single message and exits without starting anything:
+ *
+ *   <current directory>\0<argument 1>\0<argument 2>\0...
+ *
+ * encoded in UTF-8, the arguments being the ones given to Plainstarter. The
+ * child process is allowed to bring its window to the foreground.
+ *
+ * A launcher started while the first child is not ready yet waits for the
+ * pipe up to ready-timeout. If the first launcher exits meanwhile, it takes
+ * over the mutex and starts the child. After the timeout, the child is
+ * started as if the option was not set.
+ *
+ * A forwarding launcher still processes the rest of the configuration
+ * without starting anything, and exits like any other launch.
+ */
+static TCHAR  PS_InstancePipeName[80];
+static TCHAR  PS_InstanceMutexName[80];
+static HANDLE PS_InstanceMutex     = NULL;
+static BOOL   PS_InstanceForwarded = FALSE;
+
+typedef BOOL (WINAPI *PS_ALLOW_SET_FOREGROUND_WINDOW) (DWORD);
+
+static void PS_InstanceGetNames (void)
+{
+  SIZE_T Mark      = PS_ArenaMark();
+  DWORD  SessionId = 0;
+  TCHAR *Config;
+  TCHAR *p;
+
+  ProcessIdToSessionId(GetCurrentProcessId(), &SessionId);
+
+  /* C:\App\my-app.cfg and c:\app\my-app.cfg are the same configuration,
+   * CharLower would load user32.dll */
+  Config = PS_ArenaCopy(PS_ConfigFilename);
+  for (p = Config ; *p != _T('\0') ; p++)
+  {
+    if ((*p >= _T('A')) && (*p <= _T('Z')))
+    {
+      *p = (TCHAR)(*p - _T('A') + _T('a'));
+    }
+  }
+
+  DWORD_PTR Args[] = {
+    (DWORD_PTR)SessionId,
+    (DWORD_PTR)PS_OPTION_INSTANCE_KEY,
+    (DWORD_PTR)PS_HashString(PS_FNV_OFFSET_BASIS, Config)
+  };
+
+  FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                _T("\\\\.\\pipe\\plainstarter-instance-%1!u!-%2!08x!-%3!08x!"),
+                0,
+                0,
+                PS_InstancePipeName,
+                PS_ARRAY_SIZE(PS_InstancePipeName),
+                (char **)Args);
+
+  FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                _T("Local\\plainstarter-instance-%2!08x!-%3!08x!"),
+                0,
+                0,
+                PS_InstanceMutexName,
+                PS_ARRAY_SIZE(PS_InstanceMutexName),
+                (char **)Args);
+
+  PS_ArenaRelease(Mark);
+}
+
+/* Write the current directory and the arguments to Pipe */
+static BOOL PS_InstanceSend (HANDLE Pipe, int argc, TCHAR **argv)
+{
+  SIZE_T        Mark = PS_ArenaMark();
+  PS_ARENA_TEXT Message;
+  TCHAR        *p;
+  char         *Utf8;
+  DWORD         Length;
+  DWORD         Capacity;
+  DWORD         BytesWritten = 0;
+  int           Size;
+  int           Index;
+
+  Length   = GetCurrentDirectory(0, NULL);
+  Capacity = Length + 1;
+  for (Index = 1 ; Index < argc ; Index++)
+  {
+    Capacity += (DWORD)lstrlen(argv[Index]) + 1;
+  }
+
+  Message = PS_ArenaText(Capacity);
+  Length  = GetCurrentDirectory(Message.Capacity, Message.Data);
+  p       = Message.Data + Length + 1;
+  for (Index = 1 ; Index < argc ; Index++)
+  {
+    lstrcpy(p, argv[Index]);
+    p += lstrlen(argv[Index]) + 1;
+  }
+  Length = (DWORD)(p - Message.Data);
+
+  Size = WideCharToMultiByte(CP_UTF8, 0, Message.Data, (int)Length, NULL, 0, NULL, NULL);
+  if (Size > 0)
+  {
+    Utf8 = PS_ArenaAlloc((SIZE_T)Size);
+    WideCharToMultiByte(CP_UTF8, 0, Message.Data, (int)Length, Utf8, Size, NULL, NULL);
+    if (WriteFile(Pipe, Utf8, (DWORD)Size, &BytesWritten, NULL) == FALSE)
+    {
+      BytesWritten = 0;
+    }
+  }
+
+  PS_ArenaRelease(Mark);
+
+  return (Size > 0) && (BytesWritten == (DWORD)Size);
+}
+
+/* Let the child process of the first launcher take the foreground, the
+ * current launcher is the foreground process */
+static void PS_InstanceAllowForeground (HANDLE Pipe)
+{
+  PS_ALLOW_SET_FOREGROUND_WINDOW AllowSetForegroundWindowFunction;
+  ULONG                          ProcessId;
+
+  if (GetNamedPipeServerProcessId(Pipe, &ProcessId) == TRUE)
+  {
+    AllowSetForegroundWindowFunction = (PS_ALLOW_SET_FOREGROUND_WINDOW)PS_LoadFunction(_T("user32.dll"), "AllowSetForegroundWindow");
+    if (AllowSetForegroundWindowFunction != NULL)
+    {
+      AllowSetForegroundWindowFunction(ProcessId);
+    }
+  }
+}
+
+/* Return TRUE if the arguments are forwarded to the running instance. FALSE
+ * if the child process has to be started: the launcher is then the first
+ * one, and monitors the child, unless the running instance did not become
+ * ready in time. */
+static BOOL PS_InstanceForward (int argc, TCHAR **argv)
+{
+  HANDLE Pipe;
+  DWORD  Waited;
+  DWORD  Result;
+
+  PS_InstanceGetNames();
+  PS_EnvSetVariable(_T("PLAINSTARTER_INSTANCE_PIPE"), PS_InstancePipeName);
+
+  /* Same environment as the launchers, nothing else */
+  if (PS_PoolIsBroker == TRUE)
+  {
+    return FALSE;
+  }
+
+  PS_InstanceMutex = CreateMutex(NULL, TRUE, PS_InstanceMutexName);
+  if (PS_InstanceMutex == NULL)
+  {
+    return FALSE;
+  }
+
+  if (GetLastError() == ERROR_ALREADY_EXISTS)
+  {
+    for (Waited = 0 ; Waited < PS_OPTION_READY_TIMEOUT ; Waited += PS_INSTANCE_POLL_MS)
+    {
+      Pipe = CreateFile(PS_InstancePipeName, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+      if (Pipe != INVALID_HANDLE_VALUE)
+      {
+        PS_InstanceAllowForeground(Pipe);
+        if (PS_InstanceSend(Pipe, argc, argv) == TRUE)
+        {
+          CloseHandle(Pipe);
+          CloseHandle(PS_InstanceMutex);
+          PS_TRACE(_T("instance-forward"), NULL);
+          return TRUE;
+        }
+        CloseHandle(Pipe);
+      }
+      else if (GetLastError() == ERROR_PIPE_BUSY)
+      {
+        WaitNamedPipe(PS_InstancePipeName, PS_INSTANCE_POLL_MS);
+      }
+
+      /* The first launcher exited: this one takes over */
+      Result = WaitForSingleObject(PS_InstanceMutex, PS_INSTANCE_POLL_MS);
+      if ((Result == WAIT_OBJECT_0) || (Result == WAIT_ABANDONED))
+      {
+        break;
+      }
+    }
+
+    if (Waited >= PS_OPTION_READY_TIMEOUT)
+    {
+      CloseHandle(PS_InstanceMutex);
+      PS_InstanceMutex = NULL;
+      PS_TRACE(_T("instance-timeout"), NULL);
+      return FALSE;
+    }
+  }
+
+  /* The mutex is released when Plainstarter exits */
+  PS_OPTION_MONITOR_PROCESS = TRUE;
+  PS_TRACE(_T("instance-first"), NULL);
+
+  return FALSE;
+}
+
+/*-----------------*/
+/* PROCESS STARTUP */
+/*-----------------*/
+
+/* Run CommandLine together with the launch group. CommandLine is NULL when
+ * only the group is started, at the end of the configuration. */
+static int PS_RunProcess (TCHAR *CommandLine)
+{
+  BOOL                ExitCodeSuccess;
+  PROCESS_INFORMATION pi;
+  DWORD               ExitCode;
+  TCHAR              *Environment;
+  const TCHAR        *Path;
+
+  if (PS_OPTION_INIT_COMMON_CONTROLS == TRUE)
+  {
+    PS_InitCommonControls();
+  }
+
+  /* The processes are killed when Plainstarter exits, or their output is
+   * read by Plainstarter */
+  if ((PS_OPTION_SHOW_CONSOLE == TRUE)
+      || (PS_OPTION_KILL_ON_CLOSE == TRUE)
+      || (PS_OPTION_CAPTURE_OUTPUT == TRUE))
+  {
+    PS_OPTION_MONITOR_PROCESS = TRUE;
+  }
+
+  if ((PS_Job == NULL) && (PS_PoolIsBroker == FALSE) && (PS_JobIsEnabled() == TRUE))
+  {
+    PS_JobCreate();
+  }
+
+  PS_BENCH_BEGIN(PS_BENCH_ENVIRONMENT);
+  Environment = PS_EnvBuildBlock(&PS_Environment);
+  if (Environment == NULL)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  /* CreateProcess searches the executable with the PATH of Plainstarter, not
+   * the one of the environment block: this is the only variable applied to
+   * the current process */
+  Path = PS_EnvGet(&PS_Environment, _T("PATH"), 4);
+  SetEnvironmentVariable(_T("PATH"), Path);
+  PS_BENCH_END(PS_BENCH_ENVIRONMENT);
+
+  if ((PS_OPTION_CAPTURE_OUTPUT == TRUE) && (PS_PoolIsBroker == FALSE))
+  {
+    PS_CaptureStart();
+  }
+
+  if (PS_PoolIsBroker == TRUE)
+  {
+    /* The broker only fills the pool */
+    if (PS_PoolIsEnabled(CommandLine) == TRUE)
+    {
+      PS_PoolServe(CommandLine, Environment);
+    }
+    ExitCode = 0;
+  }
+  else if (PS_GroupCount > 0)
+  {
+    ExitCode = PS_GroupRun(CommandLine, Environment);
+  }
+  else if (((PS_PoolIsEnabled(CommandLine) == TRUE)
+            && (PS_PoolAcquire(CommandLine, Environment, &pi) == TRUE))
+           || (PS_CreateProcess(CommandLine, Environment, 0, &pi) == TRUE))
+  {
+    if (PS_OPTION_WAIT_READY != 0)
+    {
+      PS_ReadyRecord(&pi, CommandLine);
+    }
+
+    if ((PS_OPTION_MONITOR_PROCESS == TRUE) || (PS_OPTION_DEBUG == TRUE))
+    {
+      /* Wait until child process exits */
+      WaitForSingleObject(pi.hProcess, INFINITE);
+      PS_TRACE(_T("child-exit"), NULL);
+      PS_CaptureFinish();
+
+      /* Retrieve the exit code */
+      ExitCodeSuccess = GetExitCodeProcess(pi.hProcess, &ExitCode);
+
+      /* Retrieve the exit code */
+      if (ExitCodeSuccess == TRUE)
+      {
+        PS_StatsCollect(pi.hProcess, CommandLine, ExitCode);
+        PS_StatsWrite(ExitCode);
+        PS_ReportExitCode(ExitCode);
+      }
+      else
+      {
+        ExitCode = 99999;
+      }
+    }
+    else
+    {
+      ExitCode = 0;
+    }
+
+    /* Close process and thread handles, no thread handle for a process of
+     * the pool */
+    CloseHandle(pi.hProcess);
+    if (pi.hThread != NULL)
+    {
+      CloseHandle(pi.hThread);
+    }
+  }
+  else
+  {
+    /* The process could not be created */
+    ExitCode = (PS_HeadlessIsEnabled() == TRUE) ? (PS_HEADLESS_EXIT_BASE + 8) : -1;
+  }
+
+  PS_CaptureFinish();
+  PS_CommandDeleteResponseFile();
+
+  PS_EnvFreeBlock(Environment);
+
+  if (PS_PoolStartBroker == TRUE)
+  {
+    PS_PoolStartBroker = FALSE;
+    PS_PoolStart();
+  }
+
+  return ExitCode;
+}
+
+static void PS_SM_Initialize (const TCHAR *ProgramDirectory)
+{
+  /* Set a temporary environment variable with the location of the binary file,
+   * so that it is straight-forward to expand the command line arguments with
+   * PS_EnvExpand
+   */
+  PS_EnvSetVariable(_T("PLAINSTARTER_DIRECTORY"), ProgramDirectory);
+}
+
+/* The keywords of PLAINSTARTER_OPTIONS are separated by spaces or tabs */
+static BOOL PS_SM_IsOptionSeparator (TCHAR c)
+{
+  return (c == _T(' ')) || (c == _T('\t'));
+}
+
+/* Return the keyword of Options starting with Name, NULL if there is none.
+ * Only whole keywords match: a value such as the key of
+ * single-instance=debug-tool does not set the option debug. A Name ending
+ * with '=' matches any value, any other Name matches the keyword alone or
+ * followed by '='. */
+static const TCHAR *PS_SM_FindKeyword (const TCHAR *Options, const TCHAR *Name)
+{
+  const TCHAR *p      = Options;
+  int          Length = lstrlen(Name);
+  int          Index;
+
+  while (*p != _T('\0'))
+  {
+    while (PS_SM_IsOptionSeparator(*p) == TRUE)
+    {
+      p++;
+    }
+
+    Index = 0;
+    while ((Index < Length) && (p[Index] == Name[Index]))
+    {
+      Index++;
+    }
+
+    if ((Index == Length)
+        && ((Name[Length - 1] == _T('='))
+            || (p[Index] == _T('\0'))
+            || (p[Index] == _T('='))
+            || (PS_SM_IsOptionSeparator(p[Index]) == TRUE)))
+    {
+      return p;
+    }
+
+    while ((*p != _T('\0')) && (PS_SM_IsOptionSeparator(*p) == FALSE))
+    {
+      p++;
+    }
+  }
+
+  return NULL;
+}
+
+static BOOL PS_SM_HasOption (const TCHAR *Options, const TCHAR *Option)
+{
+  BOOL Result;
+
+  if (PS_SM_FindKeyword(Options, Option) == NULL)
+  {
+    Result = FALSE;
+  }
+  else
+  {
+    Result = TRUE;
+  }
+
+  return Result;
+}
+
+/* Return the value of the option Name=<value>, NULL if the option is not
+ * set */
+static const TCHAR *PS_SM_FindOption (const TCHAR *Options, const TCHAR *Name)
+{
+  const TCHAR *p;
+
+  p = PS_SM_FindKeyword(Options, Name);
+  if (p != NULL)
+  {
+    p += lstrlen(Name);
+  }
+
+  return p;
+}
+
+/* Compare the value of an option, terminated by a space or a tab */
+static BOOL PS_SM_IsOptionValue (const TCHAR *Value, const TCHAR *Expected)
+{
+  while ((*Expected != _T('\0')) && (*Value == *Expected))
+  {
+    Value++;
+    Expected++;
+  }
+
+  return (*Expected == _T('\0')) && ((*Value == _T('\0')) || (PS_SM_IsOptionSeparator(*Value) == TRUE));
+}
+
+/* Parse a decimal or hexadecimal (0x) number, p is moved after it */
+static ULONGLONG PS_SM_ParseNumber (const TCHAR **p)
+{
+  const TCHAR *pi    = *p;
+  ULONGLONG    Value = 0;
+
+  if ((pi[0] == _T('0')) && ((pi[1] == _T('x')) || (pi[1] == _T('X'))))
+  {
+    for (pi += 2 ; ; pi++)
+    {
+      if ((*pi >= _T('0')) && (*pi <= _T('9')))
+      {
+        Value = (Value << 4) | (ULONGLONG)(*pi - _T('0'));
+      }
+      else if ((*pi >= _T('a')) && (*pi <= _T('f')))
+      {
+        Value = (Value << 4) | (ULONGLONG)(*pi - _T('a') + 10);
+      }
+      else if ((*pi >= _T('A')) && (*pi <= _T('F')))
+      {
+        Value = (Value << 4) | (ULONGLONG)(*pi - _T('A') + 10);
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+  else
+  {
+    while ((*pi >= _T('0')) && (*pi <= _T('9')))
+    {
+      Value = (Value * 10) + (ULONGLONG)(*pi - _T('0'));
+      pi++;
+    }
+  }
+
+  *p = pi;
+
+  return Value;
+}
+
+/* Return the value of the option Name=<number>[K|M|G], 0 if the option is
+ * not set */
+static ULONGLONG PS_SM_GetOptionValue (const TCHAR *Options, const TCHAR *Name)
+{
+  const TCHAR *p;
+  ULONGLONG    Value = 0;
+
+  p = PS_SM_FindOption(Options, Name);
+  if (p != NULL)
+  {
+    Value = PS_SM_ParseNumber(&p);
+
+    switch (*p)
+    {
+    case _T('K'):
+    case _T('k'):
+      Value <<= 10;
+      break;
+
+    case _T('M'):
+    case _T('m'):
+      Value <<= 20;
+      break;
+
+    case _T('G'):
+    case _T('g'):
+      Value <<= 30;
+      break;
+    }
+  }
+
+  return Value;
+}
+
+/* Return the value of the option Name=<number>, -1 if the option is not
+ * set */
+static int PS_SM_GetOptionIndex (const TCHAR *Options, const TCHAR *Name)
+{
+  const TCHAR *p;
+  int          Index = -1;
+
+  p = PS_SM_FindOption(Options, Name);
+  if (p != NULL)
+  {
+    Index = (int)PS_SM_ParseNumber(&p);
+  }
+
+  return Index;
+}
+
+static void PS_SM_ReadPlacementOptions (const TCHAR *Options)
+{
+  const TCHAR *p;
+  size_t       Index;
+
+  static const struct {
+    const TCHAR *Name;
+    DWORD        Class;
+  } PriorityClasses[] = {
+    { _T("idle"),         IDLE_PRIORITY_CLASS         },
+    { _T("below-normal"), BELOW_NORMAL_PRIORITY_CLASS },
+    { _T("normal"),       NORMAL_PRIORITY_CLASS       },
+    { _T("above-normal"), ABOVE_NORMAL_PRIORITY_CLASS },
+    { _T("high"),         HIGH_PRIORITY_CLASS         }
+  };
+
+  PS_OPTION_PRIORITY_CLASS = 0;
+  p = PS_SM_FindOption(Options, _T("priority="));
+  if (p != NULL)
+  {
+    for (Index = 0 ; Index < PS_ARRAY_SIZE(PriorityClasses) ; Index++)
+    {
+      if (PS_SM_IsOptionValue(p, PriorityClasses[Index].Name) == TRUE)
+      {
+        PS_OPTION_PRIORITY_CLASS = PriorityClasses[Index].Class;
+      }
+    }
+  }
+
+  PS_OPTION_AFFINITY        = PS_SM_GetOptionValue(Options, _T("affinity="));
+  PS_OPTION_PROCESSOR_GROUP = PS_SM_GetOptionIndex(Options, _T("processor-group="));
+  PS_OPTION_NUMA_NODE       = PS_SM_GetOptionIndex(Options, _T("numa-node="));
+
+  /* cpu-sets=<id>,<id>,... */
+  PS_OPTION_CPU_SET_COUNT = 0;
+  p = PS_SM_FindOption(Options, _T("cpu-sets="));
+  while ((p != NULL) && (PS_OPTION_CPU_SET_COUNT < PS_ARRAY_SIZE(PS_OPTION_CPU_SETS)))
+  {
+    PS_OPTION_CPU_SETS[PS_OPTION_CPU_SET_COUNT++] = (ULONG)PS_SM_ParseNumber(&p);
+    p = (*p == _T(',')) ? (p + 1) : NULL;
+  }
+
+  PS_OPTION_EFFICIENCY_MODE = -1;
+  p = PS_SM_FindOption(Options, _T("efficiency-mode="));
+  if (p != NULL)
+  {
+    if (PS_SM_IsOptionValue(p, _T("on")) == TRUE)
+    {
+      PS_OPTION_EFFICIENCY_MODE = 1;
+    }
+    else if (PS_SM_IsOptionValue(p, _T("off")) == TRUE)
+    {
+      PS_OPTION_EFFICIENCY_MODE = 0;
+    }
+  }
+}
+
+static void PS_SM_ReadOptions ()
+{
+  const TCHAR *Options;
+  const TCHAR *p;
+  TCHAR        Key[256];
+  size_t       Index;
+
+  Options = PS_EnvGet(&PS_Environment, _T("PLAINSTARTER_OPTIONS"), 20);
+  if (Options == NULL)
+  {
+    Options = _T("");
+  }
+
+  PS_OPTION_SHOW_CONSOLE         = PS_SM_HasOption(Options, _T("show-console"));
+  PS_OPTION_INIT_COMMON_CONTROLS = PS_SM_HasOption(Options, _T("init-common-controls"));
+  PS_OPTION_MONITOR_PROCESS      = PS_SM_HasOption(Options, _T("monitor-process"));
+  PS_OPTION_DEBUG                = PS_SM_HasOption(Options, _T("debug"));
+  PS_OPTION_CONFIG_CACHE         = PS_SM_HasOption(Options, _T("config-cache"));
+  PS_OPTION_REPORT_UNDEFINED     = PS_SM_HasOption(Options, _T("report-undefined"));
+  PS_OPTION_GROUP_WAIT_ANY       = PS_SM_HasOption(Options, _T("group-wait-any"));
+  PS_OPTION_GROUP_EXIT_MAX       = PS_SM_HasOption(Options, _T("group-exit-max"));
+  PS_OPTION_GROUP_EXIT_FIRST     = PS_SM_HasOption(Options, _T("group-exit-first"));
+  PS_OPTION_PROCESS_POOL         = PS_SM_HasOption(Options, _T("process-pool"));
+  PS_OPTION_KILL_ON_CLOSE        = PS_SM_HasOption(Options, _T("kill-on-close"));
+  PS_OPTION_TRACE                = PS_SM_HasOption(Options, _T("trace"));
+  PS_OPTION_STATS                = PS_SM_HasOption(Options, _T("stats"));
+  PS_OPTION_CAPTURE_OUTPUT       = PS_SM_HasOption(Options, _T("capture-output"));
+  PS_OPTION_RAW_ARGUMENTS        = PS_SM_HasOption(Options, _T("raw-arguments"));
+  PS_OPTION_PATH_CACHE           = PS_SM_HasOption(Options, _T("path-cache"));
+  PS_OPTION_PRUNE_MISSING_DIRS   = PS_SM_HasOption(Options, _T("prune-missing-dirs"));
+
+  /* Never disabled by the option once the variable PLAINSTARTER_HEADLESS is
+   * defined */
+  if (PS_SM_HasOption(Options, _T("headless")) == TRUE)
+  {
+    PS_Headless = 1;
+  }
+  PS_OPTION_JOB_MEMORY           = PS_SM_GetOptionValue(Options, _T("job-memory="));
+  PS_OPTION_PROCESS_MEMORY       = PS_SM_GetOptionValue(Options, _T("process-memory="));
+  PS_OPTION_CPU_RATE             = (DWORD)PS_SM_GetOptionValue(Options, _T("cpu-rate="));
+  PS_OPTION_ACTIVE_PROCESSES     = (DWORD)PS_SM_GetOptionValue(Options, _T("active-processes="));
+
+  if (PS_OPTION_CPU_RATE > 100)
+  {
+    PS_OPTION_CPU_RATE = 100;
+  }
+
+  /* process-pool alone keeps PS_POOL_SIZE processes, process-pool=0
+   * disables the pool */
+  PS_OPTION_POOL_SIZE = PS_POOL_SIZE;
+  if (PS_SM_FindOption(Options, _T("process-pool=")) != NULL)
+  {
+    PS_OPTION_POOL_SIZE = (DWORD)PS_SM_GetOptionIndex(Options, _T("process-pool="));
+  }
+  if (PS_OPTION_POOL_SIZE == 0)
+  {
+    PS_OPTION_PROCESS_POOL = FALSE;
+  }
+  else if (PS_OPTION_POOL_SIZE > PS_POOL_MAX_SIZE)
+  {
+    PS_OPTION_POOL_SIZE = PS_POOL_MAX_SIZE;
+  }
+
+  PS_OPTION_LOG_SIZE  = PS_SM_GetOptionValue(Options, _T("log-size="));
+  PS_OPTION_LOG_FILES = (DWORD)PS_SM_GetOptionIndex(Options, _T("log-files="));
+  if (PS_SM_FindOption(Options, _T("log-size=")) == NULL)
+  {
+    PS_OPTION_LOG_SIZE = PS_CAPTURE_LOG_SIZE;
+  }
+  if (PS_SM_FindOption(Options, _T("log-files=")) == NULL)
+  {
+    PS_OPTION_LOG_FILES = PS_CAPTURE_LOG_FILES;
+  }
+
+  PS_OPTION_WAIT_READY = 0;
+  p = PS_SM_FindOption(Options, _T("wait-ready="));
+  if (p != NULL)
+  {
+    if (PS_SM_IsOptionValue(p, _T("input-idle")) == TRUE)
+    {
+      PS_OPTION_WAIT_READY = PS_READY_INPUT_IDLE;
+    }
+    else if (PS_SM_IsOptionValue(p, _T("window")) == TRUE)
+    {
+      PS_OPTION_WAIT_READY = PS_READY_WINDOW;
+    }
+    else if (PS_SM_IsOptionValue(p, _T("both")) == TRUE)
+    {
+      PS_OPTION_WAIT_READY = PS_READY_INPUT_IDLE | PS_READY_WINDOW;
+    }
+  }
+
+  /* single-instance=<key>, the key ends at the next space or tab */
+  PS_OPTION_SINGLE_INSTANCE = FALSE;
+  p = PS_SM_FindOption(Options, _T("single-instance="));
+  if (p != NULL)
+  {
+    for (Index = 0 ; (p[Index] != _T('\0')) && (PS_SM_IsOptionSeparator(p[Index]) == FALSE) && (Index < (PS_ARRAY_SIZE(Key) - 1)) ; Index++)
+    {
+      Key[Index] = p[Index];
+    }
+    Key[Index] = _T('\0');
+
+    PS_OPTION_SINGLE_INSTANCE = TRUE;
+    PS_OPTION_INSTANCE_KEY    = PS_HashString(PS_FNV_OFFSET_BASIS, Key);
+  }
+
+  PS_OPTION_READY_TIMEOUT = (DWORD)PS_SM_GetOptionValue(Options, _T("ready-timeout="));
+  if (PS_SM_FindOption(Options, _T("ready-timeout=")) == NULL)
+  {
+    PS_OPTION_READY_TIMEOUT = PS_READY_TIMEOUT_MS;
+  }
+
+  PS_SM_ReadPlacementOptions(Options);
+}
+
+static void PS_SM_SetVariable (const TCHAR *Name, const TCHAR *Value)
+{
+  PS_BENCH_BEGIN(PS_BENCH_SET_VARIABLE);
+  PS_EnvSetVariable(Name, Value);
+  PS_BENCH_END(PS_BENCH_SET_VARIABLE);
+
+  /* The options apply to the following lines, ie report-undefined */
+  if (lstrcmpi(Name, _T("PLAINSTARTER_OPTIONS")) == 0)
+  {
+    PS_SM_ReadOptions();
+  }
+  else if (lstrcmpi(Name, _T("PLAINSTARTER_LOG_FILE")) == 0)
+  {
+    lstrcpyn(PS_CaptureFilename, ((Value != NULL) ? Value : _T("")), PS_ARRAY_SIZE(PS_CaptureFilename));
+  }
+}
+
+/* Return the operation of NAME^=VALUE, NAME+=VALUE or NAME-=VALUE and copy
+ * NAME in BaseName, or return 0 for NAME=VALUE */
+static unsigned int PS_SM_GetListOperation (const TCHAR *Name, TCHAR *BaseName)
+{
+  int          Length    = lstrlen(Name);
+  unsigned int Operation = 0;
+
+  if (Length > 1)
+  {
+    switch (Name[Length - 1])
+    {
+    case _T('^'): Operation = PS_LIST_PREPEND; break;
+    case _T('+'): Operation = PS_LIST_APPEND;  break;
+    case _T('-'): Operation = PS_LIST_REMOVE;  break;
+    }
+  }
+
+  if (Operation != 0)
+  {
+    lstrcpyn(BaseName, Name, Length);
+  }
+
+  return Operation;
+}
+
+/* Filter of the option prune-missing-dirs */
+static int PS_SM_DirectoryExists (void *Context, const TCHAR *Entry, size_t Length)
+{
+  TCHAR Directory[MAX_PATH];
+  DWORD Attributes;
+
+  (void)Context;
+
+  /* Too long to be checked, kept */
+  if (Length >= PS_ARRAY_SIZE(Directory))
+  {
+    return 1;
+  }
+
+  lstrcpyn(Directory, Entry, (int)(Length + 1));
+  Attributes = GetFileAttributes(Directory);
+
+  return (Attributes != INVALID_FILE_ATTRIBUTES)
+    && ((Attributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+}
+
+/* Apply the list operation to the variable BaseName with the expanded
+ * Value, return the new value */
+static const TCHAR *PS_SM_UpdateList (const TCHAR  *BaseName,
+                                      const TCHAR  *Value,
+                                      unsigned int  Operation)
+{
+  static PS_STRING List;
+
+  if (PS_EnvUpdateList(PS_EnvGet(&PS_Environment, BaseName, lstrlen(BaseName)),
+                       Value,
+                       Operation,
+                       PS_LIST_SEPARATOR,
+                       ((PS_OPTION_PRUNE_MISSING_DIRS == TRUE) ? PS_SM_DirectoryExists : NULL),
+                       NULL,
+                       &List) == 0)
+  {
+    PS_MessageAndExit(13, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+  }
+
+  return List.Data;
+}
+
+/* The expansion is done, delete useless environment variables */
+static void PS_SM_DeleteSpecialVariables (void)
+{
+  PS_EnvSetVariable(_T("PLAINSTARTER_CMD_LINE"),  NULL);
+  PS_EnvSetVariable(_T("PLAINSTARTER_PROGNAME"),  NULL);
+  PS_EnvSetVariable(_T("PLAINSTARTER_DIRECTORY"), NULL);
+  PS_EnvSetVariable(_T("PLAINSTARTER_OPTIONS"),   NULL);
+  PS_EnvSetVariable(_T("PLAINSTARTER_LOG_FILE"),  NULL);
+}
+
+static void PS_SM_ProcessVariable (const TCHAR *Name,
+                                   const TCHAR *Value,
+                                   int          argc,
+                                   TCHAR      **argv)
+{
+  /* NAME is copied after a leading % to record %NAME% in place: a second
+   * buffer would bring the frame over 4 KiB and require ___chkstk_ms */
+  TCHAR        Reference[PS_MAX_LINE_LENGTH + 2];
+  TCHAR       *BaseName = (Reference + 1);
+  unsigned int Operation;
+  int          Length;
+  TCHAR       *p;
+
+  if (lstrcmp(Name, PS_CMD_LINE) == 0)
+  {
+    if (PS_CacheRecording == TRUE)
+    {
+      PS_CacheRecordVariable(Name, Value);
+    }
+
+    PS_SM_ReadOptions();
+
+    /* The launches started meanwhile can use the cache */
+    PS_CacheFlush();
+
+    /* Forwarded to the running instance: nothing is started, the launch ends
+     * as usual once the configuration is processed */
+    if ((PS_InstanceForwarded == FALSE)
+        && (PS_OPTION_SINGLE_INSTANCE == TRUE)
+        && (PS_InstanceForward(argc, argv) == TRUE))
+    {
+      PS_InstanceForwarded = TRUE;
+    }
+
+    if (PS_InstanceForwarded == FALSE)
+    {
+      p = PS_CommandBuild(Value, argc, argv);
+      PS_TRACE(_T("expand-cmd-line"), NULL);
+
+      PS_SM_DeleteSpecialVariables();
+
+      /* Run the process */
+      PS_LAST_EXEC_CODE = PS_RunProcess(p);
+    }
+  }
+  else if (lstrcmp(Name, PS_GROUP_CMD_LINE) == 0)
+  {
+    if (PS_CacheRecording == TRUE)
+    {
+      PS_CacheRecordReferences(Value);
+    }
+
+    /* The parameters given to Plainstarter are only appended to
+     * PLAINSTARTER_CMD_LINE */
+    PS_BENCH_BEGIN(PS_BENCH_EXPAND);
+    Value = PS_EnvExpandVariable(Value);
+    PS_BENCH_END(PS_BENCH_EXPAND);
+
+    PS_GroupAdd(Value);
+    PS_TRACE(_T("variable"), Name);
+
+    if (PS_CacheRecording == TRUE)
+    {
+      PS_CacheRecordVariable(Name, Value);
+    }
+  }
+  else if ((Operation = PS_SM_GetListOperation(Name, BaseName)) != 0)
   {
-    /* Find the end of the string and last backslash location */
-    LastBackslash = Buffer + BufferLen;
-    LastDot       = Buffer + BufferLen;
-    p             = Buffer;
-    while (*p)
+    /* The current value is referenced like %NAME% */
+    if (PS_CacheRecording == TRUE)
     {
-      if (*p == _T('\\'))
-      {
-        LastBackslash = p;
-      }
-      else if (*p == _T('.'))
-      {
-        LastDot = p;
-      }
-      p++;
+      Length               = lstrlen(BaseName);
+      Reference[0]         = _T('%');
+      BaseName[Length]     = _T('%');
+      BaseName[Length + 1] = _T('\0');
+      PS_CacheRecordReferences(Reference);
+      BaseName[Length]     = _T('\0');
+      PS_CacheRecordReferences(Value);
     }
 
-    /* Set Progname */
-    Progname = LastBackslash + 1;
-    *LastDot = _T('\0');
-    SetEnvironmentVariable(_T("PLAINSTARTER_PROGNAME"), Progname);
+    PS_BENCH_BEGIN(PS_BENCH_EXPAND);
+    Value = PS_EnvExpandVariable(Value);
+    Value = PS_SM_UpdateList(BaseName, Value, Operation);
+    PS_BENCH_END(PS_BENCH_EXPAND);
 
-    /* Create a new string */
-    DirLength = LastBackslash - Buffer;
-    NewString = HeapAlloc(GetProcessHeap(), 0, ((DirLength + 1) * sizeof(TCHAR)));
-    lstrcpyn(NewString, Buffer, (DirLength + 1)); /* lstrcpyn include null character */
+    PS_SM_SetVariable(BaseName, Value);
+    PS_TRACE(_T("variable"), BaseName);
+
+    if (PS_CacheRecording == TRUE)
+    {
+      PS_CacheRecordVariable(BaseName, Value);
+    }
   }
   else
   {
-    NewString = NULL;
-  }
+    if (PS_CacheRecording == TRUE)
+    {
+      PS_CacheRecordReferences(Value);
+    }
+
+    /* Try to expand the references to environment variables (ie %PATH%) */
+    PS_BENCH_BEGIN(PS_BENCH_EXPAND);
+    Value = PS_EnvExpandVariable(Value);
+    PS_BENCH_END(PS_BENCH_EXPAND);
+
+    /* Set the environment variable */
+    PS_SM_SetVariable(Name, Value);
+    PS_TRACE(_T("variable"), Name);
 
-  return NewString;
+    if (PS_CacheRecording == TRUE)
+    {
+      PS_CacheRecordVariable(Name, Value);
+    }
+  }
 }
 
-static void PS_ReportExecutionError (int ErrorCode)
+/* The lines ignored because their name or value is too long are reported
+ * once, before the command line is executed, with the options trace and
+ * debug */
+static void PS_SM_ReportOverlong (const PS_PARSER *Parser)
 {
-  DWORD BytesWritten;
-  
+  static BOOL Reported = FALSE;
+  TCHAR       Message[256];
+  DWORD       BytesWritten;
+
+  if ((Parser == NULL) || (Parser->OverlongCount == 0) || (Reported == TRUE))
+  {
+    return;
+  }
+  Reported = TRUE;
+
   DWORD_PTR Args[] = {
-    (DWORD_PTR)ErrorCode
+    (DWORD_PTR)Parser->OverlongCount,
+    (DWORD_PTR)Parser->OverlongLine,
+    (DWORD_PTR)(PS_MAX_LINE_LENGTH - 1)
   };
 
   BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
                                | FORMAT_MESSAGE_ARGUMENT_ARRAY,
-                               _T("Plainstarter\n")
-                               _T("The child process terminated abnormally.\n")
-                               _T("Return code %1!d! (0x%1!x!)"),
+                               _T("%1!u! line(s) of the configuration ignored, starting at line %2!u!: the names and the values are limited to %3!u! characters."),
                                0,
                                0,
-                               (LPWSTR)PS_BufferOut,
-                               sizeof(PS_BufferOut),
+                               Message,
+                               PS_ARRAY_SIZE(Message),
                                (char **)Args);
 
-  if (BytesWritten > 0)
+  if ((BytesWritten > 0) && (PS_OPTION_DEBUG == TRUE))
   {
-    PS_MessageAndExit(5, PS_BufferOut, MB_ICONERROR);
+    PS_MessageBox(NULL, Message, _T("WARNING"), MB_ICONWARNING);
   }
-  else
+
+  /* The first line ignored */
+  BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
+                               | FORMAT_MESSAGE_ARGUMENT_ARRAY,
+                               _T("line %2!u!"),
+                               0,
+                               0,
+                               Message,
+                               PS_ARRAY_SIZE(Message),
+                               (char **)Args);
+
+  if (BytesWritten > 0)
   {
-    PS_MessageAndExit(6, PS_UNEXPECTED_ERROR, MB_ICONERROR);
+    PS_TRACE(_T("overlong-line"), Message);
   }
 }
 
-static int PS_RunProcess (TCHAR *CommandLine)
+/* Callback of the configuration parser */
+static void PS_SM_ParserCallback (void        *Context,
+                                  const TCHAR *Name,
+                                  const TCHAR *Value)
 {
-  BOOL                CpResult;
-  BOOL                ExitCodeSuccess;
-  STARTUPINFO         si;
-  PROCESS_INFORMATION pi;
-  DWORD               ExitCode;
-  DWORD               BytesWritten;
-  BOOL                InheritHandles;
-
-  SecureZeroMemory(&si, sizeof(si));
-  SecureZeroMemory(&pi, sizeof(pi));
+  PS_SM_CONTEXT *SmContext = Context;
 
-  si.cb = sizeof(si);
+  PS_BENCH_PAUSE(PS_BENCH_PARSE);
 
-  if (PS_OPTION_INIT_COMMON_CONTROLS == TRUE)
+  if (lstrcmp(Name, PS_CMD_LINE) == 0)
   {
-    InitCommonControls();
+    PS_SM_ReportOverlong(SmContext->Parser);
   }
 
-  if (PS_OPTION_SHOW_CONSOLE == TRUE)
-  {
-    InheritHandles            = TRUE;
-    PS_OPTION_MONITOR_PROCESS = TRUE;
-  }
-  else
-  {
-    InheritHandles = FALSE;
-  }
+  PS_SM_ProcessVariable(Name, Value, SmContext->argc, SmContext->argv);
 
-  if (PS_OPTION_DEBUG == TRUE)
-  {
-    MessageBox(NULL, CommandLine, _T("DEBUG"), MB_ICONINFORMATION);
-  }
+  PS_BENCH_RESUME(PS_BENCH_PARSE);
+}
 
-  CpResult = CreateProcess(NULL,           /* NULL: use command line        */
-                           CommandLine,    /* Command line                  */
-                           NULL,           /* Process handle not inheritable*/
-                           NULL,           /* Thread handle not inheritable */
-                           InheritHandles, /* No handle inheritance         */
-                           0,              /* Creation flags                */
-                           NULL,           /* Use parent environment block  */
-                           NULL,           /* Use parent starting directory */
-                           &si,            /* STARTUPINFO structure         */
-                           &pi);           /* PROCESS_INFORMATION structure */
+/* The parser keeps a name and a value of PS_MAX_LINE_LENGTH characters: as
+ * a local it would need a stack frame over 4 KiB, probed by ___chkstk_ms from
+ * libgcc, which is not linked. The file and the embedded configuration are
+ * exclusive, they share this one. */
+static PS_PARSER PS_Parser;
 
-  if (CpResult == TRUE)
+/* Read and parse the configuration file. The file is mapped in memory by
+ * views of PS_CONFIG_VIEW_SIZE_BYTES given to the parser one after the other:
+ * the memory usage does not depend on the size of the file. Return FALSE if
+ * the file cannot be opened.
+ *
+ * A file starting with the UTF-16 LE Byte Order Mark is parsed directly from
+ * the views. Any other file is UTF-8, with or without Byte Order Mark: each
+ * view is converted to UTF-16 in a single buffer of the arena before being
+ * parsed.
+ */
+static BOOL PS_ReadConfiguration (const TCHAR  *Filename,
+                                  int           argc,
+                                  TCHAR       **argv)
+{
+  SIZE_T        Mark      = PS_ArenaMark();
+  HANDLE        Infile;
+  HANDLE        Mapping;
+  LARGE_INTEGER InfileSize;
+  ULONGLONG     Offset;
+  SIZE_T        ViewSize;
+  const BYTE   *View;
+  TCHAR        *Converted = NULL;
+  size_t        ConvertedLength;
+  BOOL          IsUtf16   = FALSE;
+  PS_SM_CONTEXT Context;
+
+  PS_UTF8_DECODER Decoder;
+
+  Infile = CreateFile(Filename,
+                      GENERIC_READ,
+                      FILE_SHARE_READ,
+                      NULL,
+                      OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL
+                      | FILE_ATTRIBUTE_READONLY
+                      | FILE_ATTRIBUTE_HIDDEN,
+                      NULL);
+
+  if (Infile != INVALID_HANDLE_VALUE)
   {
-    if ((PS_OPTION_MONITOR_PROCESS == TRUE) || (PS_OPTION_DEBUG == TRUE))
+    Context.argc   = argc;
+    Context.argv   = argv;
+    Context.Parser = &PS_Parser;
+    PS_ParserInitialize(&PS_Parser, PS_SM_ParserCallback, &Context);
+
+    if (GetFileSizeEx(Infile, &InfileSize) == 0)
     {
-      /* Wait until child process exits */
-      WaitForSingleObject(pi.hProcess, INFINITE);
+      PS_MessageAndExit(24, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+    }
 
-      /* Retrieve the exit code */
-      ExitCodeSuccess = GetExitCodeProcess(pi.hProcess, &ExitCode);
-      
-      /* Retrieve the exit code */
-      if (ExitCodeSuccess == TRUE)
+    /* Empty files cannot be mapped */
+    if (InfileSize.QuadPart > 0)
+    {
+      Mapping = CreateFileMapping(Infile, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (Mapping == NULL)
+      {
+        PS_MessageAndExit(25, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+      }
+
+      for (Offset = 0 ; Offset < (ULONGLONG)InfileSize.QuadPart ; Offset += ViewSize)
       {
-        if (PS_OPTION_DEBUG == TRUE)
+        ViewSize = PS_CONFIG_VIEW_SIZE_BYTES;
+        if (ViewSize > ((ULONGLONG)InfileSize.QuadPart - Offset))
         {
-          PS_ReportExecutionError(ExitCode);
+          ViewSize = (SIZE_T)((ULONGLONG)InfileSize.QuadPart - Offset);
         }
-#if defined(PLAINSTARTER_WINDOWS)
-        if ((PS_OPTION_MONITOR_PROCESS == TRUE) && (ExitCode != 0))
+
+        View = MapViewOfFile(Mapping,
+                             FILE_MAP_READ,
+                             (DWORD)(Offset >> 32),
+                             (DWORD)(Offset & 0xFFFFFFFF),
+                             ViewSize);
+        if (View == NULL)
         {
-          PS_ReportExecutionError(ExitCode);
+          PS_MessageAndExit(26, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
         }
-#endif
-      }
-      else
-      {
-        ExitCode = 99999;
+
+        /* The first view is the largest one */
+        if (Offset == 0)
+        {
+          IsUtf16 = (ViewSize >= 2) && (View[0] == 0xFF) && (View[1] == 0xFE);
+          if (IsUtf16 == FALSE)
+          {
+            PS_Utf8Initialize(&Decoder);
+            Converted = PS_ArenaAlloc((ViewSize + 1) * sizeof(TCHAR));
+          }
+        }
+
+        if (IsUtf16 == TRUE)
+        {
+          PS_ParseConfiguration(&PS_Parser,
+                                (const TCHAR *)View,
+                                ((const TCHAR *)View + (ViewSize / sizeof(TCHAR))));
+        }
+        else
+        {
+          ConvertedLength = PS_Utf8Decode(&Decoder, View, ViewSize, (PS_UTF16 *)Converted);
+          if (Decoder.InvalidCount > 0)
+          {
+            PS_MessageAndExit(9, PS_ENCODING_ERROR, EXIT_FAILURE);
+          }
+          PS_ParseConfiguration(&PS_Parser, Converted, (Converted + ConvertedLength));
+        }
+
+        UnmapViewOfFile(View);
       }
+
+      CloseHandle(Mapping);
     }
-    else
+
+    /* A sequence truncated at the end of the file is invalid */
+    if (Converted != NULL)
     {
-      ExitCode = 0;
+      PS_Utf8Finish(&Decoder, (PS_UTF16 *)Converted);
+      if (Decoder.InvalidCount > 0)
+      {
+        PS_MessageAndExit(9, PS_ENCODING_ERROR, EXIT_FAILURE);
+      }
     }
 
-    /* Close process and thread handles */
-    CloseHandle(pi.hProcess);
-    CloseHandle(pi.hThread);
+    PS_ParserFinish(&PS_Parser);
+    PS_SM_ReportOverlong(&PS_Parser);
+
+    /* Release resources */
+    CloseHandle(Infile);
+    PS_ArenaRelease(Mark);
   }
-  else
-  {
-    ExitCode = -1;
-    if (GetEnvironmentVariable(_T("PATH"), PS_BufferIn, (sizeof(PS_BufferIn))) == 0)
-    {
-      PS_BufferIn[0] = _T('\0');
-    }
 
-    DWORD_PTR Args[] = {
-      (DWORD_PTR)CommandLine,
-      (DWORD_PTR)PS_BufferIn
-    };
+  return (Infile != INVALID_HANDLE_VALUE);
+}
 
-    BytesWritten = FormatMessage(FORMAT_MESSAGE_FROM_STRING
-                                 | FORMAT_MESSAGE_ARGUMENT_ARRAY,
-                                 _T("Error: the command line could not be executed\n")
-                                 _T("[%1!s!]\n\n")
-                                 _T("PATH: '%2!s!'\n"),
-                                 0,
-                                 0,
-                                 (LPWSTR)&PS_BufferIn,
-                                 sizeof(PS_BufferIn),
-                                 (char **)Args);
-    if (BytesWritten > 0)
-    {
-      MessageBox(NULL, PS_BufferIn, _T("Error#08"), MB_ICONERROR);
-    }
-    else
+/* Return the configuration embedded in the executable as the resource
+ * PS_CONFIG_RESOURCE_ID of type RCDATA, NULL if there is none. The resource
+ * is part of the image already mapped by the loader: no file is read. */
+static const BYTE *PS_FindEmbeddedConfiguration (DWORD *Size)
+{
+  HRSRC       Resource;
+  HGLOBAL     Loaded;
+  const BYTE *Data = NULL;
+
+  Resource = FindResource(NULL, MAKEINTRESOURCE(PS_CONFIG_RESOURCE_ID), RT_RCDATA);
+  if (Resource != NULL)
+  {
+    Loaded = LoadResource(NULL, Resource);
+    if (Loaded != NULL)
     {
-      MessageBox(NULL, PS_UNEXPECTED_ERROR, _T("Error#09"), MB_ICONERROR);
+      Data  = LockResource(Loaded);
+      *Size = SizeofResource(NULL, Resource);
     }
   }
 
-  return ExitCode;
+  return Data;
 }
 
-static void PS_SM_Initialize (const TCHAR *ProgramDirectory)
+/* Parse the embedded configuration, encoded like a configuration file */
+static void PS_ParseEmbeddedConfiguration (const BYTE  *Data,
+                                           DWORD        Size,
+                                           int          argc,
+                                           TCHAR      **argv)
 {
-  /* Set a temporary environment variable with the location of the binary file,
-   * so that it is straight-forward to expand the command line arguments with
-   * ExpandEnvironmentStrings
-   */
-  SetEnvironmentVariable(_T("PLAINSTARTER_DIRECTORY"), ProgramDirectory);
-}
+  SIZE_T         Mark = PS_ArenaMark();
+  TCHAR         *Converted;
+  size_t         ConvertedLength;
+  PS_SM_CONTEXT  Context;
 
-static BOOL PS_SM_HasOption (TCHAR *Options, TCHAR *Option)
-{
-  BOOL Result;
+  PS_UTF8_DECODER Decoder;
+
+  Context.argc   = argc;
+  Context.argv   = argv;
+  Context.Parser = &PS_Parser;
+  PS_ParserInitialize(&PS_Parser, PS_SM_ParserCallback, &Context);
 
-  if (StrStr(Options, Option) == NULL)
+  if ((Size >= 2) && (Data[0] == 0xFF) && (Data[1] == 0xFE))
   {
-    Result = FALSE;
+    PS_ParseConfiguration(&PS_Parser,
+                          (const TCHAR *)Data,
+                          ((const TCHAR *)Data + (Size / sizeof(TCHAR))));
   }
   else
   {
-    Result = TRUE;
-  }
+    Converted = PS_ArenaAlloc(((SIZE_T)Size + 1) * sizeof(TCHAR));
 
-  return Result;
-}
+    PS_Utf8Initialize(&Decoder);
+    ConvertedLength  = PS_Utf8Decode(&Decoder, Data, Size, (PS_UTF16 *)Converted);
+    ConvertedLength += PS_Utf8Finish(&Decoder, (PS_UTF16 *)(Converted + ConvertedLength));
+    if (Decoder.InvalidCount > 0)
+    {
+      PS_MessageAndExit(9, PS_ENCODING_ERROR, EXIT_FAILURE);
+    }
 
-static void PS_SM_ReadOptions ()
-{
-  /* Put the options in BufferIn */
-  ExpandEnvironmentStrings(L"%PLAINSTARTER_OPTIONS%", PS_BufferIn, sizeof(PS_BufferIn));
+    PS_ParseConfiguration(&PS_Parser, Converted, (Converted + ConvertedLength));
+  }
 
-  PS_OPTION_SHOW_CONSOLE         = PS_SM_HasOption(PS_BufferIn, _T("show-console"));
-  PS_OPTION_INIT_COMMON_CONTROLS = PS_SM_HasOption(PS_BufferIn, _T("init-common-controls"));
-  PS_OPTION_MONITOR_PROCESS      = PS_SM_HasOption(PS_BufferIn, _T("monitor-process"));
-  PS_OPTION_DEBUG                = PS_SM_HasOption(PS_BufferIn, _T("debug"));
+  PS_ParserFinish(&PS_Parser);
+  PS_SM_ReportOverlong(&PS_Parser);
+  PS_ArenaRelease(Mark);
 }
 
-static void PS_SM_ProcessVariable (const TCHAR *Name,
-                                   const TCHAR *Value,
-                                   int          argc,
-                                   TCHAR      **argv)
+/* Replay the cache file if it matches the configuration file and the parent
+ * environment. Return FALSE if the configuration needs to be parsed.
+ */
+static BOOL PS_CacheReplay (const TCHAR                     *CacheFilename,
+                            const WIN32_FILE_ATTRIBUTE_DATA *ConfigInfo,
+                            int                              argc,
+                            TCHAR                          **argv)
 {
-  const TCHAR *CMD_LINE = _T("PLAINSTARTER_CMD_LINE");
-  TCHAR *p;
-  int    i;
+  HANDLE                 Infile;
+  HANDLE                 Mapping;
+  const PS_CACHE_HEADER *Header;
+  const TCHAR           *Name;
+  const TCHAR           *Value;
+  const TCHAR           *p;
+  DWORD                  InfileSize;
+  DWORD                  Index;
+  BOOL                   Replayed = FALSE;
 
-  if (lstrcmp(Name, CMD_LINE) == 0)
-  {
-    p = PS_BufferIn + lstrlen(PS_BufferIn);
-    for (i=1 ; i<argc ; i++)
-    {
-      *p++ = _T(' ');
-      *p++ = _T('\"');
-      p = PS_StringAppend(p, argv[i], (argv[i] + lstrlen(argv[i]) - 1));
-      *p++ = _T('\"');
-    }
+  Infile = CreateFile(CacheFilename,
+                      GENERIC_READ,
+                      FILE_SHARE_READ | FILE_SHARE_DELETE,
+                      NULL,
+                      OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL,
+                      NULL);
 
-    /* End the string */
-    *p = _T('\0');
+  if (Infile != INVALID_HANDLE_VALUE)
+  {
+    PS_CacheExists = TRUE;
+    InfileSize     = GetFileSize(Infile, NULL);
 
-    if (ExpandEnvironmentStrings(PS_BufferIn, PS_BufferOut, sizeof(PS_BufferOut)) == 0)
+    if ((InfileSize != INVALID_FILE_SIZE) && (InfileSize >= sizeof(PS_CACHE_HEADER)))
     {
-      /* If fails, just copy the buffer unchanged */
-      p = PS_StringAppend(PS_BufferOut, PS_BufferIn, PS_BufferIn + lstrlen(PS_BufferIn));
-      p[0] = _T('\0');
-    }
+      Mapping = CreateFileMapping(Infile, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (Mapping != NULL)
+      {
+        Header = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+        if ((Header != NULL) && (PS_CacheValidate(Header, InfileSize, ConfigInfo) == TRUE))
+        {
+          /* Skip the inherited variables */
+          p = (const TCHAR *)(Header + 1);
+          for (Index = 0 ; Index < Header->NameCount ; Index++)
+          {
+            p += (lstrlen(p) + 1);
+          }
 
-    PS_SM_ReadOptions();
+          for (Index = 0 ; Index < Header->RecordCount ; Index++)
+          {
+            Name  = p;
+            Value = Name + lstrlen(Name) + 1;
+            p     = Value + lstrlen(Value) + 1;
 
-    /* The expansion is done, delete useless environment variables */
-    SetEnvironmentVariable(_T("PLAINSTARTER_CMD_LINE"),  NULL);
-    SetEnvironmentVariable(_T("PLAINSTARTER_PROGNAME"),  NULL);
-    SetEnvironmentVariable(_T("PLAINSTARTER_DIRECTORY"), NULL);
-    SetEnvironmentVariable(_T("PLAINSTARTER_OPTIONS"),   NULL);
+            if (lstrcmp(Name, PS_CMD_LINE) == 0)
+            {
+              PS_SM_ProcessVariable(Name, Value, argc, argv);
+            }
+            else if (lstrcmp(Name, PS_GROUP_CMD_LINE) == 0)
+            {
+              PS_GroupAdd(Value);
+            }
+            else
+            {
+              PS_SM_SetVariable(Name, Value);
+            }
+          }
 
-    /* Run the process */
-    PS_LAST_EXEC_CODE = PS_RunProcess(PS_BufferOut);
-  }
-  else
-  {
-    /* Try to expand the references to environment variables (ie %PATH%) */
-    if (ExpandEnvironmentStrings(Value, PS_BufferOut, sizeof(PS_BufferOut)) != 0)
-    {
-      Value = PS_BufferOut;
-    }
-    else
-    {
-      PS_MessageAndExit(7, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
-    }
+          Replayed = TRUE;
+          PS_TRACE(_T("cache-replay"), NULL);
+        }
 
-    /* Set the environment variable */
-    if (SetEnvironmentVariable(Name, Value) == 0)
-    {
-      PS_MessageAndExit(8, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
+        if (Header != NULL)
+        {
+          UnmapViewOfFile(Header);
+        }
+        CloseHandle(Mapping);
+      }
     }
+
+    CloseHandle(Infile);
   }
+
+  return Replayed;
 }
 
-static void PS_ParseConfiguration (TCHAR  *Buffer,
-                                   TCHAR  *BinaryDirectory,
-                                   int     argc,
-                                   TCHAR **argv)
+static int PS_EffectiveMain (int argc, TCHAR **argv)
 {
-  TCHAR  VariableName[PS_MAX_LINE_LEN_BYTES];
-  TCHAR *VariableValue = PS_BufferIn;
-  TCHAR *p;
+  TCHAR *ModuleFilename   = NULL;
+  TCHAR *ConfigFilename   = NULL;
+  TCHAR *CacheFilename    = NULL;
+  TCHAR *ProgramDirectory = NULL;
+  DWORD  EmbeddedSize     = 0;
 
-  enum { STATE_ReadName, STATE_ReadValue, STATE_ReadComment, STATE_ReadN } ParserState;
-  unsigned int Index;
+  const BYTE                *Embedded;
+  WIN32_FILE_ATTRIBUTE_DATA  ConfigInfo;
 
-  int Flags = IS_TEXT_UNICODE_SIGNATURE | IS_TEXT_UNICODE_REVERSE_SIGNATURE;
+  PS_TraceInitialize();
 
-  /* Parse the Buffer */
-  ParserState = STATE_ReadName;
-  Index       = 0;
-  p           = Buffer;
+  PS_BENCH_BEGIN(PS_BENCH_TOTAL);
+  PS_BENCH_BEGIN(PS_BENCH_CONFIG_PROBE);
 
-  PS_SM_Initialize(BinaryDirectory);
+  PS_LAST_EXEC_CODE = EXIT_SUCCESS;
+
+  /* The configuration is searched relative to the executable, argv[0] can be
+   * a relative path or a name found in the PATH */
+  ModuleFilename = PS_ArenaModuleFilename();
 
-  /* Skip Unicode UTF-16 BOM */
-  if (IsTextUnicode(Buffer, 4, &Flags) > 0)
+  /* The embedded configuration is named after the executable */
+  Embedded = PS_FindEmbeddedConfiguration(&EmbeddedSize);
+  if (Embedded != NULL)
   {
-    p++;
+    ConfigFilename = (ModuleFilename != NULL) ? ModuleFilename : PS_ArenaCopy(_T(""));
   }
   else
   {
-    PS_MessageAndExit(9, _T("Expecting UTF-16 encoded configuration file."), EXIT_FAILURE);
+    ConfigFilename = PS_FindConfigFilename(((ModuleFilename != NULL) ? ModuleFilename : argv[0]), &ConfigInfo);
   }
 
-  while (*p)
+  PS_BENCH_END(PS_BENCH_CONFIG_PROBE);
+  PS_TRACE(_T("config-probe"), NULL);
+
+  if (ConfigFilename == NULL)
   {
-    if (*p == _T('#'))
-    {
-      ParserState = STATE_ReadComment;
-    }
+    PS_MessageAndExit(10, _T("Configuration file not found."), EXIT_FAILURE);
+  }
+  else
+  {
+    PS_EnvInheritParent();
 
-    /* Unexpected new line, skip silently */
-    if ((ParserState != STATE_ReadValue)
-        && (*p == _T('\r')))
+    /* Started by the option process-pool, the marker is not part of the
+     * environment of the pool */
+    if (PS_EnvGet(&PS_Environment, _T("PLAINSTARTER_BROKER"), 19) != NULL)
     {
-      ParserState = STATE_ReadN;
+      PS_PoolIsBroker = TRUE;
+      PS_EnvSetVariable(_T("PLAINSTARTER_BROKER"), NULL);
     }
 
-    if (Index > PS_MAX_LINE_LEN_BYTES)
-    {
-      ParserState = STATE_ReadN;
-    }
+    PS_ConfigFilename = ConfigFilename;
+    ProgramDirectory  = PS_LocateWin32BinaryDirectory(ModuleFilename);
+    PS_SM_Initialize(ProgramDirectory);
+    PS_TRACE(_T("locate-module"), NULL);
+
+    /* Nothing to save for an embedded configuration */
+    CacheFilename = (Embedded == NULL) ? PS_GetCacheFilename(ConfigFilename) : NULL;
 
-    switch (ParserState)
+    if ((CacheFilename == NULL)
+        || (PS_CacheReplay(CacheFilename, &ConfigInfo, argc, argv) == FALSE))
     {
-    case STATE_ReadComment:
-      if (*p == _T('\r'))
+      /* Only an existing cache file enables the recording, see
+       * CONFIGURATION CACHE */
+      if ((CacheFilename != NULL) && (PS_CacheExists == TRUE))
       {
-        ParserState = STATE_ReadN;
+        PS_CacheStartRecording(CacheFilename, &ConfigInfo);
       }
-      break;
 
-    case STATE_ReadName:
-      if (*p == _T('='))
+      PS_BENCH_BEGIN(PS_BENCH_PARSE);
+      if (Embedded != NULL)
       {
-        VariableName[Index] = _T('\0');
-        ParserState = STATE_ReadValue;
-        Index = 0;
+        PS_ParseEmbeddedConfiguration(Embedded, EmbeddedSize, argc, argv);
       }
-      else
+      else if (PS_ReadConfiguration(ConfigFilename, argc, argv) == FALSE)
       {
-        VariableName[Index] = *p;
-        Index++;
+        PS_MessageAndExit(10, _T("Configuration file not found."), EXIT_FAILURE);
       }
-      break;
+      PS_BENCH_END(PS_BENCH_PARSE);
+      PS_TRACE(_T("parse"), NULL);
 
-    case STATE_ReadValue:
-      if (*p == _T('\r'))
+      /* Update, request or delete the cache file */
+      if (PS_CacheRecording == TRUE)
       {
-        VariableValue[Index] = _T('\0');
-        ParserState = STATE_ReadN;
-        PS_SM_ProcessVariable(VariableName, VariableValue, argc, argv);
+        PS_CacheFlush();
       }
-      else
+      else if ((CacheFilename != NULL) && (PS_OPTION_CONFIG_CACHE == TRUE))
       {
-        VariableValue[Index] = *p;
-        Index++;
+        PS_CacheRequest(CacheFilename);
       }
-      break;
 
-    case STATE_ReadN:
-      if (*p == _T('\n'))
+      if ((PS_CacheExists == TRUE) && (PS_OPTION_CONFIG_CACHE == FALSE))
       {
-        ParserState = STATE_ReadName;
-        Index = 0;
+        DeleteFile(CacheFilename);
       }
-      break;
     }
 
-    /* process next character */
-    p++;
-  }
-}
-
-static int PS_EffectiveMain (int argc, TCHAR **argv)
-{
-  HANDLE HeapHandle       = GetProcessHeap();
-  TCHAR *Argv0            = argv[0];
-  TCHAR *ConfigFilename   = NULL;
-  TCHAR *ConfigData       = NULL;
-  TCHAR *ProgramDirectory = NULL;
-
-  PS_LAST_EXEC_CODE = EXIT_SUCCESS;
-  ConfigFilename = PS_GetConfigFilename(PS_CONFIG_DIR_1, PS_ARRAY_SIZE(PS_CONFIG_DIR_1), Argv0);
-  ConfigData     = PS_FileSlurp(ConfigFilename);
-
-  if (ConfigData == NULL)
-  {
-    HeapFree(HeapHandle, 0, ConfigFilename);
-    ConfigFilename = PS_GetConfigFilename(PS_CONFIG_DIR_2, PS_ARRAY_SIZE(PS_CONFIG_DIR_2), Argv0);
-    ConfigData     = PS_FileSlurp(ConfigFilename);
-  }
-
-  if (ConfigData == NULL)
-  {
-    HeapFree(HeapHandle, 0, ConfigFilename);
-    ConfigFilename = PS_GetConfigFilename(PS_CONFIG_DIR_3, PS_ARRAY_SIZE(PS_CONFIG_DIR_3), Argv0);
-    ConfigData     = PS_FileSlurp(ConfigFilename);
+    /* Launch group without PLAINSTARTER_CMD_LINE after it */
+    if ((PS_GroupCount > 0) && (PS_InstanceForwarded == FALSE))
+    {
+      PS_SM_DeleteSpecialVariables();
+      PS_LAST_EXEC_CODE = PS_RunProcess(NULL);
+    }
   }
 
-  if (ConfigData == NULL)
-  {
-    PS_MessageAndExit(10, _T("Configuration file not found."), EXIT_FAILURE);
-  }
-  else
-  {
-    ProgramDirectory = PS_LocateWin32BinaryDirectory(PS_BufferIn, sizeof(PS_BufferIn));
-    PS_ParseConfiguration(ConfigData, ProgramDirectory, argc, argv);
-    HeapFree(HeapHandle, 0, ProgramDirectory);
-    HeapFree(HeapHandle, 0, ConfigData);
-  }
+  PS_TRACE(_T("end"), NULL);
+  PS_TraceWrite(PS_LAST_EXEC_CODE, 0);
 
-  /* Free resources */
-  HeapFree(HeapHandle, 0, ConfigFilename);
+  PS_BENCH_END(PS_BENCH_TOTAL);
+  PS_BENCH_REPORT();
 
   return PS_LAST_EXEC_CODE;
 }
@@ -803,21 +5779,26 @@ static int PS_EffectiveMain (int argc, TCHAR **argv)
  * This can be checked with the following command:
  *   - gcc -dM -E src\plainstarter-win32.c > plainstarter-defines.h
  *
+ * PLAINSTARTER_NO_ENTRY_POINT is defined by the benchmark programs including
+ * this file in order to call the internal functions directly.
  */
-#ifdef PLAINSTARTER_CONSOLE
+#if defined(PLAINSTARTER_NO_ENTRY_POINT)
+/* No entry point */
+#elif defined(PLAINSTARTER_CONSOLE)
 int WINAPI mainCRTStartup (void)
-#elif PLAINSTARTER_WINDOWS
+#elif defined(PLAINSTARTER_WINDOWS)
   int WINAPI WinMainCRTStartup (void)
 #else
   int main (int argc, char **argv)
 #endif
+#if !defined(PLAINSTARTER_NO_ENTRY_POINT)
 {
 #if defined(PLAINSTARTER_CONSOLE) || defined(PLAINSTARTER_WINDOWS)
   int     ReturnCode;
   LPWSTR *ArgList;
   int     ArgCount;
 
-  ArgList = CommandLineToArgvW(GetCommandLineW(), &ArgCount);
+  ArgList = PS_SplitCommandLine(GetCommandLineW(), &ArgCount);
   if (ArgList == NULL)
   {
     PS_MessageAndExit(11, PS_UNEXPECTED_ERROR, EXIT_FAILURE);
@@ -825,7 +5806,7 @@ int WINAPI mainCRTStartup (void)
   else
   {
     ReturnCode = PS_EffectiveMain(ArgCount, ArgList);
-    LocalFree(ArgList);
+    HeapFree(GetProcessHeap(), 0, ArgList);
   }
 
   /* WIN32 API requires to return with ExitProcess instead of using 'return'
@@ -836,3 +5817,4 @@ int WINAPI mainCRTStartup (void)
   PS_EffectiveMain(argc, argv);
 #endif
 }
+#endif
@@ -0,0 +1,805 @@
+/**
+ *  +----------+---------------------------------------------------------------+
+ *  | Info     | Value                                                         |
+ *  +----------+---------------------------------------------------------------+
+ *  | Filename | plainstarter-embed.c                                          |
+ *  | Project  | plain-starter                                                 |
+ *  | License  | Simplified BSD License (details in attached LICENSE file)     |
+ *  +----------+---------------------------------------------------------------+
+ *  | Copyright (C) 2014-2022 Pascal COMBIER <pascal.combier@outlook.com>      |
+ *  +--------------------------------------------------------------------------+
+ *
+ * Post-link tool embedding a configuration file in an existing Plainstarter
+ * executable, as the resource RCDATA 1 read at startup instead of the .cfg
+ * file. Built natively on the build host (see makefile-posix):
+ *
+ *   plainstarter-embed my-app.exe my-app.cfg    embed or update
+ *   plainstarter-embed --remove my-app.exe      remove
+ *
+ * The configuration is copied unchanged, it is encoded like a configuration
+ * file. The resources of the executable (icon, manifest, version) are read,
+ * the configuration is added or replaced, and the whole resource tree is
+ * written in a new last section named .psrc. The original .rsrc section is
+ * kept but not referenced anymore. When the executable was already updated,
+ * its .psrc section is replaced, so that the file does not grow.
+ *
+ * Signed executables are refused: the signature would be invalid anyway.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*-----------*/
+/* CONSTANTS */
+/*-----------*/
+
+#define EMBED_RT_RCDATA   10
+#define EMBED_CONFIG_ID   1
+#define EMBED_SECTION     ".psrc"
+
+#define EMBED_DIR_RESOURCE 2
+#define EMBED_DIR_SECURITY 4
+
+/* IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ */
+#define EMBED_SECTION_FLAGS 0x40000040UL
+
+/* Levels of the resource tree: type, name, language */
+#define EMBED_LEVELS 3
+
+/*------------------*/
+/* TYPE DEFINITIONS */
+/*------------------*/
+
+/* Identifier of a resource directory entry: Id, or Name when Name is not
+ * NULL (UTF-16 LE, NameLength characters) */
+typedef struct {
+  unsigned long        Id;
+  const unsigned char *Name;
+  unsigned int         NameLength;
+} EMBED_KEY;
+
+/* Leaf of the resource tree */
+typedef struct {
+  EMBED_KEY            Keys[EMBED_LEVELS];
+  const unsigned char *Data;
+  unsigned long        Size;
+  unsigned long        CodePage;
+} EMBED_RESOURCE;
+
+typedef struct {
+  unsigned char *Data;
+  size_t         Size;
+  size_t         PeOffset;
+  size_t         OptionalOffset;
+  size_t         SectionOffset;
+  unsigned int   SectionCount;
+  int            Is64;
+} EMBED_IMAGE;
+
+/*-------------------*/
+/* UTILITY FUNCTIONS */
+/*-------------------*/
+
+static const char *EmbedProgram = "plainstarter-embed";
+
+static void EmbedFail (const char *Message)
+{
+  fprintf(stderr, "%s: %s\n", EmbedProgram, Message);
+  exit(EXIT_FAILURE);
+}
+
+static void *EmbedAlloc (size_t Size)
+{
+  void *p = calloc(1, (Size > 0) ? Size : 1);
+
+  if (p == NULL)
+  {
+    EmbedFail("out of memory");
+  }
+
+  return p;
+}
+
+/* The PE format is little-endian, whatever the host */
+static unsigned long EmbedRead16 (const unsigned char *p)
+{
+  return (unsigned long)p[0] | ((unsigned long)p[1] << 8);
+}
+
+static unsigned long EmbedRead32 (const unsigned char *p)
+{
+  return EmbedRead16(p) | (EmbedRead16(p + 2) << 16);
+}
+
+static void EmbedWrite16 (unsigned char *p, unsigned long Value)
+{
+  p[0] = (unsigned char)(Value & 0xFF);
+  p[1] = (unsigned char)((Value >> 8) & 0xFF);
+}
+
+static void EmbedWrite32 (unsigned char *p, unsigned long Value)
+{
+  EmbedWrite16(p, Value & 0xFFFF);
+  EmbedWrite16(p + 2, (Value >> 16) & 0xFFFF);
+}
+
+static unsigned long EmbedAlign (unsigned long Value, unsigned long Alignment)
+{
+  return (Value + Alignment - 1) & ~(Alignment - 1);
+}
+
+static unsigned char *EmbedReadFile (const char *Filename, size_t *Size)
+{
+  FILE          *File;
+  unsigned char *Data;
+  long           Length;
+
+  File = fopen(Filename, "rb");
+  if (File == NULL)
+  {
+    perror(Filename);
+    exit(EXIT_FAILURE);
+  }
+
+  if ((fseek(File, 0, SEEK_END) != 0) || ((Length = ftell(File)) < 0) || (fseek(File, 0, SEEK_SET) != 0))
+  {
+    EmbedFail("cannot read the file size");
+  }
+
+  Data = EmbedAlloc((size_t)Length);
+  if (fread(Data, 1, (size_t)Length, File) != (size_t)Length)
+  {
+    EmbedFail("cannot read the file");
+  }
+  fclose(File);
+
+  *Size = (size_t)Length;
+
+  return Data;
+}
+
+/*-------------*/
+/* IMAGE INPUT */
+/*-------------*/
+
+static unsigned char *EmbedSection (const EMBED_IMAGE *Image, unsigned int Index)
+{
+  return Image->Data + Image->SectionOffset + (Index * 40);
+}
+
+static size_t EmbedDirectoryOffset (const EMBED_IMAGE *Image, unsigned int Index)
+{
+  size_t Directories = Image->OptionalOffset + (Image->Is64 ? 112 : 96);
+  size_t Count       = EmbedRead32(Image->Data + Image->OptionalOffset + (Image->Is64 ? 108 : 92));
+
+  if (Index >= Count)
+  {
+    EmbedFail("the executable has no resource directory entry");
+  }
+
+  return Directories + (Index * 8);
+}
+
+static void EmbedParseImage (EMBED_IMAGE *Image)
+{
+  const unsigned char *p = Image->Data;
+  unsigned long        Magic;
+
+  if ((Image->Size < 0x40) || (p[0] != 'M') || (p[1] != 'Z'))
+  {
+    EmbedFail("not an executable");
+  }
+
+  Image->PeOffset = EmbedRead32(p + 0x3C);
+  if ((Image->PeOffset + 24 > Image->Size) || (memcmp(p + Image->PeOffset, "PE\0\0", 4) != 0))
+  {
+    EmbedFail("not a PE executable");
+  }
+
+  Image->SectionCount   = (unsigned int)EmbedRead16(p + Image->PeOffset + 6);
+  Image->OptionalOffset = Image->PeOffset + 24;
+  Image->SectionOffset  = Image->OptionalOffset + EmbedRead16(p + Image->PeOffset + 20);
+
+  Magic = EmbedRead16(p + Image->OptionalOffset);
+  if ((Magic != 0x10B) && (Magic != 0x20B))
+  {
+    EmbedFail("unknown optional header");
+  }
+  Image->Is64 = (Magic == 0x20B);
+
+  if ((Image->SectionOffset + (Image->SectionCount * 40)) > Image->Size)
+  {
+    EmbedFail("truncated section table");
+  }
+}
+
+/* Return the file offset of Size bytes at the address Rva */
+static size_t EmbedRvaToOffset (const EMBED_IMAGE *Image, unsigned long Rva, unsigned long Size)
+{
+  const unsigned char *Section;
+  unsigned long        Address;
+  unsigned long        RawSize;
+  unsigned int         Index;
+
+  for (Index = 0 ; Index < Image->SectionCount ; Index++)
+  {
+    Section = EmbedSection(Image, Index);
+    Address = EmbedRead32(Section + 12);
+    RawSize = EmbedRead32(Section + 16);
+
+    if ((Rva >= Address) && ((Rva - Address) + Size <= RawSize))
+    {
+      if ((EmbedRead32(Section + 20) + (Rva - Address) + Size) > Image->Size)
+      {
+        break;
+      }
+      return EmbedRead32(Section + 20) + (Rva - Address);
+    }
+  }
+
+  EmbedFail("invalid resource address");
+
+  return 0;
+}
+
+/*-----------------*/
+/* RESOURCE INPUT  */
+/*-----------------*/
+
+typedef struct {
+  EMBED_RESOURCE *Items;
+  size_t          Count;
+  size_t          Capacity;
+} EMBED_LIST;
+
+static void EmbedAdd (EMBED_LIST *List, const EMBED_RESOURCE *Resource)
+{
+  if (List->Count == List->Capacity)
+  {
+    List->Capacity = (List->Capacity == 0) ? 16 : (List->Capacity * 2);
+    List->Items    = realloc(List->Items, List->Capacity * sizeof(EMBED_RESOURCE));
+    if (List->Items == NULL)
+    {
+      EmbedFail("out of memory");
+    }
+  }
+
+  List->Items[List->Count++] = *Resource;
+}
+
+/* Collect the leaves of the directory at Offset of the resource section */
+static void EmbedReadDirectory (const EMBED_IMAGE *Image,
+                                size_t             Base,
+                                unsigned long      BaseSize,
+                                unsigned long      Offset,
+                                int                Level,
+                                EMBED_RESOURCE    *Current,
+                                EMBED_LIST        *List)
+{
+  const unsigned char *Directory;
+  const unsigned char *Entry;
+  const unsigned char *Data;
+  unsigned long        Count;
+  unsigned long        Index;
+  unsigned long        Name;
+  unsigned long        Target;
+
+  if ((Level >= EMBED_LEVELS) || (Offset + 16 > BaseSize))
+  {
+    EmbedFail("invalid resource directory");
+  }
+
+  Directory = Image->Data + Base + Offset;
+  Count     = EmbedRead16(Directory + 12) + EmbedRead16(Directory + 14);
+  if (Offset + 16 + (Count * 8) > BaseSize)
+  {
+    EmbedFail("invalid resource directory");
+  }
+
+  for (Index = 0 ; Index < Count ; Index++)
+  {
+    Entry  = Directory + 16 + (Index * 8);
+    Name   = EmbedRead32(Entry);
+    Target = EmbedRead32(Entry + 4);
+
+    if (Name & 0x80000000UL)
+    {
+      Name &= 0x7FFFFFFFUL;
+      if (Name + 2 > BaseSize)
+      {
+        EmbedFail("invalid resource name");
+      }
+      Current->Keys[Level].Name       = Image->Data + Base + Name + 2;
+      Current->Keys[Level].NameLength = (unsigned int)EmbedRead16(Image->Data + Base + Name);
+      Current->Keys[Level].Id         = 0;
+      if (Name + 2 + (Current->Keys[Level].NameLength * 2) > BaseSize)
+      {
+        EmbedFail("invalid resource name");
+      }
+    }
+    else
+    {
+      Current->Keys[Level].Name       = NULL;
+      Current->Keys[Level].NameLength = 0;
+      Current->Keys[Level].Id         = Name;
+    }
+
+    if (Target & 0x80000000UL)
+    {
+      EmbedReadDirectory(Image, Base, BaseSize, (Target & 0x7FFFFFFFUL), (Level + 1), Current, List);
+    }
+    else if (Level == (EMBED_LEVELS - 1))
+    {
+      if (Target + 16 > BaseSize)
+      {
+        EmbedFail("invalid resource data entry");
+      }
+      Data              = Image->Data + Base + Target;
+      Current->Size     = EmbedRead32(Data + 4);
+      Current->CodePage = EmbedRead32(Data + 8);
+      Current->Data     = Image->Data + EmbedRvaToOffset(Image, EmbedRead32(Data), Current->Size);
+      EmbedAdd(List, Current);
+    }
+    else
+    {
+      EmbedFail("unexpected resource data entry");
+    }
+  }
+}
+
+static void EmbedReadResources (const EMBED_IMAGE *Image, EMBED_LIST *List)
+{
+  size_t          Directory = EmbedDirectoryOffset(Image, EMBED_DIR_RESOURCE);
+  unsigned long   Rva       = EmbedRead32(Image->Data + Directory);
+  unsigned long   Size      = EmbedRead32(Image->Data + Directory + 4);
+  EMBED_RESOURCE  Current;
+
+  /* No resources at all */
+  if ((Rva == 0) || (Size == 0))
+  {
+    return;
+  }
+
+  memset(&Current, 0, sizeof(Current));
+  EmbedReadDirectory(Image, EmbedRvaToOffset(Image, Rva, Size), Size, 0, 0, &Current, List);
+}
+
+/*-----------------*/
+/* RESOURCE OUTPUT */
+/*-----------------*/
+
+/* Named entries first, ordered by name, then the identifiers in ascending
+ * order, as expected by the resource lookup of Windows */
+static int EmbedCompareKey (const EMBED_KEY *a, const EMBED_KEY *b)
+{
+  unsigned int Index;
+  unsigned long ca;
+  unsigned long cb;
+
+  if ((a->Name != NULL) != (b->Name != NULL))
+  {
+    return (a->Name != NULL) ? -1 : 1;
+  }
+
+  if (a->Name == NULL)
+  {
+    return (a->Id < b->Id) ? -1 : ((a->Id > b->Id) ? 1 : 0);
+  }
+
+  for (Index = 0 ; (Index < a->NameLength) && (Index < b->NameLength) ; Index++)
+  {
+    ca = EmbedRead16(a->Name + (Index * 2));
+    cb = EmbedRead16(b->Name + (Index * 2));
+    if (ca != cb)
+    {
+      return (ca < cb) ? -1 : 1;
+    }
+  }
+
+  return (a->NameLength < b->NameLength) ? -1 : ((a->NameLength > b->NameLength) ? 1 : 0);
+}
+
+static int EmbedCompareResource (const void *a, const void *b)
+{
+  const EMBED_RESOURCE *ra = a;
+  const EMBED_RESOURCE *rb = b;
+  int                   Level;
+  int                   Result = 0;
+
+  for (Level = 0 ; (Level < EMBED_LEVELS) && (Result == 0) ; Level++)
+  {
+    Result = EmbedCompareKey(&ra->Keys[Level], &rb->Keys[Level]);
+  }
+
+  return Result;
+}
+
+/* Sizes of the parts of the section: the directories and their entries, the
+ * names, the data entries and the data */
+typedef struct {
+  unsigned long Directories;
+  unsigned long Names;
+  unsigned long DataEntries;
+  unsigned long Data;
+} EMBED_LAYOUT;
+
+typedef struct {
+  unsigned char *Out;
+  unsigned long  Rva;
+  unsigned long  Directory;   /* Next free directory offset  */
+  unsigned long  Name;        /* Next free name offset       */
+  unsigned long  DataEntry;   /* Next free data entry offset */
+  unsigned long  Data;        /* Next free data offset       */
+} EMBED_WRITER;
+
+/* Number of distinct keys at Level among the sorted Items sharing the keys
+ * of the previous levels */
+static size_t EmbedCountKeys (const EMBED_RESOURCE *Items, size_t Count, int Level)
+{
+  size_t Keys = 0;
+  size_t Index;
+
+  for (Index = 0 ; Index < Count ; Index++)
+  {
+    if ((Index == 0) || (EmbedCompareKey(&Items[Index - 1].Keys[Level], &Items[Index].Keys[Level]) != 0))
+    {
+      Keys++;
+    }
+  }
+
+  return Keys;
+}
+
+static void EmbedMeasure (const EMBED_RESOURCE *Items, size_t Count, int Level, EMBED_LAYOUT *Layout)
+{
+  size_t Start = 0;
+  size_t End;
+
+  Layout->Directories += 16 + (unsigned long)(EmbedCountKeys(Items, Count, Level) * 8);
+
+  while (Start < Count)
+  {
+    End = Start + 1;
+    while ((End < Count) && (EmbedCompareKey(&Items[Start].Keys[Level], &Items[End].Keys[Level]) == 0))
+    {
+      End++;
+    }
+
+    if (Items[Start].Keys[Level].Name != NULL)
+    {
+      Layout->Names += 2 + (Items[Start].Keys[Level].NameLength * 2);
+    }
+
+    if (Level < (EMBED_LEVELS - 1))
+    {
+      EmbedMeasure((Items + Start), (End - Start), (Level + 1), Layout);
+    }
+    else
+    {
+      /* Duplicated keys are removed before */
+      Layout->DataEntries += 16;
+      Layout->Data        += EmbedAlign(Items[Start].Size, 8);
+    }
+
+    Start = End;
+  }
+}
+
+static unsigned long EmbedWriteDirectory (EMBED_WRITER         *Writer,
+                                          const EMBED_RESOURCE *Items,
+                                          size_t                Count,
+                                          int                   Level)
+{
+  unsigned long  Offset = Writer->Directory;
+  unsigned char *Directory = Writer->Out + Offset;
+  unsigned char *Entry;
+  unsigned char *DataEntry;
+  unsigned long  NamedCount = 0;
+  unsigned long  IdCount    = 0;
+  size_t         Keys  = EmbedCountKeys(Items, Count, Level);
+  size_t         Start = 0;
+  size_t         End;
+
+  Writer->Directory += 16 + (unsigned long)(Keys * 8);
+  Entry = Directory + 16;
+
+  while (Start < Count)
+  {
+    End = Start + 1;
+    while ((End < Count) && (EmbedCompareKey(&Items[Start].Keys[Level], &Items[End].Keys[Level]) == 0))
+    {
+      End++;
+    }
+
+    if (Items[Start].Keys[Level].Name != NULL)
+    {
+      EmbedWrite32(Entry, (Writer->Name | 0x80000000UL));
+      EmbedWrite16(Writer->Out + Writer->Name, Items[Start].Keys[Level].NameLength);
+      memcpy(Writer->Out + Writer->Name + 2, Items[Start].Keys[Level].Name, Items[Start].Keys[Level].NameLength * 2);
+      Writer->Name += 2 + (Items[Start].Keys[Level].NameLength * 2);
+      NamedCount++;
+    }
+    else
+    {
+      EmbedWrite32(Entry, Items[Start].Keys[Level].Id);
+      IdCount++;
+    }
+
+    if (Level < (EMBED_LEVELS - 1))
+    {
+      EmbedWrite32(Entry + 4, (EmbedWriteDirectory(Writer, (Items + Start), (End - Start), (Level + 1)) | 0x80000000UL));
+    }
+    else
+    {
+      DataEntry = Writer->Out + Writer->DataEntry;
+      EmbedWrite32(Entry + 4, Writer->DataEntry);
+      EmbedWrite32(DataEntry,     (Writer->Rva + Writer->Data));
+      EmbedWrite32(DataEntry + 4, Items[Start].Size);
+      EmbedWrite32(DataEntry + 8, Items[Start].CodePage);
+      memcpy(Writer->Out + Writer->Data, Items[Start].Data, Items[Start].Size);
+      Writer->DataEntry += 16;
+      Writer->Data      += EmbedAlign(Items[Start].Size, 8);
+    }
+
+    Entry += 8;
+    Start  = End;
+  }
+
+  EmbedWrite16(Directory + 12, NamedCount);
+  EmbedWrite16(Directory + 14, IdCount);
+
+  return Offset;
+}
+
+/* Serialize the resources for a section at the address Rva */
+static unsigned char *EmbedBuildSection (EMBED_LIST *List, unsigned long Rva, unsigned long *Size)
+{
+  EMBED_LAYOUT  Layout;
+  EMBED_WRITER  Writer;
+
+  memset(&Layout, 0, sizeof(Layout));
+  qsort(List->Items, List->Count, sizeof(EMBED_RESOURCE), EmbedCompareResource);
+
+  if (List->Count > 0)
+  {
+    EmbedMeasure(List->Items, List->Count, 0, &Layout);
+  }
+  else
+  {
+    Layout.Directories = 16;
+  }
+
+  Writer.Rva       = Rva;
+  Writer.Directory = 0;
+  Writer.Name      = Layout.Directories;
+  Writer.DataEntry = EmbedAlign(Writer.Name + Layout.Names, 8);
+  Writer.Data      = Writer.DataEntry + Layout.DataEntries;
+  *Size            = Writer.Data + Layout.Data;
+  Writer.Out       = EmbedAlloc(*Size);
+
+  if (List->Count > 0)
+  {
+    EmbedWriteDirectory(&Writer, List->Items, List->Count, 0);
+  }
+
+  return Writer.Out;
+}
+
+/*--------------*/
+/* IMAGE OUTPUT */
+/*--------------*/
+
+/* Checksum of the optional header, computed like CheckSumMappedFile */
+static unsigned long EmbedChecksum (const unsigned char *Data, size_t Size, size_t ChecksumOffset)
+{
+  unsigned long long Sum = 0;
+  size_t             Index;
+
+  for (Index = 0 ; Index < Size ; Index += 2)
+  {
+    if ((Index == ChecksumOffset) || (Index == ChecksumOffset + 2))
+    {
+      continue;
+    }
+    Sum += (Index + 1 < Size) ? EmbedRead16(Data + Index) : Data[Index];
+    Sum  = (Sum & 0xFFFF) + (Sum >> 16);
+  }
+  Sum = (Sum & 0xFFFF) + (Sum >> 16);
+
+  return (unsigned long)(Sum + Size);
+}
+
+static void EmbedWriteImage (const char    *Filename,
+                             EMBED_IMAGE   *Image,
+                             EMBED_LIST    *List)
+{
+  unsigned char *Section;
+  unsigned char *Last;
+  unsigned char *Resources;
+  unsigned char *Out;
+  FILE          *File;
+  size_t         Optional      = Image->OptionalOffset;
+  unsigned long  FileAlignment = EmbedRead32(Image->Data + Optional + 36);
+  unsigned long  SectionAlign  = EmbedRead32(Image->Data + Optional + 32);
+  unsigned long  InitData      = EmbedRead32(Image->Data + Optional + 8);
+  unsigned long  ImageEnd      = 0;
+  unsigned long  RawEnd        = 0;
+  unsigned long  FirstRaw      = 0xFFFFFFFFUL;
+  unsigned long  Rva;
+  unsigned long  RawOffset;
+  unsigned long  ResourceSize;
+  unsigned long  RawSize;
+  unsigned long  Value;
+  unsigned int   Index;
+  size_t         OutSize;
+
+  /* Replace the section of a previous update, necessarily the last one */
+  if (Image->SectionCount > 0)
+  {
+    Last = EmbedSection(Image, Image->SectionCount - 1);
+    if (strncmp((const char *)Last, EMBED_SECTION, 8) == 0)
+    {
+      InitData -= EmbedRead32(Last + 16);
+      Image->SectionCount--;
+    }
+  }
+
+  for (Index = 0 ; Index < Image->SectionCount ; Index++)
+  {
+    Section = EmbedSection(Image, Index);
+
+    Value = EmbedRead32(Section + 8);
+    if (Value == 0)
+    {
+      Value = EmbedRead32(Section + 16);
+    }
+    if (EmbedRead32(Section + 12) + Value > ImageEnd)
+    {
+      ImageEnd = EmbedRead32(Section + 12) + Value;
+    }
+
+    if (EmbedRead32(Section + 16) > 0)
+    {
+      if (EmbedRead32(Section + 20) + EmbedRead32(Section + 16) > RawEnd)
+      {
+        RawEnd = EmbedRead32(Section + 20) + EmbedRead32(Section + 16);
+      }
+      if (EmbedRead32(Section + 20) < FirstRaw)
+      {
+        FirstRaw = EmbedRead32(Section + 20);
+      }
+    }
+  }
+
+  /* Room for one more section header before the first section */
+  if ((Image->SectionOffset + ((Image->SectionCount + 1) * 40) > EmbedRead32(Image->Data + Optional + 60))
+      || (Image->SectionOffset + ((Image->SectionCount + 1) * 40) > FirstRaw))
+  {
+    EmbedFail("no room for a new section header");
+  }
+
+  /* Data appended after the sections, ie debug information, is kept */
+  if (RawEnd > Image->Size)
+  {
+    EmbedFail("truncated executable");
+  }
+
+  Rva       = EmbedAlign(ImageEnd, SectionAlign);
+  RawOffset = EmbedAlign((unsigned long)Image->Size, FileAlignment);
+  if (Image->SectionCount < EmbedRead16(Image->Data + Image->PeOffset + 6))
+  {
+    /* The previous .psrc section is overwritten */
+    RawOffset = EmbedRead32(EmbedSection(Image, Image->SectionCount) + 20);
+  }
+
+  Resources = EmbedBuildSection(List, Rva, &ResourceSize);
+  RawSize   = EmbedAlign(ResourceSize, FileAlignment);
+
+  OutSize = RawOffset + RawSize;
+  Out     = EmbedAlloc(OutSize);
+  memcpy(Out, Image->Data, (RawOffset < Image->Size) ? RawOffset : Image->Size);
+  memcpy(Out + RawOffset, Resources, ResourceSize);
+
+  /* Section header */
+  Section = Out + Image->SectionOffset + (Image->SectionCount * 40);
+  memset(Section, 0, 40);
+  memcpy(Section, EMBED_SECTION, strlen(EMBED_SECTION));
+  EmbedWrite32(Section + 8,  ResourceSize);
+  EmbedWrite32(Section + 12, Rva);
+  EmbedWrite32(Section + 16, RawSize);
+  EmbedWrite32(Section + 20, RawOffset);
+  EmbedWrite32(Section + 36, EMBED_SECTION_FLAGS);
+
+  /* Headers */
+  EmbedWrite16(Out + Image->PeOffset + 6, Image->SectionCount + 1);
+  EmbedWrite32(Out + Optional + 8,  InitData + RawSize);
+  EmbedWrite32(Out + Optional + 56, EmbedAlign(Rva + ResourceSize, SectionAlign));
+  EmbedWrite32(Out + EmbedDirectoryOffset(Image, EMBED_DIR_RESOURCE),     Rva);
+  EmbedWrite32(Out + EmbedDirectoryOffset(Image, EMBED_DIR_RESOURCE) + 4, ResourceSize);
+  EmbedWrite32(Out + Optional + 64, 0);
+  EmbedWrite32(Out + Optional + 64, EmbedChecksum(Out, OutSize, Optional + 64));
+
+  File = fopen(Filename, "wb");
+  if ((File == NULL)
+      || (fwrite(Out, 1, OutSize, File) != OutSize)
+      || (fclose(File) != 0))
+  {
+    perror(Filename);
+    exit(EXIT_FAILURE);
+  }
+
+  free(Resources);
+  free(Out);
+}
+
+/*---------------*/
+/* MAIN FUNCTION */
+/*---------------*/
+
+int main (int argc, char **argv)
+{
+  EMBED_IMAGE     Image;
+  EMBED_LIST      List;
+  EMBED_RESOURCE  Config;
+  unsigned char  *ConfigData = NULL;
+  size_t          ConfigSize = 0;
+  size_t          Index;
+  size_t          Kept;
+  int             Remove;
+
+  Remove = (argc == 3) && (strcmp(argv[1], "--remove") == 0);
+  if ((argc != 3) || ((Remove == 0) && (argv[1][0] == '-')))
+  {
+    fprintf(stderr, "usage: %s <executable> <configuration>\n", EmbedProgram);
+    fprintf(stderr, "       %s --remove <executable>\n", EmbedProgram);
+    return EXIT_FAILURE;
+  }
+
+  memset(&Image, 0, sizeof(Image));
+  memset(&List, 0, sizeof(List));
+
+  Image.Data = EmbedReadFile(argv[Remove ? 2 : 1], &Image.Size);
+  EmbedParseImage(&Image);
+
+  if (EmbedRead32(Image.Data + EmbedDirectoryOffset(&Image, EMBED_DIR_SECURITY) + 4) != 0)
+  {
+    EmbedFail("the executable is signed, embed the configuration before signing");
+  }
+
+  EmbedReadResources(&Image, &List);
+
+  /* Remove the previous configuration, in any language */
+  Kept = 0;
+  for (Index = 0 ; Index < List.Count ; Index++)
+  {
+    if ((List.Items[Index].Keys[0].Name == NULL) && (List.Items[Index].Keys[0].Id == EMBED_RT_RCDATA)
+        && (List.Items[Index].Keys[1].Name == NULL) && (List.Items[Index].Keys[1].Id == EMBED_CONFIG_ID))
+    {
+      continue;
+    }
+    List.Items[Kept++] = List.Items[Index];
+  }
+  List.Count = Kept;
+
+  if (Remove == 0)
+  {
+    ConfigData = EmbedReadFile(argv[2], &ConfigSize);
+
+    memset(&Config, 0, sizeof(Config));
+    Config.Keys[0].Id = EMBED_RT_RCDATA;
+    Config.Keys[1].Id = EMBED_CONFIG_ID;
+    Config.Keys[2].Id = 0;              /* LANG_NEUTRAL */
+    Config.Data       = ConfigData;
+    Config.Size       = (unsigned long)ConfigSize;
+    EmbedAdd(&List, &Config);
+  }
+
+  EmbedWriteImage(argv[Remove ? 2 : 1], &Image, &List);
+
+  free(ConfigData);
+  free(List.Items);
+  free(Image.Data);
+
+  return EXIT_SUCCESS;
+}